@@ -16,6 +16,32 @@
 --
 ------------------------------------------------------------------------
 
+-- node builder options, shared by all the map build panels
+
+local FAST_NODES_OPTION =
+{
+  name = "bool_fast_nodes",
+  label = _("Fast Nodes"),
+  valuator = "button",
+  default = 0,
+  tooltip = "Split along the level's chunk grid before searching for node lines.",
+  longtip = "The node builder will use the boundaries of the generator's chunk grid as the top partition lines " ..
+  "of the BSP tree, and only search for the best partition line once it is working inside a single chunk." ..
+  "\n\nThis can make node building much faster on large maps."
+}
+
+local NODE_CACHE_OPTION =
+{
+  name = "bool_node_cache",
+  label = _("Cache Nodes"),
+  valuator = "button",
+  default = 0,
+  tooltip = "Reuse nodes from earlier builds of identical maps.",
+  longtip = "Built maps are kept in the cache folder of the Obsidian home directory, keyed on their " ..
+  "geometry and node builder settings. Rebuilding the same seed and settings skips node building entirely." ..
+  "\n\nThe cache is limited to 256 MB; the least recently used maps are removed first."
+}
+
 UI_REJECT_OPTIONS = { }
 
 function UI_REJECT_OPTIONS.setup(self)
@@ -109,7 +135,9 @@ OB_MODULES["ui_reject_options"] =
       tooltip = "Choose to build a proper REJECT lump.",
       longtip = "If this option is not selected, a blank REJECT lump with the proper size will be inserted into the map instead." ..
       "\n\nThis is to prevent errors with some engines that are expecting a \"full\" REJECT lump to be present."
-    }
+    },
+    FAST_NODES_OPTION,
+    NODE_CACHE_OPTION
   }
 }
 
@@ -207,7 +235,9 @@ OB_MODULES["ui_edge_map_options"] =
       "upon loading the map.",
       longtip = "Warning! If GL v5 nodes are needed due to map size/complexity, it is best to leave this unchecked as ZDBSP currently " ..
       "creates v5 nodes that are out of spec and will likely crash EDGE."
-    }
+    },
+    FAST_NODES_OPTION,
+    NODE_CACHE_OPTION
   }
 }
 
@@ -319,6 +349,8 @@ OB_MODULES["ui_udmf_map_options"] =
       choices = UI_UDMF_MAP_OPTIONS.MAP_FORMAT_CHOICES,
       default = "udmf",
       tooltip = "Choose between UDMF and binary map format.",
-    }
+    },
+    FAST_NODES_OPTION,
+    NODE_CACHE_OPTION
   }
 }
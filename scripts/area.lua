@@ -284,8 +284,8 @@ function AREA_CLASS.kill_it(A, remove_from_room)
   A.chunk = nil
 
   for _,S in pairs(A.seeds) do
-    S.area = nil
-    S.room = nil
+    S:set_area(nil)
+    S:set_room(nil)
   end
 end
 
@@ -2667,7 +2667,7 @@ function Area_divvy_up_borders()
 
       -- install into seeds
       for _,S in pairs(A.seeds) do
-        S.area = A
+        S:set_area(A)
         S.temp_area = nil
       end
     end
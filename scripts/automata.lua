@@ -248,93 +248,16 @@ function GRID_CLASS.generate_cave(grid, solid_prob)
   -- A new grid is returned, the elements can be: nil, -1 or +1.
   --
 
-  solid_prob = solid_prob or 40
-
-  local W = grid.w
-  local H = grid.h
-
-  -- these arrays only use 0 and 1 as values
-  local work = grid:blank_copy()
-  local temp = grid:blank_copy()
-
-  -- populate initial map
-  for x = 1, W do
-  for y = 1, H do
-    if not grid[x][y] or grid[x][y] < 0 then
-      work[x][y] = 0
-    elseif grid[x][y] > 0 then
-      work[x][y] = 1
-    else
-      work[x][y] = rand.sel(solid_prob, 1, 0)
-    end
-  end
-  end
-
-
-  local function calc_new(x, y, loop)
-    if not grid[x][y] then return 0 end
-
-    if grid[x][y] > 0 then return 1 end
-    if grid[x][y] < 0 then return 0 end
-
-    if x == 1 or x == W or y == 1 or y == H then
-      return work[x][y]
-    end
-
-    local neighbors = 0
-    for nx = x-1,x+1 do
-    for ny = y-1,y+1 do
-      neighbors = neighbors + work[nx][ny]
-    end
-    end
-
-    if neighbors >= 5 then return 1 end
-
-    if loop >= 5 then return 0 end
-
-    if x <= 2 or x >= W-1 or y <= 2 or y >= H-1 then return 0 end
-
-    -- check larger area
-    local neighbors = 0
-    for nx = x-2,x+2 do
-    for ny = y-2,y+2 do
-      if math.abs(x-nx) == 2 and math.abs(y-ny) == 2 then
-        -- skip the corners of the 5x5 block
-      else
-        neighbors = neighbors + work[nx][ny]
-      end
-    end
-    end
-
-    if neighbors <= 2 then return 1 end
-
-    return 0
-  end
+  -- The automation is done natively (m_grid.cc), and uses the same
+  -- random numbers as the old Lua code.
 
+  solid_prob = solid_prob or 40
 
-  -- perform the cellular automation steps
-  for loop = 1,7 do
-    for x = 1, W do
-    for y = 1, H do
-      temp[x][y] = calc_new(x, y, loop)
-    end
-    end
+  local result = grid:blank_copy()
 
-    work, temp = temp, work
-  end
+  gui.grid_generate_cave(grid, result, solid_prob)
 
-  -- convert values for the result
-  for x = 1, W do
-  for y = 1, H do
-    if grid[x][y] == 0 then
-      work[x][y] = sel(work[x][y] > 0, 1, -1)
-    else
-      work[x][y] = grid[x][y]
-    end
-  end
-  end
-
-  return work
+  return result
 end
 
 
@@ -406,108 +329,9 @@ function GRID_CLASS.flood_fill(grid)
   -- This also creates the 'regions' table.
   --
 
-  local W = grid.w
-  local H = grid.h
-
-  local flood = table.array_2D(W, H)
-
-  local cur_solid =  1
-  local cur_empty = -1
-
-  local next_points = {}
-
-
-  local function flood_point(x, y)
-    -- spread value from this cell to neighbors
+  local flood = table.array_2D(grid.w, grid.h)
 
-    local A = flood[x][y]
-    assert(A)
-
-    for dir = 2,8,2 do
-      local nx, ny = geom.nudge(x, y, dir)
-      if nx >= 1 and nx <= W and ny >= 1 and ny <= H then
-        local B = flood[nx][ny]
-
-        if B and ((A > 0 and A < B) or (A < 0 and A > B)) then
-          flood[nx][ny] = A
-          table.insert(next_points, { x=nx, y=ny })
-        end
-      end
-    end
-  end
-
-
-  local function update_info(x, y)
-    local id = flood[x][y]
-
-    if not id then return end
-
-    assert(id ~= 0)
-
-    local REG = grid.regions[id]
-
-    if not REG then
-      REG =
-      {
-        id = id,
-        cx1 = x, cy1 = y,
-        cx2 = x, cy2 = y,
-        size = 0,
-      }
-
-      grid.regions[id] = REG
-    end
-
-    if x < REG.cx1 then REG.cx1 = x end
-    if y < REG.cy1 then REG.cy1 = y end
-    if x > REG.cx2 then REG.cx2 = x end
-    if y > REG.cy2 then REG.cy2 = y end
-
-    REG.size = REG.size + 1
-  end
-
-
-  -- initial setup
-
-  for x = 1, W do
-  for y = 1, H do
-    if not grid[x][y] then
-      -- ignore it
-    elseif grid[x][y] < 0 then
-      flood[x][y] = cur_empty ; cur_empty = cur_empty - 1
-    else
-      flood[x][y] = cur_solid ; cur_solid = cur_solid + 1
-    end
-  end
-  end
-
-  -- perform the flood-fill
-
-  for x = 1, W do
-  for y = 1, H do
-    if flood[x][y] then
-      flood_point(x, y)
-    end
-  end
-  end
-
-  while #next_points > 0 do
-    local np_list = next_points ; next_points = {}
-
-    for _,P in pairs(np_list) do
-      flood_point(P.x, P.y)
-    end
-  end
-
-  -- create information for each region
-
-  grid.regions = {}
-
-  for x = 1, W do
-  for y = 1, H do
-    update_info(x, y)
-  end
-  end
+  grid.regions = gui.grid_flood_fill(grid, flood)
 
   grid.flood = flood
 end
@@ -602,58 +426,15 @@ function GRID_CLASS.find_islands(grid)
 
   local islands = {}
 
-  local W = grid.w
-  local H = grid.h
-
-  local flood = grid.flood
-
-  -- scan the cave, determine which regions are islands --
-
-  -- a table mapping region ids to a string value: "maybe" if could be
-  -- an island, and "no" when definitely not an island.
-  local potentials = {}
-
-  for x = 1, W do
-  for y = 1, H do
-    local reg = flood[x][y]
-    if (reg or 0) > 0 then
-
-      if not potentials[reg] then
-        potentials[reg] = "maybe"
-      end
-
-      if x == 1 or x == W or y == 1 or y == H then
-        potentials[reg] = "no"
-      end
-
-      if potentials[reg] ~= "no" then
-        for dir = 2,8,2 do
-          local nx, ny = geom.nudge(x, y, dir)
-
-          if grid:valid(nx, ny) and flood[nx][ny] == nil then
-            potentials[reg] = "no"
-            break;
-          end
-        end
-      end
-
-    end
-  end -- x, y
-  end
-
-  -- create the grids --
-
-  for reg, pot in pairs(potentials) do
-    if pot == "maybe" then
-      local island = grid:copy_region(reg)
+  for _,reg in ipairs(gui.grid_find_islands(grid.flood)) do
+    local island = grid:copy_region(reg)
 
-      table.insert(list, island)
+    table.insert(islands, island)
 
-      -- island:dump("Island for " .. tostring(reg))
-    end
+    -- island:dump("Island for " .. tostring(reg))
   end
 
-  return list
+  return islands
 end
 
 
@@ -661,41 +442,9 @@ function GRID_CLASS.grow(grid, keep_edges)
   -- grow the cave : it will have more solids, less empties.
   -- nil cells are not affected.
 
-  local W = grid.w
-  local H = grid.h
-
-  local work = table.array_2D(W, H)
+  local work = table.array_2D(grid.w, grid.h)
 
-
-  local function value_for_spot(x, y)
-    local val = grid[x][y]
-    local hit_edge
-
-    for dir = 2,8,2 do
-      local nx, ny = geom.nudge(x, y, dir)
-
-      if not grid:valid(nx, ny) or not grid[nx][ny] then
-        hit_edge = true
-      elseif grid[nx][ny] > 0 then
-        val = grid[nx][ny]
-      end
-    end
-
-    if keep_edges and hit_edge then
-      return grid[x][y]
-    end
-
-    return val
-  end
-
-  -- compute the new cells
-  for x = 1, W do
-  for y = 1, H do
-    if grid[x][y] then
-      work[x][y] = value_for_spot(x, y)
-    end
-  end
-  end
+  gui.grid_grow(grid, work, false, keep_edges)
 
   -- transfer result into input grid
   grid:swap_data(work)
@@ -705,41 +454,9 @@ end
 function GRID_CLASS.grow8(grid, keep_edges)
   -- like grow() method but expands in all 8 directions
 
-  local W = grid.w
-  local H = grid.h
-
-  local work = table.array_2D(W, H)
+  local work = table.array_2D(grid.w, grid.h)
 
-
-  local function value_for_spot(x, y)
-    local val = grid[x][y]
-    local hit_edge
-
-    for dir = 1,9 do if dir ~= 5 then
-      local nx, ny = geom.nudge(x, y, dir)
-
-      if not grid:valid(nx, ny) or not grid[nx][ny] then
-        hit_edge = true
-      elseif grid[nx][ny] > 0 then
-        val = grid[nx][ny]
-      end
-    end end -- dir
-
-    if keep_edges and hit_edge then
-      return grid[x][y]
-    end
-
-    return val
-  end
-
-  -- compute the new cells
-  for x = 1, W do
-  for y = 1, H do
-    if grid[x][y] then
-      work[x][y] = value_for_spot(x, y)
-    end
-  end
-  end
+  gui.grid_grow(grid, work, true, keep_edges)
 
   -- transfer result into input grid
   grid:swap_data(work)
@@ -751,40 +468,9 @@ function GRID_CLASS.shrink(grid, keep_edges)
   -- when 'keep_edges' is true, cells at edges are not touched.
   -- nil cells are not affected.
 
-  local W = grid.w
-  local H = grid.h
-
-  local work = table.array_2D(W, H)
+  local work = table.array_2D(grid.w, grid.h)
 
-  local function value_for_spot(x, y)
-    local val = grid[x][y]
-    local hit_edge
-
-    for dir = 2,8,2 do
-      local nx, ny = geom.nudge(x, y, dir)
-
-      if not grid:valid(nx, ny) or not grid[nx][ny] then
-        hit_edge = true
-      elseif grid[nx][ny] < 0 then
-        val = grid[nx][ny]
-      end
-    end
-
-    if keep_edges and hit_edge then
-      return grid[x][y]
-    end
-
-    return val
-  end
-
-  -- compute the new cells
-  for x = 1, W do
-  for y = 1, H do
-    if grid[x][y] then
-      work[x][y] = value_for_spot(x, y)
-    end
-  end
-  end
+  gui.grid_shrink(grid, work, false, keep_edges)
 
   -- transfer result into input grid
   grid:swap_data(work)
@@ -794,40 +480,9 @@ end
 function GRID_CLASS.shrink8(grid, keep_edges)
   -- like shrink() method but checks all 8 directions
 
-  local W = grid.w
-  local H = grid.h
-
-  local work = table.array_2D(W, H)
-
-  local function value_for_spot(x, y)
-    local val = grid[x][y]
-    local hit_edge
-
-    for dir = 1,9 do if dir ~= 5 then
-      local nx, ny = geom.nudge(x, y, dir)
-
-      if not grid:valid(nx, ny) or not grid[nx][ny] then
-        hit_edge = true
-      elseif grid[nx][ny] < 0 then
-        val = grid[nx][ny]
-      end
-    end end -- dir
+  local work = table.array_2D(grid.w, grid.h)
 
-    if keep_edges and hit_edge then
-      return grid[x][y]
-    end
-
-    return val
-  end
-
-  -- compute the new cells
-  for x = 1, W do
-  for y = 1, H do
-    if grid[x][y] then
-      work[x][y] = value_for_spot(x, y)
-    end
-  end
-  end
+  gui.grid_shrink(grid, work, true, keep_edges)
 
   -- transfer result into input grid
   grid:swap_data(work)
@@ -838,36 +493,7 @@ function GRID_CLASS.remove_dots(grid)
   -- removes isolated cells (solid or empty) from the cave.
   -- diagonal cells are NOT checked.
 
-  local W = grid.w
-  local H = grid.h
-
-
-  local function is_isolated(x, y, val)
-    for dir = 2,8,2 do
-      local nx, ny = geom.nudge(x, y, dir)
-
-      if not grid:valid(nx, ny) or not grid[nx][ny] then
-        -- ignore it
-      elseif grid[nx][ny] == val then
-        return false
-      end
-    end
-
-    return true
-  end
-
-
-  for x = 1, W do
-  for y = 1, H do
-    local val = grid[x][y]
-
-    if val and val ~= 0 and is_isolated(x, y, val) then
-      local dx = sel(x > W/2, -1, 1)
-
-      grid[x][y] = grid[x+dx][y]
-    end
-  end
-  end
+  gui.grid_remove_dots(grid)
 end
 
 
@@ -909,47 +535,9 @@ function GRID_CLASS.distance_map(grid, ref_points)
   assert(grid.flood)
   assert(grid.empty_id)
 
-  local W = grid.w
-  local H = grid.h
-
-  local work = table.array_2D(W, H)
-  local flood = grid.flood
-
-  local next_points = {}
-
-  local function flood_point(x, y)
-
-    -- spread this distance into neighbor cells
-    local dist = work[x][y] + 1
+  local work = table.array_2D(grid.w, grid.h)
 
-    for side = 2,8,2 do
-      local nx, ny = geom.nudge(x, y, side)
-      if nx >= 1 and nx <= W and ny >= 1 and ny <= H then
-        local F = flood[nx][ny]
-        local W =  work[nx][ny]
-
-        if F == grid.empty_id and (not W or W > dist) then
-          flood[nx][ny] = dist
-          table.insert(next_points, { x=nx, y=ny })
-        end
-      end
-    end
-  end
-
-  -- perform the fill
-
-  for _,P in pairs(ipairs(ref_points)) do
-    work[P.x][P.y] = 0,
-    flood_point(P.x, P.y)
-  end
-
-  while #next_points > 0 do
-    local np_list = next_points ; next_points = {}
-
-    for _,P in pairs(ipairs(np_list)) do
-      flood_point(P.x, P.y)
-    end
-  end
+  gui.grid_distance_map(grid.flood, work, grid.empty_id, ref_points)
 
   return work
 end
@@ -958,6 +546,9 @@ end
 function GRID_CLASS.furthest_point(grid, ref_points)
   local dist_map = grid:distance_map(ref_points)
 
+  local W = grid.w
+  local H = grid.h
+
   local best_x, best_y
   local best_dist = 9e9
 
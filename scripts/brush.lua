@@ -25,6 +25,8 @@ brushlib = {}
 
 AMBIENT_LIGHT = {}
 
+BRUSH_KEY_AMBIENT = gui.brush_key("ambient")
+
 
 function raw_add_brush(brush)
   -- check for obsolete crud
@@ -317,6 +319,95 @@ function Trans.brush(coords)
 end
 
 
+--
+-- Like Trans.brush(), but for a brush where every side has the same
+-- face properties, which is sent with the brush builder API (see
+-- csg_main.cc) instead of making a table for each coordinate.
+--
+-- 'brush' is a normal brush except it has just ONE side entry (whose
+-- x and y are ignored), and 'coords' is a flat list of x and y values
+-- for every side.  Neither table is modified.
+--
+function Trans.flat_brush(brush, coords)
+  local K, side, top, bottom
+
+  for _,C in pairs(brush) do
+    if C.m then K = C
+    elseif C.x then side = C
+    elseif C.t then top = C
+    elseif C.b then bottom = C
+    end
+  end
+
+  assert(side)
+
+  -- a game which wants to see every brush needs the full form
+  if GAME.add_brush_func then
+    local full = {}
+
+    for _,C in pairs(brush) do
+      if C ~= side then table.insert(full, table.copy(C)) end
+    end
+
+    for i = 1, #coords, 2 do
+      local C = table.copy(side)
+      C.x = coords[i] ; C.y = coords[i+1]
+      table.insert(full, C)
+    end
+
+    Trans.brush(full)
+    return
+  end
+
+  local flat = {}
+
+  for i = 1, #coords, 2 do
+    local x, y = Trans.apply_xy(coords[i], coords[i+1])
+
+    flat[i]   = x
+    flat[i+1] = y
+  end
+
+  side = table.copy(side)
+  brushlib.collect_flags({ side })
+
+  if K then
+    K = table.copy(K)
+    K.ambient = AMBIENT_LIGHT[1]
+
+    gui.brush_begin(K.m, K)
+  else
+    gui.brush_begin("solid")
+
+    if AMBIENT_LIGHT[1] then
+      gui.brush_prop(BRUSH_KEY_AMBIENT, AMBIENT_LIGHT[1])
+    end
+  end
+
+  gui.brush_verts(flat, side)
+
+  if bottom then
+    if bottom.slope then
+      bottom = table.copy(bottom)
+      bottom.slope = Trans.apply_slope(bottom.slope)
+    end
+
+    gui.brush_bottom(Trans.apply_z(bottom.b), bottom)
+  end
+
+  if top then
+    if top.slope then
+      top = table.copy(top)
+      top.slope = Trans.apply_slope(top.slope)
+    end
+
+    gui.brush_top(Trans.apply_z(top.t), top)
+  end
+
+  gui.brush_end()
+end
+
+
 
 function Trans.remap_entity(name)
   if THEME.entity_remap and name ~= nil then
@@ -55,7 +55,9 @@
 CELL_CORNERS = { 1,3,9,7 }
 
 
-function Cave_brush(area, x, y)
+function Cave_coords(area, x, y)
+  -- returns a flat list of the x and y coordinates of a cell
+
   local bx = area.base_x + (x - 1) * 64
   local by = area.base_y + (y - 1) * 64
 
@@ -78,7 +80,8 @@ function Cave_brush(area, x, y)
     fx = fx + (area.delta_x_map[cx][cy] or 0)
     fy = fy + (area.delta_y_map[cx][cy] or 0)
 
-    table.insert(coords, { x=fx, y=fy })
+    table.insert(coords, fx)
+    table.insert(coords, fy)
     ::continue::
   end
 
@@ -86,6 +89,19 @@ function Cave_brush(area, x, y)
 end
 
 
+function Cave_brush(area, x, y)
+  local flat = Cave_coords(area, x, y)
+
+  local coords = {}
+
+  for i = 1, #flat, 2 do
+    table.insert(coords, { x=flat[i], y=flat[i+1] })
+  end
+
+  return coords
+end
+
+
 
 function Cave_is_edge(S, dir)
   local N = S:raw_neighbor(dir)
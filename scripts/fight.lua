@@ -81,93 +81,47 @@ Notes
 
 
 function Fight_Simulator(monsters, weapons, stats)
-
-  local active_mons = {}
+  --
+  -- The battle itself is run by gui.fight_simulate() [ see m_fight.cc ].
+  -- Here we work out everything which only depends on the kind of
+  -- monster, such as how likely each weapon is to be used against it.
+  --
 
   local DEFAULT_ACCURACY = 70
 
   local DEFAULT_INFIGHT_DAMAGE = 20
 
 
-  local function remove_dead_mon()
-    for i = #active_mons,1,-1 do
-      if active_mons[i].health <= 0 then
-        table.remove(active_mons, i)
-      end
-    end
-  end
-
-
-  local function select_weapon()
-    local first_mon = active_mons[1].info
-    assert(first_mon)
-
-    -- determine probability for each weapon
-    local prob_tab = {}
-
-    for _,W in pairs(weapons) do
-      local prob = W.info.pref
+  local function weapon_prob(mon_info, W)
+    local prob = W.info.pref
 
-      prob = prob * (W.factor or 1)
+    prob = prob * (W.factor or 1)
 
-      -- handle monster-based weapon preferences
-      if first_mon.weap_prefs then
-        prob = prob * (first_mon.weap_prefs[W.info.name] or 1)
-      end
-
-      local W_damage = W.info.rate * W.info.damage
-
-      -- handle weapon requirements of a monster
-      if first_mon.weap_needed and not first_mon.weap_needed[W.info.name] then
-        prob = prob / 200
-      elseif first_mon.weap_min_damage and first_mon.weap_min_damage > W_damage then
-        prob = prob / 20
-      end
-
-      table.insert(prob_tab, prob)
+    -- handle monster-based weapon preferences
+    if mon_info.weap_prefs then
+      prob = prob * (mon_info.weap_prefs[W.info.name] or 1)
     end
 
-    assert(#prob_tab == #weapons)
-
-    local index = rand.index_by_probs(prob_tab)
-    local W     = assert(weapons[index])
-
-    return W
-  end
-
-
-  local function hurt_mon(idx, W, damage)
-    local M = active_mons[idx]
-
-    if not M then return end
-
-    -- apply the weapon accuracy, or use default
-    damage = damage * (W.info.accuracy or DEFAULT_ACCURACY) / 100
+    local W_damage = W.info.rate * W.info.damage
 
-    if M.info.immunity and M.info.immunity[W.info.name] then
-      damage = damage * (1 - M.info.immunity[W.info.name])
+    -- handle weapon requirements of a monster
+    if mon_info.weap_needed and not mon_info.weap_needed[W.info.name] then
+      prob = prob / 200
+    elseif mon_info.weap_min_damage and mon_info.weap_min_damage > W_damage then
+      prob = prob / 20
     end
 
-    M.health = M.health - damage
+    return prob
   end
 
 
-  local function player_shoot(W)
-    local info = W.info
-
-    hurt_mon(1, W, info.damage)
-
-    -- simulate splash damage | shotgun spread
-    if info.splash then
-      for i = 1, #info.splash do
-        hurt_mon(1 + i, W, info.splash[i])
-      end
+  local function weapon_immunity(mon_info, W)
+    -- returns a factor for the damage done
+    if mon_info.immunity and mon_info.immunity[W.info.name] then
+      return 1 - mon_info.immunity[W.info.name]
     end
 
-    -- update ammo counter
-    if info.ammo then
-      stats[info.ammo] = (stats[info.ammo] or 0) + (info.per or 1)
-    end
+    return 1
   end
 
 
@@ -205,46 +159,6 @@ function Fight_Simulator(monsters, weapons, stats)
   end
 
 
-  local function monster_infight(M)
-    -- Note: we don't check if monsters "die" here, not needed
-
-    -- collect all other monsters which can be fought
-    local others = {}
-
-    local total_weight = 0
-
-    for _,P in pairs(active_mons) do
-      if P == M then goto continue end
-
-      if can_infight(M.info, P.info) then
-        table.insert(others, P)
-        total_weight = total_weight + P.info.health
-      end
-      ::continue::
-    end
-
-    -- nothing else to fight with?
-    if table.empty(others) then
-      return
-    end
-
-    assert(total_weight > 0)
-
-    -- distribute the 'infight_damage' value
-    local damage = M.info.infight_damage or DEFAULT_INFIGHT_DAMAGE
-
-    -- bump up the damage (higher than demo analysis, but seems necessary)
-    damage = damage * 1.5
-
-    for _,P in pairs(others) do
-      -- damage is weighted, bigger monsters get a bigger share
-      local factor = P.info.health / total_weight
-
-      P.health = P.health - damage * factor
-    end
-  end
-
-
   local function fixup_hexen_mana()
     if stats.dual_mana then
       stats.blue_mana  = (stats.blue_mana  or 0) + stats.dual_mana
@@ -256,43 +170,66 @@ function Fight_Simulator(monsters, weapons, stats)
 
   ---==| Fight_Simulator |==---
 
-  stats.health = stats.health or 0
+  local kind_list = {}
+  local kind_map  = {}  -- maps MONSTER_INFO to index in kind_list
+
+  local mon_kinds = {}
 
   for _,M in pairs(monsters) do
-    local MON = table.copy(M)
+    local info = M.info
 
-    MON.health = MON.info.health
-    MON.order  = MON.info.health + gui.random()
+    if not kind_map[info] then
+      table.insert(kind_list, info)
+      kind_map[info] = #kind_list
+    end
 
-    table.insert(active_mons, MON)
+    table.insert(mon_kinds, kind_map[info])
   end
 
-  -- put toughest monster first, weakest last.
-  table.sort(active_mons,
-      function(A, B) return A.order > B.order end)
+  local kinds = {}
 
-  -- compute health needed by player
-  for _,M in pairs(active_mons) do
-    stats.health = stats.health + M.info.damage
-  end
+  for _,info in ipairs(kind_list) do
+    local K =
+    {
+      health  = info.health,
+      damage  = info.damage,
+      infight = info.infight_damage or DEFAULT_INFIGHT_DAMAGE,
+
+      probs  = {},
+      immune = {},
+      fights = {},
+    }
+
+    for _,W in ipairs(weapons) do
+      table.insert(K.probs,  weapon_prob(info, W))
+      table.insert(K.immune, weapon_immunity(info, W))
+    end
+
+    for _,info2 in ipairs(kind_list) do
+      table.insert(K.fights, can_infight(info, info2) and true or false)
+    end
 
-  -- simulate infighting
-  -- [ done *after* computing player health, as the damage values are based
-  --   on demo analysis and implicitly contain an infighing factor ]
-  for _,M in pairs(active_mons) do
-    monster_infight(M)
+    table.insert(kinds, K)
   end
 
-  remove_dead_mon()
+  local weap_list = {}
 
-  -- run simulation until all monsters are dead
-  while #active_mons > 0 do
-    local W = select_weapon()
+  for _,W in ipairs(weapons) do
+    local info = W.info
 
-    player_shoot(W)
-    remove_dead_mon()
+    table.insert(weap_list,
+    {
+      damage   = info.damage,
+      accuracy = info.accuracy or DEFAULT_ACCURACY,
+      splash   = info.splash,
+      ammo     = info.ammo,
+      per      = info.per or 1,
+    })
   end
 
+  stats.health = stats.health or 0
+
+  gui.fight_simulate(kinds, mon_kinds, weap_list, stats)
+
   fixup_hexen_mana()
 end
-
@@ -20,6 +20,7 @@
 ------------------------------------------------------------------------
 
 GROWER_DEBUG_INFO = {} -- MSSP: table for containing details about growth statistics
+GROWER_MATCHERS = {}   -- compiled input patterns, indexed by rule name
 
 function Grower_preprocess_grammar()
 
@@ -522,6 +523,49 @@ function Grower_preprocess_grammar()
   end
 
 
+  local function element_need(E)
+    -- this must agree with match_an_element() in Grower_grammatical_room
+    if E.kind == "diagonal" then
+      local need = element_need(E.bottom)
+      if element_need(E.top) ~= need then return "x" end
+      return need
+    end
+
+    if E.kind == "free" then
+      return sel(E.utterly, "!", ".")
+    end
+
+    if E.kind == "magic" then
+      if E.what == "all" or E.what == "closed" then return "x" end
+      return "r"
+    end
+
+    if E.kind == "area"   or E.kind == "link" or
+       E.kind == "liquid" or E.kind == "cage" or
+       E.kind == "stair"  or E.kind == "closet"
+    then
+      return "r"
+    end
+
+    return "x"
+  end
+
+
+  local function compile_matcher()
+    -- the native matcher quickly rules out spots where the input
+    -- pattern cannot possibly match [ see m_seeds.cc ]
+    local needs = {}
+
+    for x = 1, def.input.w do
+    for y = 1, def.input.h do
+      table.insert(needs, element_need(def.input[x][y]))
+    end
+    end
+
+    GROWER_MATCHERS[def.name] = gui.grammar_compile(def.input.w, def.input.h, table.concat(needs))
+  end
+
+
   -- NOTE: this code not used at the moment
   local function visit_contiguous_elem(x, y, kind, locs, seen)
     table.insert(locs, { x=x, y=y })
@@ -757,6 +801,7 @@ function Grower_preprocess_grammar()
 
         find_focal_points()
         find_connections()
+        compile_matcher()
 
         locate_all_contiguous_parts("stair")
         locate_all_contiguous_parts("joiner")
@@ -1193,7 +1238,7 @@ function Grower_split_liquids()
     A2.seeds = seed_list
 
     for _,S in pairs(seed_list) do
-      S.area = A2
+      S:set_area(A2)
 
       table.kill_elem(A.seeds, S)
     end
@@ -1606,7 +1651,7 @@ function Grower_grammatical_pass(R, pass, apply_num, stop_prob,
     local A = assert(S.area)
     assert(A.room)
 
-    S.area = nil
+    S:set_area(nil)
 
     table.kill_elem(A.seeds, S)
   end
@@ -1622,7 +1667,7 @@ function Grower_grammatical_pass(R, pass, apply_num, stop_prob,
       unset_seed(S)
     end
 
-    S.area = A
+    S:set_area(A)
 
     table.insert(A.seeds, S)
 
@@ -3096,6 +3141,20 @@ end
   end
 
 
+  local function candidate_spots(T, x1, y1, x2, y2)
+    local area_ids = {}
+
+    for _,A in pairs(R.areas) do
+      table.insert(area_ids, A.id)
+    end
+
+    local matcher = GROWER_MATCHERS[cur_rule.name]
+
+    return gui.grammar_match(matcher, T.transpose, T.flip_x, T.flip_y,
+                             x1, y1, x2, y2, area_ids)
+  end
+
+
   local function match_all_focal_points(T)
     area_map[1] = nil
     area_map[2] = nil
@@ -3134,60 +3193,58 @@ end
     if cur_rule.no_rotate then
       T = calc_transform(0, 0, 0)
       x1,y1, x2,y2 = get_iteration_range(T)
-  
-      for x = x1, x2 do
-        for y = y1, y2 do
-  
-          T.x = x
-          T.y = y
-  
+
+      local spots = candidate_spots(T, x1, y1, x2, y2)
+
+      for i = 1, #spots, 2 do
+        T.x = spots[i]
+        T.y = spots[i + 1]
+
+        if not match_all_focal_points(T) then goto continue end
+
+        if match_or_install_pattern("TEST", T) then
+          best.T = table.copy(T)
+          best.score = 1
+
+          -- this is less memory hungry than copying the whole table
+          best.areas[1] = area_map[1]
+          best.areas[2] = area_map[2]
+          best.areas[3] = area_map[3]
+
+            best.link_chunk = link_chunk
+          goto justpickone
+        end
+        ::continue::
+      end
+    else
+      if LEVEL.shape_transform_mode == "random" then
+        rand.shuffle(LEVEL.shape_transform_possiblities)
+      end
+      for _,transform in pairs(LEVEL.shape_transform_possiblities) do
+        T = calc_transform(transform[1], transform[2], transform[3])
+        x1,y1, x2,y2 = get_iteration_range(T)
+
+        local spots = candidate_spots(T, x1, y1, x2, y2)
+
+        for i = 1, #spots, 2 do
+          T.x = spots[i]
+          T.y = spots[i + 1]
+
           if not match_all_focal_points(T) then goto continue end
-  
+
           if match_or_install_pattern("TEST", T) then
             best.T = table.copy(T)
             best.score = 1
-  
+
             -- this is less memory hungry than copying the whole table
             best.areas[1] = area_map[1]
             best.areas[2] = area_map[2]
             best.areas[3] = area_map[3]
-  
+
               best.link_chunk = link_chunk
             goto justpickone
           end
           ::continue::
-        end -- x, y
-      end
-    else
-      if LEVEL.shape_transform_mode == "random" then
-        rand.shuffle(LEVEL.shape_transform_possiblities)
-      end
-      for _,transform in pairs(LEVEL.shape_transform_possiblities) do
-        T = calc_transform(transform[1], transform[2], transform[3])
-        x1,y1, x2,y2 = get_iteration_range(T)
-  
-        for x = x1, x2 do
-          for y = y1, y2 do
-    
-            T.x = x
-            T.y = y
-    
-            if not match_all_focal_points(T) then goto continue end
-    
-            if match_or_install_pattern("TEST", T) then
-              best.T = table.copy(T)
-              best.score = 1
-    
-              -- this is less memory hungry than copying the whole table
-              best.areas[1] = area_map[1]
-              best.areas[2] = area_map[2]
-              best.areas[3] = area_map[3]
-    
-                best.link_chunk = link_chunk
-              goto justpickone
-            end
-            ::continue::
-          end -- x, y
         end
       end
     end
@@ -4381,7 +4438,7 @@ function Grower_flatten_outdoor_fences()
        R:add_area(R.dummy_liquid)
     end
 
-    S.area = R.dummy_liquid
+    S:set_area(R.dummy_liquid)
 
     table.insert(S.area.seeds, S)
   end
@@ -1036,7 +1036,9 @@ function ob_init()
   end
 
   gui.debugf = function (fmt, ...)
-    if fmt then gui.raw_debug_print(string.format(fmt, ...)) end
+    if fmt and gui.debug_enabled() then
+      gui.raw_debug_print(string.format(fmt, ...))
+    end
   end
 
   gui.printf("****************************\n")
@@ -1699,6 +1701,8 @@ function ob_clean_up()
   PREFABS = nil
   SEEDS   = nil
 
+  gui.seeds_end()
+
   gui.rand_seed(OB_CONFIG.seed)
 
   collectgarbage("collect")
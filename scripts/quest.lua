@@ -188,6 +188,29 @@ end
 
 
 
+function Quest_build_graph()
+  --
+  -- Mirror the rooms and connections into the native quest graph
+  -- (m_quest.cc), which does the graph walking for the planner.
+  -- The results come back as ids, hence the lookup tables.
+  --
+
+  LEVEL.room_by_id = {}
+  LEVEL.conn_by_id = {}
+
+  for _,R in pairs(LEVEL.rooms) do
+    LEVEL.room_by_id[R.id] = R
+  end
+
+  for _,C in pairs(LEVEL.conns) do
+    LEVEL.conn_by_id[C.id] = C
+  end
+
+  gui.qgraph_build(LEVEL.rooms, LEVEL.conns)
+end
+
+
+
 function Quest_size_of_room_set(rooms)
   local total = 0
 
@@ -369,6 +392,7 @@ function Quest_create_initial_quest()
 
   for _,R in pairs(LEVEL.rooms) do
     R.quest = Q
+    gui.qgraph_set_quest(R.id, Q.id)
 
     Q.rooms[R.id] = R
     Q.svolume = Q.svolume + R.svolume
@@ -412,32 +436,11 @@ function Quest_eval_divide_at_conn(C, goal, info)
   local quest  -- current quest
 
 
-  local function same_quest(C2)
-    return C2.R1.quest == C2.R2.quest
-  end
-
-
-  local function collect_rooms(R, list)
-    list[R.id] = R
-
-    for _,C2 in pairs(R.conns) do
-      -- never pass through connection we are examining
-      if C2 == C then goto continue end
-
-      if not same_quest(C2) then goto continue end
-
-      local R2
-      if C2.R1 == R then
-        R2 = C2.R2
-      else
-        R2 = C2.R1
-      end
-
-      -- already seen?
-      if list[R2.id] then goto continue end
+  local function collect_rooms(ids)
+    local list = {}
 
-      collect_rooms(R2, list)
-      ::continue::
+    for _,id in ipairs(ids) do
+      list[id] = LEVEL.room_by_id[id]
     end
 
     return list
@@ -548,8 +551,10 @@ gui.debugf("  quest : %s\n", quest.name)
   end
 
   -- collect rooms on each side of the connection
-  local before = collect_rooms(C.R1, {})
-  local  after = collect_rooms(C.R2, {})
+  local before_ids, after_ids = gui.qgraph_split(C.id)
+
+  local before = collect_rooms(before_ids)
+  local  after = collect_rooms(after_ids)
 
 --[[
 stderrf("BEFORE =\n  ")
@@ -640,6 +645,7 @@ function Quest_perform_division(info)
   local function assign_quest(Q)
     for id, R in pairs(Q.rooms) do
       R.quest = Q
+      gui.qgraph_set_quest(R.id, Q.id)
     end
   end
 
@@ -1330,84 +1336,43 @@ function Quest_calc_exit_dists()
   --
 
 
-  local function mark_exit_to_quest(Q)
+  local function find_exit_to_quest(Q)
     -- find the room which exits into the given quest
-    local exit_R
 
     for _,C in pairs(LEVEL.conns) do
       if C.R1 == Q.entry and C.R2.quest ~= Q then
-        exit_R = C.R2
-        break;
+        return C.R2
       end
 
       if C.R2 == Q.entry and C.R1.quest ~= Q then
-        exit_R = C.R1
-        break;
+        return C.R1
       end
     end
 
-    if exit_R then
-      assert(exit_R.quest ~= Q)
-      exit_R.dist_to_exit = 0
-    end
+    return nil
   end
 
 
-  local function spread_through_conn(C)
-    local R1 = C.R1
-    local R2 = C.R2
-
-    -- NEVER cross quest boundaries
-    if R1.quest ~= R2.quest then return false end
-
-    if not R1.dist_to_exit then
-      R1, R2 = R2, R1
-    end
-
-    if not R1.dist_to_exit then
-      return false
-    end
-
-    local step = 1.0
+  ---| Quest_calc_exit_dists |---
 
-    if R1.is_hallway or R2.is_hallway then
-      step = 0.3
-    end
+  local sources = { LEVEL.exit_room.id }
 
-    local new_dist = R1.dist_to_exit + step
+  for _,Q in pairs(LEVEL.quests) do
+    local exit_R = find_exit_to_quest(Q)
 
-    if not R2.dist_to_exit or (R2.dist_to_exit > new_dist) then
-      R2.dist_to_exit = new_dist
-      return true
+    if exit_R then
+      assert(exit_R.quest ~= Q)
+      table.insert(sources, exit_R.id)
     end
-
-    return false
   end
 
+  -- spread the distances through each quest (this never crosses
+  -- quest boundaries, and hallways count less than rooms).
 
-  local function spread_dists()
-    local did_spread = false
+  local dists = gui.qgraph_exit_dists(sources)
 
-    for _,C in pairs(LEVEL.conns) do
-      if spread_through_conn(C) then
-        did_spread = true
-      end
-    end
-
-    return did_spread
-  end
-
-
-  ---| Quest_calc_exit_dists |---
-
-  LEVEL.exit_room.dist_to_exit = 0
-
-  for _,Q in pairs(LEVEL.quests) do
-    mark_exit_to_quest(Q)
-  end
-
-  for loop = 1,99 do
-    if not spread_dists() then break; end
+  for i = 1, #dists, 2 do
+    LEVEL.room_by_id[dists[i]].dist_to_exit = dists[i+1]
   end
 end
 
@@ -1594,11 +1559,8 @@ function Quest_order_by_visit()
   -- order chosen here will be quite arbitrary.
   --
 
-  local room_along  = 1
   local quest_along = 1
 
-  local next_locs = {}
-
 
   local function visit_quest_node(Q)
     if Q.node_id then
@@ -1613,49 +1575,6 @@ function Quest_order_by_visit()
   end
 
 
-  local function visit_next_room()
-    table.sort(next_locs, function(A, B)
-        return A.cost < B.cost end)
-
-    local loc = assert(table.remove(next_locs, 1))
-
-    local R = loc.R
-
---- stderrf("visit_next_room %s (quest %s along:%1.3f)\n", R.name, R.quest.name, R.quest.lev_along)
-
-    R.lev_along = room_along / #LEVEL.rooms
-
-    room_along = room_along + 1
-
-    -- collect which rooms to visit next
-    for _,C in pairs(R.conns) do
-      local R2 = C:other_room(R)
-
-      -- done the other room?
-      if R2.lev_along then goto continue end
-
-      local loc = { R=R2 }
-
-      -- we MUST honor the quest ordering
-      if R2.quest ~= R.quest then
-        loc.cost = 100 + 100 * math.max(R2.quest.lev_along, R.quest.lev_along)
-
-      elseif R2.rough_exit_dist then
-        loc.cost = 80 - R2.rough_exit_dist
-
-      else
-        loc.cost = 0
-      end
-
-      -- tie breaker
-      loc.cost = loc.cost + gui.random() * 0.1
-
-      table.insert(next_locs, loc)
-      ::continue::
-    end
-  end
-
-
   local function dump_quests()
     gui.printf("Quest list:\n")
 
@@ -1675,17 +1594,34 @@ function Quest_order_by_visit()
   end
 
 
-  local function do_entry_conns(R, entry_conn, seen)
-    R.entry_conn = entry_conn
+  local function do_entry_conns(start_R)
+    start_R.entry_conn = nil
 
-    seen[R] = 1
+    local list = gui.qgraph_entry_conns(start_R.id)
 
-    for _,C in pairs(R.conns) do
-      local R2 = C:other_room(R)
+    for i = 1, #list, 2 do
+      LEVEL.room_by_id[list[i]].entry_conn = LEVEL.conn_by_id[list[i+1]]
+    end
+  end
 
-      if not seen[R2] then
-        do_entry_conns(R2, C, seen)
-      end
+
+  local function visit_rooms()
+    local lev_along = {}
+    local rough = {}
+
+    for _,Q in pairs(LEVEL.quests) do
+      lev_along[Q.id] = Q.lev_along
+    end
+
+    for _,R in pairs(LEVEL.rooms) do
+      rough[R.id] = R.rough_exit_dist
+    end
+
+    local order = gui.qgraph_visit_order(LEVEL.start_room.id, lev_along, rough)
+
+    -- a room may be visited more than once, the last one wins
+    for room_along, id in ipairs(order) do
+      LEVEL.room_by_id[id].lev_along = room_along / #LEVEL.rooms
     end
   end
 
@@ -1710,7 +1646,7 @@ function Quest_order_by_visit()
 
   ---| Quest_order_by_visit |---
 
-  do_entry_conns(LEVEL.start_room, nil, {})
+  do_entry_conns(LEVEL.start_room)
 
   mark_rough_path_to_exit()
 
@@ -1732,11 +1668,7 @@ function Quest_order_by_visit()
 
   -- sort the rooms into a visit order --
 
-  table.insert(next_locs, { R=LEVEL.start_room, cost=0 })
-
-  while next_locs[1] do
-    visit_next_room()
-  end
+  visit_rooms()
 
   -- sanity check
   for _,R in pairs(LEVEL.rooms) do
@@ -1768,29 +1700,22 @@ function Quest_find_backtracks()
   end
 
 
-  local function find_path_between_rooms(R1, R2, seen)
+  local function find_path_between_rooms(R1, R2)
     assert(R1 ~= R2)
 
-    for _,C in pairs(R1.conns) do
-      local N = C:other_room(R1)
+    local ids = gui.qgraph_path(R1.id, R2.id)
 
-      if N == R2 then return { C } end
-
-      if seen[N] then goto continue end
-
-      local seen2 = table.copy(seen)
-      seen2[R1] = true
+    if not ids then
+      return nil  -- no path
+    end
 
-      local list = find_path_between_rooms(N, R2, seen2)
+    local list = {}
 
-      if list then
-        table.insert(list, 1, C)
-        return list
-      end
-      ::continue::
+    for _,id in ipairs(ids) do
+      table.insert(list, LEVEL.conn_by_id[id])
     end
 
-    return nil  -- no path
+    return list
   end
 
 
@@ -1804,7 +1729,7 @@ function Quest_find_backtracks()
 
     if R == R2 then return end
 
-    local path = find_path_between_rooms(R, R2, {})
+    local path = find_path_between_rooms(R, R2)
 
     gui.debugf("look_for_path : %s --> %s  goal %s/%s\n", R.name, R2.name,
                goal.kind, goal.item or "---")
@@ -3360,6 +3285,8 @@ function Quest_make_quests()
   LEVEL.quests = {}
   LEVEL.zones  = {}
 
+  Quest_build_graph()
+
   Quest_create_initial_quest()
 
   Quest_add_major_quests()
@@ -3368,6 +3295,9 @@ function Quest_make_quests()
   Quest_order_by_visit()
   Quest_find_backtracks()
 
+  -- the graph is only used for planning, which is done now
+  gui.qgraph_end()
+
   -- this must be after quests have been ordered
   Quest_create_zones()
 
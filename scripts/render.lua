@@ -4491,7 +4491,8 @@ function Render_cells(area)
 
 
   local function render_floor(x, y, B)
-    local f_brush = Cave_brush(area, x, y)
+    -- a single side, the real ones are added by Trans.flat_brush
+    local f_brush = { { x=0, y=0 } }
 
     -- this is NIL for completely solid areas
     local f_h = B.floor_h
@@ -4538,14 +4539,14 @@ function Render_cells(area)
       brushlib.set_y_offset(f_brush, B.floor_y_offset)
     end
 
-    Trans.brush(f_brush)
+    Trans.flat_brush(f_brush, Cave_coords(area, x, y))
   end
 
 
   local function render_ceiling(x, y, B)
     if not B.ceil_h then return end
 
-    local c_brush = Cave_brush(area, x, y)
+    local c_brush = { { x=0, y=0 } }
 
     local bottom = { b=B.ceil_h }
     table.insert(c_brush, bottom)
@@ -4568,7 +4569,7 @@ function Render_cells(area)
       brushlib.set_y_offset(c_brush, B.ceil_y_offset)
     end
 
-    Trans.brush(c_brush)
+    Trans.flat_brush(c_brush, Cave_coords(area, x, y))
   end
 
 
@@ -273,7 +273,7 @@ function ROOM_CLASS.try_collect_seed(R, S)
   if not S.area then return end
   if S.area.room ~= R then return end
 
-  S.room = R
+  S:set_room(R)
 
   table.insert(R.seeds, S)
 
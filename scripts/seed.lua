@@ -210,6 +210,8 @@ function SEED_CLASS.split(S, diagonal)
 
   S.diagonal = diagonal
 
+  gui.seed_set_diagonal(S.sx, S.sy, diagonal)
+
   local S2 = Seed_create(S.sx, S.sy, S.x1, S.y1)
 
   S2.diagonal = 10 - diagonal
@@ -240,6 +242,8 @@ function SEED_CLASS.join_halves(S)
   S.diagonal = nil
   S.top = nil
 
+  gui.seed_set_diagonal(S.sx, S.sy, nil)
+
   S.name = string.format("SEED [%d,%d]", S.sx, S.sy)
 
   S:calc_mid_point()
@@ -256,6 +260,31 @@ function SEED_CLASS.join_halves(S)
 end
 
 
+--
+-- these setters keep the native seed grid (m_seeds.cc) up to date,
+-- so always use them instead of assigning the fields directly.
+--
+function SEED_CLASS.set_room(S, R)
+  S.room = R
+
+  gui.seed_set_room(S.sx, S.sy, S.bottom, R and R.id)
+end
+
+
+function SEED_CLASS.set_area(S, A)
+  S.area = A
+
+  gui.seed_set_area(S.sx, S.sy, S.bottom, A and A.id)
+end
+
+
+function SEED_CLASS.set_edge(S, dir, E)
+  S.edge[dir] = E
+
+  gui.seed_set_edge(S.sx, S.sy, S.bottom, dir)
+end
+
+
 -- NOTE: this is "raw" and does not handle diagonal seeds
 function SEED_CLASS.raw_neighbor(S, dir, dist)
   local nx, ny = geom.nudge(S.sx, S.sy, dir, dist)
@@ -278,60 +307,13 @@ end
 -- Returns NIL for edge of map (like the raw_neighbor method).
 --
 function SEED_CLASS.neighbor(S, dir, nodir)
-  local N
-
-  -- handle square seeds
-
-  if not S.diagonal then
-    if not (dir == 2 or dir == 4 or dir == 6 or dir == 8) then
-      return nodir
-    end
-
-    N = S:raw_neighbor(dir)
-
-    if N then
-      if dir == 2 and N.diagonal then return N.top end
-
-      if dir == 4 and N.diagonal == 1 then return N.top end
-      if dir == 6 and N.diagonal == 3 then return N.top end
-    end
-
-    return N
-  end
-
-  -- handle diagonal seeds
-
-  if (S.diagonal == 7 or S.diagonal == 9) and dir == 8 then
-    return S:raw_neighbor(dir)
-  end
+  local N = gui.seed_neighbor(S.sx, S.sy, S.bottom, dir)
 
-  if (S.diagonal == 1 or S.diagonal == 3) and dir == 2 then
-    N = S:raw_neighbor(dir)
-    if N and N.diagonal then return N.top end
-    return N
+  if N == false then
+    return nodir
   end
 
-  if (S.diagonal == 1 or S.diagonal == 7) and dir == 4 then
-    N = S:raw_neighbor(dir)
-    if N and N.diagonal == 1 then return N.top end
-    return N
-  end
-
-  if (S.diagonal == 3 or S.diagonal == 9) and dir == 6 then
-    N = S:raw_neighbor(dir)
-    if N and N.diagonal == 3 then return N.top end
-    return N
-  end
-
-  -- diagonal directions in directions seeds
-
-  if S.diagonal == 1 and dir == 9 then return S.top end
-  if S.diagonal == 3 and dir == 7 then return S.top end
-
-  if S.diagonal == 7 and dir == 3 then return S.bottom end
-  if S.diagonal == 9 and dir == 1 then return S.bottom end
-
-  return nodir
+  return N
 end
 
 
@@ -578,6 +560,8 @@ function Seed_init()
   end -- x,y
   end
 
+  gui.seeds_begin(SEEDS)
+
   -- init depot locations [ for teleport-in monsters ]
 
   LEVEL.depot_locs = {}
@@ -610,36 +594,19 @@ end
 function Seed_is_free(x, y)
   assert(Seed_valid(x, y))
 
-  return not SEEDS[x][y].room
+  return not gui.seed_room(x, y)
 end
 
 
 function Seed_valid_and_free(x, y)
-  if not Seed_valid(x, y) then
-    return false
-  end
-
-  return Seed_is_free(x, y)
+  return gui.seeds_block_free(x, y, x, y)
 end
 
 
 function Seed_block_valid_and_free(x1,y1, x2,y2)
-
   assert(x1 <= x2 and y1 <= y2)
 
-  if not Seed_valid(x1, y1) then return false end
-  if not Seed_valid(x2, y2) then return false end
-
-  for x = x1,x2 do
-  for y = y1,y2 do
-    local S = SEEDS[x][y][z]
-    if S.room then
-      return false
-    end
-  end -- x, y
-  end
-
-  return true
+  return gui.seeds_block_free(x1, y1, x2, y2)
 end
 
 
@@ -1106,7 +1073,7 @@ function Edge_new(kind, S, dir, long)
       print("Seed already has an EDGE @ " .. S.mid_x .. ", ".. S.mid_y)
     end
 
-    S.edge[dir] = EDGE
+    S:set_edge(dir, EDGE)
 
     S = S:neighbor(geom.RIGHT[dir])
   end
@@ -31,11 +31,33 @@
 #include "m_lua.h"
 #include "main.h"
 
-double QUANTIZE_GRID;
+// the BSP state is per-thread, since the Quake clipping hulls are
+// each built on their own thread.  LogPrintf() is not thread-safe,
+// hence nothing gets logged while building a clip hull.
 
-static bool csg_is_clip_hull;
+thread_local double QUANTIZE_GRID;
 
-static std::vector<region_c *> dead_regions;
+thread_local bool csg_is_clip_hull;
+
+static thread_local std::vector<region_c *> dead_regions;
+
+template <typename... Args>
+[[noreturn]] static void CSG_FatalError(std::string_view msg,
+                                        Args &&...args) {
+    if (csg_is_clip_hull) {
+        throw csg_error_c(fmt::format(msg, std::forward<Args>(args)...));
+    }
+
+    Main::FatalError(msg, std::forward<Args>(args)...);
+}
+
+void CSG_AssertFail(const char *cond, const char *func, const char *file,
+                    int line) {
+    CSG_FatalError(
+        "Sorry, an internal error occurred.\nAssertion ({}) failed\n"
+        "In function {} ({}:{})\n",
+        cond, func, file, line);
+}
 
 class partition_c {
    public:
@@ -99,7 +121,7 @@ snag_c::snag_c(brush_vert_c *side, double _x1, double _y1, double _x2,
       partner(NULL),
       seen(false) {
     if (Length() < SNAG_EPSILON) {
-        Main::FatalError(
+        CSG_FatalError(
             "Line loop contains zero-length line! ({:1.2} {:1.2})\n", x1, y1);
     }
 
@@ -637,11 +659,11 @@ void bsp_node_c::AddBBox(region_c *leaf) {
 
 /***** VARIABLES ******************/
 
-static std::vector<partition_c *> all_partitions;
+static thread_local std::vector<partition_c *> all_partitions;
 
-std::vector<region_c *> all_regions;
+thread_local std::vector<region_c *> all_regions;
 
-bsp_node_c *bsp_root;
+thread_local bsp_node_c *bsp_root;
 
 //------------------------------------------------------------------------
 
@@ -972,14 +994,20 @@ static void DivideOneRegion(region_c *R, partition_c *part, group_c &front,
 
     if (R->snags.size() < 3) {
         R->degenerate = true;
-        LogPrintf("WARNING: region degenerated ({} snags)\n", R->snags.size());
+        if (!csg_is_clip_hull) {
+            LogPrintf("WARNING: region degenerated ({} snags)\n",
+                      R->snags.size());
+        }
     } else {
         front.AddRegion(R);
     }
 
     if (N->snags.size() < 3) {
         N->degenerate = true;
-        LogPrintf("WARNING: region degenerated ({} snags)\n", N->snags.size());
+        if (!csg_is_clip_hull) {
+            LogPrintf("WARNING: region degenerated ({} snags)\n",
+                      N->snags.size());
+        }
     } else {
         back.AddRegion(N);
     }
@@ -1527,6 +1555,10 @@ static void RemoveDeadRegions() {
     int after = (int)all_regions.size();
     int count = before - after;
 
+    if (csg_is_clip_hull) {
+        return;
+    }
+
     LogPrintf("Removed {} dead regions (of {})\n", count, before);
 
     if (lost_ents > 0) {
@@ -1592,7 +1624,10 @@ static gap_c *GapForEntity(const region_c *R, csg_entity_c *E) {
         double z2 = (G->top->b.z + G->top->t.z) / 2.0;
 
         if (z1 < E->z && E->z < z2) {
-            E->ex_floor = (int)i;
+            // entities are shared between the clip hull threads
+            if (!csg_is_clip_hull) {
+                E->ex_floor = (int)i;
+            }
 
             return G;
         }
@@ -1781,10 +1816,12 @@ static void RemoveUnusedGaps() {
     }
 
     if (filled == total) {
-        Main::FatalError("CSG: all gaps were unreachable (no entities?)\n");
+        CSG_FatalError("CSG: all gaps were unreachable (no entities?)\n");
     }
 
-    LogPrintf("Filled {} gaps (of {} total)\n", filled, total);
+    if (!csg_is_clip_hull) {
+        LogPrintf("Filled {} gaps (of {} total)\n", filled, total);
+    }
 }
 
 struct csg_brush_bz_Compare {
@@ -1904,18 +1941,23 @@ void CSG_DiscoverGaps() {
     MarkGapsWithEntities();
 }
 
-void CSG_BSP(double grid, bool is_clip_hull) {
+void CSG_BSP(double grid, bool is_clip_hull,
+             const std::vector<csg_brush_c *> *brushes) {
     CSG_BSP_Free();
 
     QUANTIZE_GRID = grid;
 
     csg_is_clip_hull = is_clip_hull;
 
+    if (!brushes) {
+        brushes = &all_brushes;
+    }
+
     group_c root;
 
     // create a region for every brush
-    for (unsigned int i = 0; i < all_brushes.size(); i++) {
-        CreateRegion(root, all_brushes[i]);
+    for (unsigned int i = 0; i < brushes->size(); i++) {
+        CreateRegion(root, (*brushes)[i]);
     }
 
     for (unsigned int i = 0; i < all_entities.size(); i++) {
@@ -1993,6 +2035,80 @@ void CSG_BSP_Free() {
     bsp_root = NULL;
 }
 
+//------------------------------------------------------------------------
+
+void csg_points_c::Clear() {
+    x.clear();
+    y.clear();
+    z.clear();
+    dist.clear();
+}
+
+void csg_points_c::LineDist(double x1, double y1, double x2, double y2) {
+    unsigned int total = Size();
+
+    dist.resize(total);
+
+    double dx = x2 - x1;
+    double dy = y2 - y1;
+
+    double len = sqrt(dx * dx + dy * dy);
+
+    SYS_ASSERT(len > 0);
+
+    const double *px = x.data();
+    const double *py = y.data();
+
+    double *out = dist.data();
+
+    // this must match PerpDist() exactly, hence the divide
+    for (unsigned int i = 0; i < total; i++) {
+        out[i] = ((px[i] - x1) * dy - (py[i] - y1) * dx) / len;
+    }
+}
+
+void csg_points_c::PlaneDist(float px, float py, float pz, float nx, float ny,
+                             float nz) {
+    unsigned int total = Size();
+
+    dist.resize(total);
+
+    const double *ax = x.data();
+    const double *ay = y.data();
+    const double *az = z.data();
+
+    double *out = dist.data();
+
+    for (unsigned int i = 0; i < total; i++) {
+        float d = ((float)ax[i] - px) * nx + ((float)ay[i] - py) * ny +
+                  ((float)az[i] - pz) * nz;
+
+        out[i] = d;
+    }
+}
+
+int csg_points_c::Side(unsigned int first, unsigned int count,
+                       double epsilon) const {
+    float min_d = +9e9;
+    float max_d = -9e9;
+
+    const double *d = dist.data() + first;
+
+    for (unsigned int i = 0; i < count; i++) {
+        min_d = MIN(min_d, (float)d[i]);
+        max_d = MAX(max_d, (float)d[i]);
+    }
+
+    if (min_d > -epsilon) {
+        return +1;
+    }
+    if (max_d < epsilon) {
+        return -1;
+    }
+
+    return 0;  // straddles
+}
+
 //------------------------------------------------------------------------
 //   TESTING GOODIES
 //------------------------------------------------------------------------
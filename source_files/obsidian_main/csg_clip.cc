@@ -391,27 +391,47 @@ class clip_node_c {
     }
 };
 
-static std::vector<csg_brush_c *> saved_all_brushes;
+// a clip node as built by a hull thread.  The plane is only turned
+// into a plane number when the hulls are written out (in order), and
+// a child >= 0 is an index local to the hull, otherwise contents.
+class clip_raw_c {
+   public:
+    double x, y, z;
+    double nx, ny, nz;
 
-static std::vector<clip_side_c *> all_clip_sides;
+    int children[2];
 
-//------------------------------------------------------------------------
+   public:
+    clip_raw_c(double _x, double _y, double _z, double _nx, double _ny,
+               double _nz)
+        : x(_x), y(_y), z(_z), nx(_nx), ny(_ny), nz(_nz), children() {}
 
-static void SaveBrushes() {
-    saved_all_brushes.clear();
+    ~clip_raw_c() {}
+};
 
-    std::swap(all_brushes, saved_all_brushes);
-}
+class clip_hull_c {
+   public:
+    std::vector<clip_raw_c> nodes;
 
-static void RestoreBrushes() {
-    // free our modified ones
-    for (unsigned int i = 0; i < all_brushes.size(); i++) {
-        delete all_brushes[i];
-    }
+    // where the nodes of each map-model begin
+    std::vector<int> model_starts;
 
-    all_brushes.clear();
+   public:
+    clip_hull_c() : nodes(), model_starts() {}
+
+    ~clip_hull_c() {}
+};
 
-    std::swap(all_brushes, saved_all_brushes);
+static std::vector<clip_side_c *> all_clip_sides;
+
+//------------------------------------------------------------------------
+
+static void FreeBrushes(std::vector<csg_brush_c *> &list) {
+    for (unsigned int i = 0; i < list.size(); i++) {
+        delete list[i];
+    }
+
+    list.clear();
 }
 
 static void CalcNormal(double x1, double y1, double x2, double y2, double *nx,
@@ -587,11 +607,11 @@ static void FattenVertex3(const csg_brush_c *P, unsigned int k, csg_brush_c *P2,
     }
 }
 
-static void AddFatBrush(csg_brush_c *P2) {
+static void AddFatBrush(csg_brush_c *P2, std::vector<csg_brush_c *> &list) {
     P2->ComputeBBox();
     P2->Validate();
 
-    all_brushes.push_back(P2);
+    list.push_back(P2);
 }
 
 #if 0  // TODO
@@ -618,9 +638,12 @@ static void AdjustSlope(slope_info_c *slope, double pad_w, bool is_ceil)
 }
 #endif
 
-static void FattenBrushes(double pad_w, double pad_t, double pad_b) {
-    for (unsigned int i = 0; i < saved_all_brushes.size(); i++) {
-        csg_brush_c *P = saved_all_brushes[i];
+static void FattenBrushes(double pad_w, double pad_t, double pad_b,
+                          std::vector<csg_brush_c *> &list) {
+    // NOTE: all_brushes is shared by every hull, only read it
+
+    for (unsigned int i = 0; i < all_brushes.size(); i++) {
+        csg_brush_c *P = all_brushes[i];
 
         if (P->bkind != BKIND_Solid) {
             continue;
@@ -635,6 +658,10 @@ static void FattenBrushes(double pad_w, double pad_t, double pad_b) {
 
         P2->bkind = BKIND_Solid;
 
+        // the copied planes would share (and free) the original UVs
+        P2->b.uv_mat = NULL;
+        P2->t.uv_mat = NULL;
+
         P2->b.z -= pad_b;
         P2->t.z += pad_t;
 
@@ -661,7 +688,7 @@ static void FattenBrushes(double pad_w, double pad_t, double pad_b) {
 		}
 #endif
 
-        AddFatBrush(P2);
+        AddFatBrush(P2, list);
     }
 }
 
@@ -765,15 +792,24 @@ static void Split_XY(clip_group_c &group, const clip_partition_c *part,
 
     local_sides.swap(group.sides);
 
+    // classify the ends of every side in one go
+    csg_points_c points;
+
     for (unsigned int k = 0; k < local_sides.size(); k++) {
         clip_side_c *S = local_sides[k];
 
-        // get relationship of this side to the partition line
-        double a =
-            PerpDist(S->x1, S->y1, part->x1, part->y1, part->x2, part->y2);
+        points.Add(S->x1, S->y1);
+        points.Add(S->x2, S->y2);
+    }
+
+    points.LineDist(part->x1, part->y1, part->x2, part->y2);
+
+    for (unsigned int k = 0; k < local_sides.size(); k++) {
+        clip_side_c *S = local_sides[k];
 
-        double b =
-            PerpDist(S->x2, S->y2, part->x1, part->y1, part->x2, part->y2);
+        // get relationship of this side to the partition line
+        double a = points.dist[k * 2];
+        double b = points.dist[k * 2 + 1];
 
         int a_side = (a < -CLIP_EPSILON) ? -1 : (a > CLIP_EPSILON) ? +1 : 0;
         int b_side = (b < -CLIP_EPSILON) ? -1 : (b > CLIP_EPSILON) ? +1 : 0;
@@ -995,46 +1031,67 @@ static void DoWriteClip(dclipnode_t &raw_clip, bool flip) {
     q1_total_clip += 1;
 }
 
-static void WriteClipNodes(clip_node_c *node) {
+static void StoreClipNodes(clip_node_c *node, clip_hull_c *hull) {
     if (!node->IsNode()) {
         return;
     }
 
-    dclipnode_t raw_clip;
-
-    bool flipped;
+    SYS_ASSERT(node->index == (int)hull->nodes.size());
 
     if (node->part.kind == PKIND_FLAT) {
         // !!!! FIXME: support slopes
 
-        raw_clip.planenum =
-            BSP_AddPlane(0, 0, node->part.z, 0, 0, node->part.dz, &flipped);
+        hull->nodes.push_back(
+            clip_raw_c(0, 0, node->part.z, 0, 0, node->part.dz));
     } else {
-        raw_clip.planenum = BSP_AddPlane(
+        hull->nodes.push_back(clip_raw_c(
             node->part.x1, node->part.y1, 0, node->part.y2 - node->part.y1,
-            node->part.x1 - node->part.x2, 0, &flipped);
+            node->part.x1 - node->part.x2, 0));
     }
 
+    clip_raw_c &raw = hull->nodes.back();
+
     node->CheckValid();
 
     if (node->front->IsNode()) {
-        raw_clip.children[0] = (u16_t)node->front->index;
+        raw.children[0] = node->front->index;
     } else {
-        raw_clip.children[0] = (u16_t)node->front->contents;
+        raw.children[0] = node->front->contents;
     }
 
     if (node->back->IsNode()) {
-        raw_clip.children[1] = (u16_t)node->back->index;
+        raw.children[1] = node->back->index;
     } else {
-        raw_clip.children[1] = (u16_t)node->back->contents;
+        raw.children[1] = node->back->contents;
     }
 
-    DoWriteClip(raw_clip, flipped);
-
     // recurse now, AFTER adding the current node
 
-    WriteClipNodes(node->front);
-    WriteClipNodes(node->back);
+    StoreClipNodes(node->front, hull);
+    StoreClipNodes(node->back, hull);
+}
+
+static void WriteClipHull(const clip_hull_c *hull) {
+    int base = q1_total_clip;
+
+    for (const clip_raw_c &raw : hull->nodes) {
+        dclipnode_t raw_clip;
+
+        bool flipped;
+
+        raw_clip.planenum = BSP_AddPlane(raw.x, raw.y, raw.z, raw.nx, raw.ny,
+                                         raw.nz, &flipped);
+
+        for (int c = 0; c < 2; c++) {
+            if (raw.children[c] >= 0) {
+                raw_clip.children[c] = (u16_t)(base + raw.children[c]);
+            } else {
+                raw_clip.children[c] = (u16_t)raw.children[c];
+            }
+        }
+
+        DoWriteClip(raw_clip, flipped);
+    }
 }
 
 static void CreateClipSides(clip_group_c &group) {
@@ -1066,28 +1123,12 @@ static void CreateClipSides(clip_group_c &group) {
     }
 }
 
-#if 0  // debugging stuff
-void CLIP_BEGIN()
-{
-	SaveBrushes();
-
-	FattenBrushes(16, 24, 32);
-}
-
-void CLIP_END()
-{
-	RestoreBrushes();
-}
-#endif
-
-static void Q1_ClipWorld(int hull, const double *pads) {
-    qk_world_model->nodes[hull] = q1_total_clip;
+static void Q1_ClipWorld(clip_hull_c *hull, const double *pads) {
+    std::vector<csg_brush_c *> fat_brushes;
 
-    SaveBrushes();
+    FattenBrushes(pads[0], pads[1], pads[2], fat_brushes);
 
-    FattenBrushes(pads[0], pads[1], pads[2]);
-
-    CSG_BSP(0.5, true /* is_clip_hull */);
+    CSG_BSP(0.5, true /* is_clip_hull */, &fat_brushes);
 
     CoalesceClipRegions();
 
@@ -1097,56 +1138,65 @@ static void Q1_ClipWorld(int hull, const double *pads) {
 
     clip_node_c *ROOT = PartitionGroup(GROUP);
 
-    int cur_index = q1_total_clip;
+    int cur_index = 0;
 
     AssignIndexes(ROOT, &cur_index);
 
-    WriteClipNodes(ROOT);
+    StoreClipNodes(ROOT, hull);
 
     // this deletes the entire BSP tree (nodes and leafs)
     delete ROOT;
 
-    RestoreBrushes();
+    CSG_BSP_Free();
+
+    FreeBrushes(fat_brushes);
 }
 
-static void Q1_ClipMapModel(quake_mapmodel_c *model, int hull, double pad_w,
-                            double pad_t, double pad_b) {
-    model->nodes[hull] = q1_total_clip;
+static void Q1_ClipMapModel(quake_mapmodel_c *model, clip_hull_c *hull,
+                            double pad_w, double pad_t, double pad_b) {
+    int base = (int)hull->nodes.size();
 
-    int base = q1_total_clip;
+    hull->model_starts.push_back(base);
 
     for (int face = 0; face < 6; face++) {
-        dclipnode_t raw_clip;
-
         double v;
         double dir;
-        bool flipped;
 
         if (face < 2)  // PLANE_X
         {
             v = (face == 0) ? (model->x1 - pad_w) : (model->x2 + pad_w);
             dir = (face == 0) ? -1 : 1;
-            raw_clip.planenum = BSP_AddPlane(v, 0, 0, dir, 0, 0, &flipped);
+            hull->nodes.push_back(clip_raw_c(v, 0, 0, dir, 0, 0));
         } else if (face < 4)  // PLANE_Y
         {
             v = (face == 2) ? (model->y1 - pad_w) : (model->y2 + pad_w);
             dir = (face == 2) ? -1 : 1;
-            raw_clip.planenum = BSP_AddPlane(0, v, 0, 0, dir, 0, &flipped);
+            hull->nodes.push_back(clip_raw_c(0, v, 0, 0, dir, 0));
         } else  // PLANE_Z
         {
             v = (face == 5) ? (model->z1 - pad_b) : (model->z2 + pad_t);
             dir = (face == 5) ? -1 : 1;
-            raw_clip.planenum = BSP_AddPlane(0, 0, v, 0, 0, dir, &flipped);
+            hull->nodes.push_back(clip_raw_c(0, 0, v, 0, 0, dir));
         }
 
-        raw_clip.children[0] = (u16_t)CONTENTS_EMPTY;
-        raw_clip.children[1] = (face == 5) ? CONTENTS_SOLID : base + face + 1;
+        clip_raw_c &raw = hull->nodes.back();
 
-        DoWriteClip(raw_clip, flipped);
+        raw.children[0] = CONTENTS_EMPTY;
+        raw.children[1] = (face == 5) ? CONTENTS_SOLID : base + face + 1;
     }
 }
 
-void Q1_ClippingHull(int hull) {
+static const double *Q1_HullPads(int hull) {
+    if (qk_sub_format == SUBFMT_Hexen2) {
+        return H2_hull_sizes[hull - 1].data();
+    } else if (qk_sub_format == SUBFMT_HalfLife) {
+        return HL_hull_sizes[hull - 1].data();
+    } else {
+        return Q1_hull_sizes[hull - 1].data();
+    }
+}
+
+void Q1_ClippingHulls() {
     int clip_hulls = 2;
 
     if (qk_sub_format == SUBFMT_HalfLife) {
@@ -1156,46 +1206,77 @@ void Q1_ClippingHull(int hull) {
         clip_hulls = 5;
     }
 
-    SYS_ASSERT(hull >= 1);
-
-    if (hull > clip_hulls) {
-        return;
-    }
-
     if (main_action >= MAIN_CANCEL) {
         return;
     }
 
-    LogPrintf("\nClipping Hull {}...\n", hull);
+    LogPrintf("\nClipping Hulls...\n");
 
     if (main_win) {
         main_win->build_box->Prog_Step("Hull");
     }
 
-    ///???  FreeAll();
+    // the hulls only share the (unmodified) brushes and entities, so
+    // each one is built on its own thread, then they are written out
+    // in order with the node numbers fixed up.
 
-    const double *pads;
+    std::vector<clip_hull_c> hulls(clip_hulls);
+    std::vector<std::string> errors(clip_hulls);
 
-    if (qk_sub_format == SUBFMT_Hexen2) {
-        pads = H2_hull_sizes[hull - 1].data();
-    } else if (qk_sub_format == SUBFMT_HalfLife) {
-        pads = HL_hull_sizes[hull - 1].data();
-    } else {
-        pads = Q1_hull_sizes[hull - 1].data();
-    }
+    bool finished =
+        QCOM_ParallelFor(clip_hulls, 1, [&](int thread, int i) {
+            const double *pads = Q1_HullPads(1 + i);
+
+            // thread 0 is the main thread, so this is cleared again below
+            csg_is_clip_hull = true;
+
+            try {
+                // first clip the world, then the map-models
 
-    // first clip the world, then the map-models
+                Q1_ClipWorld(&hulls[i], pads);
 
-    Q1_ClipWorld(hull, pads);
+                for (auto *qk_all_mapmodel : qk_all_mapmodels) {
+                    Q1_ClipMapModel(qk_all_mapmodel, &hulls[i], pads[0],
+                                    pads[1], pads[2]);
+                }
+            } catch (const csg_error_c &err) {
+                errors[i] = err.what();
+            }
+
+            csg_is_clip_hull = false;
+        });
 
-    for (auto *qk_all_mapmodel : qk_all_mapmodels) {
-        Q1_ClipMapModel(qk_all_mapmodel, hull, pads[0], pads[1], pads[2]);
+    // now that every hull thread has stopped, it is safe to bail out
+    for (const std::string &error : errors) {
+        if (!error.empty()) {
+            Main::FatalError("{}", error);
+        }
     }
 
-    if (q1_total_clip >= MAX_MAP_CLIPNODES) {
-        Main::FatalError(
-            "Quake build failure: exceeded limit of {} CLIPNODES\n",
-            MAX_MAP_CLIPNODES);
+    if (!finished) {
+        return;
+    }
+
+    for (int hull = 1; hull <= clip_hulls; hull++) {
+        const clip_hull_c &H = hulls[hull - 1];
+
+        int base = q1_total_clip;
+
+        qk_world_model->nodes[hull] = base;
+
+        for (unsigned int k = 0; k < qk_all_mapmodels.size(); k++) {
+            qk_all_mapmodels[k]->nodes[hull] = base + H.model_starts[k];
+        }
+
+        WriteClipHull(&H);
+
+        LogPrintf("Clipping Hull {} : {} clipnodes\n", hull, H.nodes.size());
+
+        if (q1_total_clip >= MAX_MAP_CLIPNODES) {
+            Main::FatalError(
+                "Quake build failure: exceeded limit of {} CLIPNODES\n",
+                MAX_MAP_CLIPNODES);
+        }
     }
 }
 
@@ -21,9 +21,11 @@
 #ifndef __OBLIGE_CSG_LOCAL_H__
 #define __OBLIGE_CSG_LOCAL_H__
 
+#include <stdexcept>
 #include <vector>
 
 #include "csg_main.h"
+#include "sys_assert.h"
 
 #define SNAG_EPSILON 0.001
 
@@ -181,6 +183,45 @@ class gap_c {
     bool HasNeighbor(gap_c *N) const;
 };
 
+// A group of points kept as separate coordinate arrays, so a whole
+// group can be classified against a partition in one tight loop
+// (which the compiler vectorizes).  Used by the Quake BSP and the
+// clipping hull partitioners.
+class csg_points_c {
+   public:
+    std::vector<double> x, y, z;
+
+    // result of the last LineDist() or PlaneDist() call
+    std::vector<double> dist;
+
+   public:
+    csg_points_c() : x(), y(), z(), dist() {}
+
+    ~csg_points_c() {}
+
+    void Clear();
+
+    inline unsigned int Size() const { return (unsigned int)x.size(); }
+
+    inline void Add(double ax, double ay, double az = 0) {
+        x.push_back(ax);
+        y.push_back(ay);
+        z.push_back(az);
+    }
+
+    // distance of each point from the 2D line, same as PerpDist()
+    void LineDist(double x1, double y1, double x2, double y2);
+
+    // distance of each point from the plane in float precision, same as
+    // quake_plane_c::PointDist()
+    void PlaneDist(float px, float py, float pz, float nx, float ny,
+                   float nz);
+
+    // returns +1 when the given points are all in front (within the
+    // epsilon), -1 when all behind, and 0 when they straddle.
+    int Side(unsigned int first, unsigned int count, double epsilon) const;
+};
+
 class bsp_node_c {
    public:
     // partition
@@ -211,21 +252,46 @@ class bsp_node_c {
     void AddBBox(region_c *leaf);
 };
 
+// clipping hulls are built on worker threads, where Main::FatalError()
+// must not be called, so errors there are thrown as one of these.
+class csg_error_c : public std::runtime_error {
+   public:
+    csg_error_c(const std::string &msg) : std::runtime_error(msg) {}
+};
+
 /***** VARIABLES ****************/
 
-extern std::vector<region_c *> all_regions;
+extern thread_local std::vector<region_c *> all_regions;
 
-extern bsp_node_c *bsp_root;
+extern thread_local bsp_node_c *bsp_root;
+
+// true while this thread is building a clip hull
+extern thread_local bool csg_is_clip_hull;
 
 /***** FUNCTIONS ****************/
 
-void CSG_BSP(double grid, bool is_clip_hull = false);
+// builds from all_brushes unless another brush list is given.
+// for a clip hull, errors throw a csg_error_c.
+void CSG_BSP(double grid, bool is_clip_hull = false,
+             const std::vector<csg_brush_c *> *brushes = NULL);
 void CSG_BSP_Free();
 
 region_c *CSG_PointInRegion(double x, double y);
 
 void CSG_Shade();
 
+// like AssertFail(), but for a clip hull it throws a csg_error_c.
+[[noreturn]] void CSG_AssertFail(const char *cond, const char *func,
+                                 const char *file, int line);
+
+// the CSG code can run on a clip hull thread, so its assertions must
+// not call Main::FatalError() directly.
+#ifndef NDEBUG
+#undef SYS_ASSERT
+#define SYS_ASSERT(cond) \
+    ((cond) ? (void)0 : CSG_AssertFail(#cond, __func__, __FILE__, __LINE__))
+#endif
+
 #endif /* __OBLIGE_CSG_LOCAL_H__ */
 
 //--- editor settings ---
@@ -818,41 +818,42 @@ static quake_plane_c *Grab_Slope(lua_State *L, int stack_pos, bool is_ceil) {
         return NULL; /* NOT REACHED */
     }
 
-    quake_plane_c *P = new quake_plane_c();
+    // nothing is allocated until the checks pass, since luaL_error()
+    // does not return.
+    quake_plane_c plane;
 
     lua_getfield(L, stack_pos, "nx");
     lua_getfield(L, stack_pos, "ny");
     lua_getfield(L, stack_pos, "nz");
 
-    P->nx = luaL_checknumber(L, -3);
-    P->ny = luaL_checknumber(L, -2);
-    P->nz = luaL_checknumber(L, -1);
+    plane.nx = luaL_checknumber(L, -3);
+    plane.ny = luaL_checknumber(L, -2);
+    plane.nz = luaL_checknumber(L, -1);
 
     lua_pop(L, 3);
 
     // NOTE: x/y/z are set later in ComputePlanes()
 
-    P->Normalize();
+    plane.Normalize();
 
     // completely flat?  then don't need it
-    if (fabs(P->nz) > 0.999) {
-        delete P;
+    if (fabs(plane.nz) > 0.999) {
         return NULL;
     }
 
     // too steep?
-    if (fabs(P->nz) < 0.1) {
+    if (fabs(plane.nz) < 0.1) {
         luaL_error(L, "bad slope: too steep!");
         return NULL; /* NOT REACHED */
     }
 
     // floor slopes should have negative dz, and ceilings positive
-    if ((is_ceil ? 1 : -1) * P->nz > 0) {
+    if ((is_ceil ? 1 : -1) * plane.nz > 0) {
         luaL_error(L, "bad slope: nz should be >0 for floor, <0 for ceiling");
         return NULL; /* NOT REACHED */
     }
 
-    return P;
+    return new quake_plane_c(plane);
 }
 
 static uv_matrix_c *Grab_UVMatrix(lua_State *L, int stack_pos) {
@@ -869,7 +870,7 @@ static uv_matrix_c *Grab_UVMatrix(lua_State *L, int stack_pos) {
         return NULL; /* NOT REACHED */
     }
 
-    uv_matrix_c *uv_mat = new uv_matrix_c;
+    uv_matrix_c uv_mat;
 
     for (int n = 0; n < 8; n++) {
         lua_rawgeti(L, stack_pos, 1 + n);
@@ -882,18 +883,19 @@ static uv_matrix_c *Grab_UVMatrix(lua_State *L, int stack_pos) {
         float val = lua_tonumber(L, -1);
 
         if (n < 4) {
-            uv_mat->s[n] = val;
+            uv_mat.s[n] = val;
         } else {
-            uv_mat->t[n - 4] = val;
+            uv_mat.t[n - 4] = val;
         }
 
         lua_pop(L, 1);
     }
 
-    return uv_mat;
+    return new uv_matrix_c(uv_mat);
 }
 
-static void Grab_BrushMode(csg_brush_c *B, lua_State *L, const char *kind) {
+// returns false for an unknown kind
+static bool Grab_BrushMode(csg_brush_c *B, const char *kind) {
     // parse brush kind from 'm' field of the props table
 
     SYS_ASSERT(kind);
@@ -921,7 +923,7 @@ static void Grab_BrushMode(csg_brush_c *B, lua_State *L, const char *kind) {
         B->bkind = BKIND_Solid;
         B->bflags |= BFLAG_Detail;
     } else {
-        luaL_error(L, "gui.add_brush: unknown kind '%s'", kind);
+        return false;
     }
 
     // parse flags from the props table
@@ -945,6 +947,8 @@ static void Grab_BrushMode(csg_brush_c *B, lua_State *L, const char *kind) {
     if (B->props.getInt("noshadow") > 0) {
         B->bflags |= BFLAG_NoShadow | BFLAG_Detail;
     }
+
+    return true;
 }
 
 static int Grab_Vertex(lua_State *L, int stack_pos, csg_brush_c *B) {
@@ -963,7 +967,9 @@ static int Grab_Vertex(lua_State *L, int stack_pos, csg_brush_c *B) {
 
         Grab_Properties(L, stack_pos, &B->props, true);
 
-        Grab_BrushMode(B, L, kind_str);
+        if (!Grab_BrushMode(B, kind_str)) {
+            return luaL_error(L, "gui.add_brush: unknown kind '%s'", kind_str);
+        }
 
         lua_pop(L, 1);
 
@@ -1017,6 +1023,24 @@ static int Grab_Vertex(lua_State *L, int stack_pos, csg_brush_c *B) {
     return 0;
 }
 
+// returns an error message, or NULL if the brush is OK
+static const char *Grab_CheckBrush(csg_brush_c *B) {
+    B->ComputeBBox();
+    B->ComputePlanes();
+
+    return B->Validate();
+}
+
+static int Grab_FinishBrush(lua_State *L, csg_brush_c *B) {
+    const char *err_msg = Grab_CheckBrush(B);
+
+    if (err_msg) {
+        return luaL_error(L, "%s", err_msg);
+    }
+
+    return 0;
+}
+
 static int Grab_CoordList(lua_State *L, int stack_pos, csg_brush_c *B) {
     if (lua_type(L, stack_pos) != LUA_TTABLE) {
         return luaL_argerror(L, stack_pos, "missing table: coords");
@@ -1040,16 +1064,7 @@ static int Grab_CoordList(lua_State *L, int stack_pos, csg_brush_c *B) {
         index++;
     }
 
-    B->ComputeBBox();
-    B->ComputePlanes();
-
-    const char *err_msg = B->Validate();
-
-    if (err_msg) {
-        return luaL_error(L, "%s", err_msg);
-    }
-
-    return 0;
+    return Grab_FinishBrush(L, B);
 }
 
 // LUA: begin_level()
@@ -1191,6 +1206,272 @@ int CSG_add_brush(lua_State *L) {
     return 0;
 }
 
+//------------------------------------------------------------------------
+//  BRUSH BUILDER
+//------------------------------------------------------------------------
+//
+//  A cheaper way to submit a brush than add_brush(), which needs a
+//  table for every coordinate.  Instead the brush is built up with
+//  a few calls, and all the sides of a brush can be given in a single
+//  flat list of numbers, sharing one table of face properties.
+//
+//  Each call which creates faces (the brush itself, sides, a top or a
+//  bottom) makes them the target of any following brush_prop() calls.
+//
+
+static csg_brush_c *building_brush;
+static std::string building_kind;
+
+static std::vector<csg_property_set_c *> building_faces;
+
+static std::vector<std::string> brush_keys;
+static std::map<std::string, int> brush_key_ids;
+
+static csg_brush_c *Builder_Get(lua_State *L) {
+    if (!building_brush) {
+        luaL_error(L, "gui.brush: no brush_begin() call");
+    }
+
+    return building_brush;
+}
+
+static void Builder_Free() {
+    delete building_brush;
+
+    building_brush = NULL;
+    building_faces.clear();
+}
+
+static brush_plane_c *Builder_Plane(lua_State *L, bool is_ceil) {
+    csg_brush_c *B = Builder_Get(L);
+
+    brush_plane_c *P = is_ceil ? &B->b : &B->t;
+
+    P->z = luaL_checknumber(L, 1);
+
+    if (!lua_isnoneornil(L, 2)) {
+        lua_getfield(L, 2, "uv_mat");
+        lua_getfield(L, 2, "slope");
+
+        // these only allocate once their checks have passed, and the
+        // brush owns the result straight away.
+        P->slope = Grab_Slope(L, -1, is_ceil);
+        P->uv_mat = Grab_UVMatrix(L, -2);
+
+        lua_pop(L, 2);
+
+        Grab_Properties(L, 2, &P->face, true);
+    }
+
+    building_faces.clear();
+    building_faces.push_back(&P->face);
+
+    return P;
+}
+
+// LUA: brush_begin(kind, props)
+//
+// 'kind' and 'props' are the same as the { m=kind, ... } entry of
+// add_brush(), and the props are optional.
+//
+int CSG_brush_begin(lua_State *L) {
+    const char *kind = luaL_checkstring(L, 1);
+
+    if (building_brush) {
+        return luaL_error(L, "gui.brush_begin: previous brush not finished");
+    }
+
+    building_brush = new csg_brush_c();
+    building_kind = kind;
+
+    if (!lua_isnoneornil(L, 2)) {
+        Grab_Properties(L, 2, &building_brush->props, true);
+    }
+
+    building_faces.clear();
+    building_faces.push_back(&building_brush->props);
+
+    return 0;
+}
+
+// LUA: brush_verts(coords, props)
+//
+// adds sides to the brush, where 'coords' is a flat list of x and y
+// values.  'props' are the face properties (optional), used for all
+// of these sides.
+//
+int CSG_brush_verts(lua_State *L) {
+    csg_brush_c *B = Builder_Get(L);
+
+    luaL_checktype(L, 1, LUA_TTABLE);
+
+    int count = (int)lua_rawlen(L, 1);
+
+    if (count < 2 || (count & 1)) {
+        return luaL_argerror(L, 1, "bad coordinate list");
+    }
+
+    // check the coordinates before anything is allocated, since
+    // luaL_error() would skip freeing it.
+    for (int i = 1; i <= count; i++) {
+        lua_rawgeti(L, 1, i);
+
+        if (!lua_isnumber(L, -1)) {
+            return luaL_argerror(L, 1, "bad coordinate list");
+        }
+
+        lua_pop(L, 1);
+    }
+
+    uv_matrix_c *uv_mat = NULL;
+
+    if (!lua_isnoneornil(L, 2)) {
+        luaL_checktype(L, 2, LUA_TTABLE);
+
+        lua_getfield(L, 2, "uv_mat");
+        uv_mat = Grab_UVMatrix(L, -1);
+        lua_pop(L, 1);
+    }
+
+    // nothing below here raises an error
+    csg_property_set_c face;
+
+    if (!lua_isnoneornil(L, 2)) {
+        Grab_Properties(L, 2, &face, true);
+    }
+
+    building_faces.clear();
+
+    for (int i = 1; i < count; i += 2) {
+        lua_rawgeti(L, 1, i);
+        lua_rawgeti(L, 1, i + 1);
+
+        brush_vert_c *V =
+            new brush_vert_c(B, lua_tonumber(L, -2), lua_tonumber(L, -1));
+
+        lua_pop(L, 2);
+
+        V->face = face;
+
+        if (uv_mat) {
+            V->uv_mat = new uv_matrix_c;
+            V->uv_mat->Set(uv_mat);
+        }
+
+        B->verts.push_back(V);
+
+        building_faces.push_back(&V->face);
+    }
+
+    delete uv_mat;
+
+    return 0;
+}
+
+// LUA: brush_top(z, props)
+//
+int CSG_brush_top(lua_State *L) {
+    Builder_Plane(L, false);
+    return 0;
+}
+
+// LUA: brush_bottom(z, props)
+//
+int CSG_brush_bottom(lua_State *L) {
+    Builder_Plane(L, true);
+    return 0;
+}
+
+// LUA: brush_key(name) --> id
+//
+// returns a number for a property name, for use with brush_prop().
+//
+int CSG_brush_key(lua_State *L) {
+    std::string name = luaL_checkstring(L, 1);
+
+    auto KI = brush_key_ids.find(name);
+
+    if (KI != brush_key_ids.end()) {
+        lua_pushinteger(L, KI->second);
+        return 1;
+    }
+
+    int id = (int)brush_keys.size() + 1;
+
+    brush_keys.push_back(name);
+    brush_key_ids[name] = id;
+
+    lua_pushinteger(L, id);
+    return 1;
+}
+
+// LUA: brush_prop(key, value)
+//
+// sets a property on the faces created by the previous call.  'key'
+// is either a property name or a number from brush_key().
+//
+int CSG_brush_prop(lua_State *L) {
+    Builder_Get(L);
+
+    const char *key;
+
+    if (lua_type(L, 1) == LUA_TNUMBER) {
+        int id = (int)lua_tointeger(L, 1);
+
+        if (id < 1 || id > (int)brush_keys.size()) {
+            return luaL_argerror(L, 1, "unknown brush key");
+        }
+
+        key = brush_keys[id - 1].c_str();
+    } else {
+        key = luaL_checkstring(L, 1);
+    }
+
+    const char *value;
+
+    if (lua_type(L, 2) == LUA_TBOOLEAN) {
+        value = lua_toboolean(L, 2) ? "1" : "0";
+    } else {
+        value = luaL_checkstring(L, 2);
+    }
+
+    for (csg_property_set_c *face : building_faces) {
+        face->Add(key, value);
+    }
+
+    return 0;
+}
+
+// LUA: brush_end()
+//
+int CSG_brush_end(lua_State *L) {
+    csg_brush_c *B = Builder_Get(L);
+
+    // detach the brush first, so that a bad one does not block the
+    // next brush_begin(), and free it before raising any error.
+    building_brush = NULL;
+    building_faces.clear();
+
+    if (!Grab_BrushMode(B, building_kind.c_str())) {
+        delete B;
+        return luaL_error(L, "gui.brush_end: unknown kind '%s'",
+                          building_kind.c_str());
+    }
+
+    const char *err_msg = Grab_CheckBrush(B);
+
+    if (err_msg) {
+        delete B;
+        return luaL_error(L, "%s", err_msg);
+    }
+
+    all_brushes.push_back(B);
+
+    brush_quad_tree->Add(B);
+
+    return 0;
+}
+
 // LUA: add_entity(props)
 //
 //   id      -- number or name of thing
@@ -1354,6 +1635,8 @@ void CSG_Main_Free() {
     all_brushes.clear();
     all_entities.clear();
 
+    Builder_Free();
+
     CSG_FreeTexProps();
 
     CSG_DeleteQuadTree();
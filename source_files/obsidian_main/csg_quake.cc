@@ -21,6 +21,8 @@
 #include "csg_quake.h"
 
 #include <algorithm>
+#include <climits>
+#include <memory>
 
 #include "csg_local.h"
 #include "csg_main.h"
@@ -267,9 +269,8 @@ float quake_plane_c::PointDist(float ax, float ay, float az) const {
     return (ax - x) * nx + (ay - y) * ny + (az - z) * nz;
 }
 
-int quake_plane_c::BrushSide(csg_brush_c *B, float epsilon) const {
-    float min_d = +9e9;
-    float max_d = -9e9;
+static void GatherBrushPoints(const csg_brush_c *B, csg_points_c &points) {
+    points.Clear();
 
     for (unsigned int i = 0; i < B->verts.size(); i++) {
         brush_vert_c *V = B->verts[i];
@@ -283,21 +284,24 @@ int quake_plane_c::BrushSide(csg_brush_c *B, float epsilon) const {
             float y = V->y;
             float z = k ? B->b.z : B->t.z;
 
-            float d = PointDist(x, y, z);
-
-            min_d = MIN(min_d, d);
-            max_d = MAX(max_d, d);
+            points.Add(x, y, z);
         }
     }
+}
 
-    if (min_d > -epsilon) {
-        return +1;
-    }
-    if (max_d < epsilon) {
-        return -1;
-    }
+static int PointsSide(const quake_plane_c &plane, csg_points_c &points,
+                      float epsilon) {
+    points.PlaneDist(plane.x, plane.y, plane.z, plane.nx, plane.ny, plane.nz);
 
-    return 0;
+    return points.Side(0, points.Size(), epsilon);
+}
+
+int quake_plane_c::BrushSide(csg_brush_c *B, float epsilon) const {
+    csg_points_c points;
+
+    GatherBrushPoints(B, points);
+
+    return PointsSide(*this, points, epsilon);
 }
 
 double quake_plane_c::CalcZ(double ax, double ay) const {
@@ -761,29 +765,6 @@ static void CheckClusterEdges(quake_group_c &group, int cx, int cy) {
     }
 }
 
-static int XY_BrushSide(const csg_brush_c *B, const quake_side_c *part) {
-    float min_d = +9e9;
-    float max_d = -9e9;
-
-    for (unsigned int i = 0; i < B->verts.size(); i++) {
-        brush_vert_c *V = B->verts[i];
-
-        float d = PerpDist(V->x, V->y, part->x1, part->y1, part->x2, part->y2);
-
-        min_d = MIN(min_d, d);
-        max_d = MAX(max_d, d);
-    }
-
-    if (min_d > -Q_EPSILON) {
-        return +1;
-    }
-    if (max_d < Q_EPSILON) {
-        return -1;
-    }
-
-    return 0;  // straddles
-}
-
 static quake_side_c *SplitSideAt(quake_side_c *S, float new_x, float new_y) {
     quake_side_c *T = new quake_side_c(S);
 
@@ -804,15 +785,33 @@ static void Split_XY(quake_group_c &group, quake_node_c *node,
     local_sides.swap(group.sides);
     local_brushes.swap(group.brushes);
 
+    // classify every side end and brush vertex in one go.
+    // the brush vertices follow the side ends.
+    csg_points_c points;
+
     for (unsigned int k = 0; k < local_sides.size(); k++) {
         quake_side_c *S = local_sides[k];
 
-        // get relationship of this side to the partition line
-        double a =
-            PerpDist(S->x1, S->y1, part->x1, part->y1, part->x2, part->y2);
+        points.Add(S->x1, S->y1);
+        points.Add(S->x2, S->y2);
+    }
+
+    for (unsigned int n = 0; n < local_brushes.size(); n++) {
+        csg_brush_c *B = local_brushes[n];
+
+        for (unsigned int i = 0; i < B->verts.size(); i++) {
+            points.Add(B->verts[i]->x, B->verts[i]->y);
+        }
+    }
 
-        double b =
-            PerpDist(S->x2, S->y2, part->x1, part->y1, part->x2, part->y2);
+    points.LineDist(part->x1, part->y1, part->x2, part->y2);
+
+    for (unsigned int k = 0; k < local_sides.size(); k++) {
+        quake_side_c *S = local_sides[k];
+
+        // get relationship of this side to the partition line
+        double a = points.dist[k * 2];
+        double b = points.dist[k * 2 + 1];
 
         int a_side = (a < -Q_EPSILON) ? -1 : (a > Q_EPSILON) ? +1 : 0;
         int b_side = (b < -Q_EPSILON) ? -1 : (b > Q_EPSILON) ? +1 : 0;
@@ -885,10 +884,16 @@ static void Split_XY(quake_group_c &group, quake_node_c *node,
         AddIntersection(cut_list, part, T, 0, a_side, K1_NORMAL);
     }
 
+    unsigned int first = (unsigned int)local_sides.size() * 2;
+
     for (unsigned int n = 0; n < local_brushes.size(); n++) {
         csg_brush_c *B = local_brushes[n];
 
-        int side = XY_BrushSide(B, part);
+        unsigned int count = (unsigned int)B->verts.size();
+
+        int side = points.Side(first, count, Q_EPSILON);
+
+        first += count;
 
         if (side <= 0) {
             back.AddBrush(B);
@@ -1258,9 +1263,35 @@ bool quake_face_c::IntersectRay(float x1, float y1, float z1, float x2,
     return true;
 }
 
-static void DoAddFace(quake_face_c *F, csg_property_set_c *props,
-                      uv_matrix_c *uv_mat, quake_node_c *node,
-                      quake_leaf_c *leaf) {
+//------------------------------------------------------------------------
+
+// The subtree for a single cluster, which is built on its own thread.
+// Everything it would add to shared structures (faces on nodes above
+// the cluster, qk_all_faces, the cluster's leafs, the log) is recorded
+// here instead, and gets applied in tree order once all clusters are
+// done.  Hence the result is the same as a single-threaded build.
+struct cluster_build_t {
+    quake_group_c group;
+    qCluster_c *cluster;
+
+    // where the subtree goes
+    quake_node_c *parent;
+    int parent_side;
+
+    quake_node_c *root;
+
+    std::vector<quake_face_c *> faces;
+    std::vector<quake_node_c *> face_nodes;
+
+    std::vector<quake_leaf_c *> leafs;
+    std::vector<int> ambients;
+
+    std::vector<std::string> warnings;
+};
+
+static void DoAddFace(cluster_build_t &build, quake_face_c *F,
+                      csg_property_set_c *props, uv_matrix_c *uv_mat,
+                      quake_node_c *node, quake_leaf_c *leaf) {
     F->plane = node->plane;
     if (F->node_side == 1) {
         F->plane.Flip();
@@ -1274,14 +1305,15 @@ static void DoAddFace(quake_face_c *F, csg_property_set_c *props,
         F->SetupMatrix();
     }
 
-    node->AddFace(F);
     leaf->AddFace(F);
 
-    qk_all_faces.push_back(F);
+    // node may be above the cluster, see MergeClusterBuild()
+    build.faces.push_back(F);
+    build.face_nodes.push_back(node);
 }
 
-static void FloorOrCeilFace(quake_node_c *node, quake_leaf_c *leaf,
-                            csg_brush_c *B, bool is_ceil,
+static void FloorOrCeilFace(cluster_build_t &build, quake_node_c *node,
+                            quake_leaf_c *leaf, csg_brush_c *B, bool is_ceil,
                             std::vector<quake_vertex_c> &winding,
                             bool is_liquid = false) {
     // get node splitting plane
@@ -1314,20 +1346,21 @@ static void FloorOrCeilFace(quake_node_c *node, quake_leaf_c *leaf,
         F->flags |= FACE_F_Sky;
     }
 
-    DoAddFace(F, &BP.face, BP.uv_mat, node, leaf);
+    DoAddFace(build, F, &BP.face, BP.uv_mat, node, leaf);
 }
 
-static void FloorOrCeilFace(quake_node_c *node, quake_leaf_c *leaf,
-                            const gap_c *G, bool is_ceil,
+static void FloorOrCeilFace(cluster_build_t &build, quake_node_c *node,
+                            quake_leaf_c *leaf, const gap_c *G, bool is_ceil,
                             std::vector<quake_vertex_c> &winding) {
     csg_brush_c *B = is_ceil ? G->top : G->bottom;
 
-    FloorOrCeilFace(node, leaf, B, is_ceil, winding);
+    FloorOrCeilFace(build, node, leaf, B, is_ceil, winding);
 }
 
-static void WallFace_Quad(quake_node_c *node, quake_leaf_c *leaf,
-                          quake_side_c *S, brush_vert_c *bvert, double L_bz,
-                          double L_tz, double R_bz, double R_tz) {
+static void WallFace_Quad(cluster_build_t &build, quake_node_c *node,
+                          quake_leaf_c *leaf, quake_side_c *S,
+                          brush_vert_c *bvert, double L_bz, double L_tz,
+                          double R_bz, double R_tz) {
     int tri_side = 0;
 
     if (fabs(L_tz - L_bz) < Z_EPSILON) {
@@ -1359,7 +1392,7 @@ static void WallFace_Quad(quake_node_c *node, quake_leaf_c *leaf,
         F->flags |= FACE_F_Sky;
     }
 
-    DoAddFace(F, &bvert->face, bvert->uv_mat, node, leaf);
+    DoAddFace(build, F, &bvert->face, bvert->uv_mat, node, leaf);
 }
 
 static int CheckEdgeIntersect(double g_z1, double g_z2, double f_z1,
@@ -1395,8 +1428,9 @@ static void DoAddVertex(quake_face_c *F, quake_side_c *S, double along,
     F->AddVert(x, y, z);
 }
 
-static void ClipWallFace(quake_node_c *node, quake_leaf_c *leaf,
-                         quake_side_c *S, brush_vert_c *bvert, double g_Lz1,
+static void ClipWallFace(cluster_build_t &build, quake_node_c *node,
+                         quake_leaf_c *leaf, quake_side_c *S,
+                         brush_vert_c *bvert, double g_Lz1,
                          double g_Lz2, /* gap */
                          double g_Rz1, double g_Rz2, double f_Lz1,
                          double f_Lz2, /* face */
@@ -1429,11 +1463,11 @@ static void ClipWallFace(quake_node_c *node, quake_leaf_c *leaf,
         double f_Lmz = (f_Lz1 + f_Lz2) * 0.5;
         double f_Rmz = (f_Rz1 + f_Rz2) * 0.5;
 
-        ClipWallFace(node, leaf, S, bvert, g_Lz1, g_Lz2, g_Rz1, g_Rz2, f_Lz1,
-                     f_Lmz, f_Rz1, f_Rmz);
+        ClipWallFace(build, node, leaf, S, bvert, g_Lz1, g_Lz2, g_Rz1, g_Rz2,
+                     f_Lz1, f_Lmz, f_Rz1, f_Rmz);
 
-        ClipWallFace(node, leaf, S, bvert, g_Lz1, g_Lz2, g_Rz1, g_Rz2, f_Lmz,
-                     f_Lz2, f_Rmz, f_Rz2);
+        ClipWallFace(build, node, leaf, S, bvert, g_Lz1, g_Lz2, g_Rz1, g_Rz2,
+                     f_Lmz, f_Lz2, f_Rmz, f_Rz2);
         return;
     }
 
@@ -1465,7 +1499,8 @@ static void ClipWallFace(quake_node_c *node, quake_leaf_c *leaf,
             f_Rz2 = g_Rz2;
         }
 
-        WallFace_Quad(node, leaf, S, bvert, f_Lz1, f_Lz2, f_Rz1, f_Rz2);
+        WallFace_Quad(build, node, leaf, S, bvert, f_Lz1, f_Lz2, f_Rz1,
+                      f_Rz2);
         return;
     }
 
@@ -1555,7 +1590,7 @@ static void ClipWallFace(quake_node_c *node, quake_leaf_c *leaf,
 
     F->node_side = S->node_side;
 
-    DoAddFace(F, &bvert->face, bvert->uv_mat, node, leaf);
+    DoAddFace(build, F, &bvert->face, bvert->uv_mat, node, leaf);
 }
 
 typedef struct {
@@ -1672,8 +1707,8 @@ static void Potface_TryMerge(potential_face_t *A, potential_face_t *B) {
     A->Rz2 = MAX(A->Rz2, B->Rz2);
 }
 
-static void CreateWallFaces(quake_group_c &group, quake_leaf_c *leaf,
-                            quake_side_c *S, gap_c *G) {
+static void CreateWallFaces(cluster_build_t &build, quake_group_c &group,
+                            quake_leaf_c *leaf, quake_side_c *S, gap_c *G) {
     SYS_ASSERT(S->on_node);
 
     if (!S->snag) {  // "mini sides" never have faces
@@ -1721,9 +1756,9 @@ static void CreateWallFaces(quake_group_c &group, quake_leaf_c *leaf,
     // clip them to the gap
     for (unsigned int k = 0; k < pots.size(); k++) {
         if (pots[k].bvert) {
-            ClipWallFace(S->on_node, leaf, S, pots[k].bvert, g_Lz1, g_Lz2,
-                         g_Rz1, g_Rz2, pots[k].Lz1, pots[k].Lz2, pots[k].Rz1,
-                         pots[k].Rz2);
+            ClipWallFace(build, S->on_node, leaf, S, pots[k].bvert, g_Lz1,
+                         g_Lz2, g_Rz1, g_Rz2, pots[k].Lz1, pots[k].Lz2,
+                         pots[k].Rz1, pots[k].Rz2);
         }
     }
 }
@@ -1759,7 +1794,8 @@ void quake_leaf_c::FilterBrush(csg_brush_c *B, leaf_map_t *touched) {
     (*touched)[this] = 1;
 }
 
-static int ParseLiquidMedium(csg_property_set_c *props) {
+static int ParseLiquidMedium(cluster_build_t &build,
+                             csg_property_set_c *props) {
     std::string str = props->getStr("medium");
 
     if (!str.empty()) {
@@ -1775,7 +1811,8 @@ static int ParseLiquidMedium(csg_property_set_c *props) {
             return MEDIUM_LAVA;
         }
 
-        LogPrintf("WARNING: unknown liquid medium '{}'\n", str);
+        build.warnings.push_back(
+            fmt::format("WARNING: unknown liquid medium '{}'\n", str));
     }
 
     return MEDIUM_WATER;  // the default
@@ -1800,7 +1837,8 @@ static quake_leaf_c *Solid_Wall_Leaf(quake_group_c &group) {
     return leaf;
 }
 
-static quake_leaf_c *Solid_FloorOrCeil(region_c *R, unsigned int g, int is_ceil,
+static quake_leaf_c *Solid_FloorOrCeil(cluster_build_t &build, region_c *R,
+                                       unsigned int g, int is_ceil,
                                        quake_group_c &group) {
     if (qk_game == 1) {
         return qk_solid_leaf;
@@ -1838,7 +1876,8 @@ static quake_leaf_c *Solid_FloorOrCeil(region_c *R, unsigned int g, int is_ceil,
 
     // this should not happen..... but handle it anyway
     if (leaf->brushes.empty()) {
-        LogPrintf("WARNING: solid brush for floor/ceiling is AWOL!\n");
+        build.warnings.push_back(
+            "WARNING: solid brush for floor/ceiling is AWOL!\n");
 
         leaf->AddBrush(is_ceil ? R->gaps[g]->top : R->gaps[g]->bottom);
     }
@@ -1862,8 +1901,8 @@ static quake_node_c *Solid_Node(quake_group_c &group) {
     return node;
 }
 
-static quake_node_c *CreateLeaf(region_c *R, int g /* gap */,
-                                quake_group_c &group,
+static quake_node_c *CreateLeaf(cluster_build_t &build, region_c *R,
+                                int g /* gap */, quake_group_c &group,
                                 std::vector<quake_vertex_c> &winding,
                                 quake_bbox_c &bbox, qCluster_c *cluster,
                                 quake_node_c *prev_N, quake_leaf_c *prev_L) {
@@ -1871,11 +1910,13 @@ static quake_node_c *CreateLeaf(region_c *R, int g /* gap */,
 
     quake_leaf_c *leaf = new quake_leaf_c(MEDIUM_AIR);
 
-    cluster->AddLeaf(leaf);
+    SYS_ASSERT(cluster == build.cluster);
+
+    build.leafs.push_back(leaf);
 
     // create faces for the walls in this leaf
     for (unsigned int s = 0; s < group.sides.size(); s++) {
-        CreateWallFaces(group, leaf, group.sides[s], gap);
+        CreateWallFaces(build, group, leaf, group.sides[s], gap);
     }
 
     quake_node_c *F_node = new quake_node_c;
@@ -1907,7 +1948,7 @@ static quake_node_c *CreateLeaf(region_c *R, int g /* gap */,
 
         // FIXME: in Q1/Q2, all lower leafs should get this medium
 
-        int medium = ParseLiquidMedium(&gap->liquid->props);
+        int medium = ParseLiquidMedium(build, &gap->liquid->props);
 
         if (is_above) {
             // the liquid covers the whole gap : don't need an extra leaf/node
@@ -1917,7 +1958,7 @@ static quake_node_c *CreateLeaf(region_c *R, int g /* gap */,
                 leaf->AddBrush(gap->liquid);
             }
 
-            cluster->MarkAmbient(AMBIENT_WATER);
+            build.ambients.push_back(AMBIENT_WATER);
         } else {
             // this liquid surface lies within this gap
             // (above the floor and below the ceiling)
@@ -1935,18 +1976,19 @@ static quake_node_c *CreateLeaf(region_c *R, int g /* gap */,
                 L_leaf->AddBrush(gap->liquid);
             }
 
-            cluster->AddLeaf(L_leaf);
-            cluster->MarkAmbient(AMBIENT_WATER);
+            build.leafs.push_back(L_leaf);
+            build.ambients.push_back(AMBIENT_WATER);
 
-            FloorOrCeilFace(L_node, L_leaf, gap->liquid, true, winding,
+            FloorOrCeilFace(build, L_node, L_leaf, gap->liquid, true, winding,
                             true /* is_liquid */);
-            FloorOrCeilFace(L_node, leaf, gap->liquid, false, winding,
+            FloorOrCeilFace(build, L_node, leaf, gap->liquid, false, winding,
                             true /* is_liquid */);
         }
     }
 
-    FloorOrCeilFace(C_node, leaf, gap, true, winding);
-    FloorOrCeilFace(F_node, L_leaf ? L_leaf : leaf, gap, false, winding);
+    FloorOrCeilFace(build, C_node, leaf, gap, true, winding);
+    FloorOrCeilFace(build, F_node, L_leaf ? L_leaf : leaf, gap, false,
+                    winding);
 
     // link nodes together
 
@@ -1958,7 +2000,7 @@ static quake_node_c *CreateLeaf(region_c *R, int g /* gap */,
     F_node->front_N = L_node ? L_node : C_node;
 
     C_node->back_L = leaf;
-    F_node->back_L = Solid_FloorOrCeil(R, g, 0, group);
+    F_node->back_L = Solid_FloorOrCeil(build, R, g, 0, group);
 
     if (L_node) {
         L_node->front_N = C_node;
@@ -1968,14 +2010,15 @@ static quake_node_c *CreateLeaf(region_c *R, int g /* gap */,
     return F_node;
 }
 
-static quake_node_c *Partition_Z(quake_group_c &group, qCluster_c *cluster) {
+static quake_node_c *Partition_Z(cluster_build_t &build, quake_group_c &group,
+                                 qCluster_c *cluster) {
     region_c *R = group.FinalRegion();
 
     SYS_ASSERT(R);
 
     // THIS SHOULD NOT HAPPEN -- but handle it just in case
     if (R->gaps.size() == 0 || group.sides.size() < 3) {
-        LogPrintf("WARNING: bad group at Partition_Z\n");
+        build.warnings.push_back("WARNING: bad group at Partition_Z\n");
         return Solid_Node(group);
     }
 
@@ -1988,11 +2031,12 @@ static quake_node_c *Partition_Z(quake_group_c &group, qCluster_c *cluster) {
     CollectWinding(group, winding, bbox);
 
     quake_node_c *cur_node = NULL;
-    quake_leaf_c *cur_leaf = Solid_FloorOrCeil(R, R->gaps.size() - 1, 1, group);
+    quake_leaf_c *cur_leaf =
+        Solid_FloorOrCeil(build, R, R->gaps.size() - 1, 1, group);
 
     for (int i = (int)R->gaps.size() - 1; i >= 0; i--) {
-        cur_node =
-            CreateLeaf(R, i, group, winding, bbox, cluster, cur_node, cur_leaf);
+        cur_node = CreateLeaf(build, R, i, group, winding, bbox, cluster,
+                              cur_node, cur_leaf);
         cur_leaf = NULL;
     }
 
@@ -2015,8 +2059,9 @@ static const char *leaf_to_string(quake_leaf_c *L, quake_node_c *N) {
 }
 #endif
 
-static quake_node_c *Partition_Group(quake_group_c &group,
-                                     qCluster_c *reached_cluster = NULL,
+static quake_node_c *Partition_Group(cluster_build_t &build,
+                                     quake_group_c &group,
+                                     qCluster_c *reached_cluster,
                                      quake_node_c *parent = NULL,
                                      int parent_side = 0) {
     SYS_ASSERT(!group.sides.empty());
@@ -2045,13 +2090,13 @@ static quake_node_c *Partition_Group(quake_group_c &group,
 #endif
 
         new_node->front_N =
-            Partition_Group(front, reached_cluster, new_node, 0);
+            Partition_Group(build, front, reached_cluster, new_node, 0);
 
         if (back.sides.empty()) {
             new_node->back_L = Solid_Wall_Leaf(back);
         } else {
             new_node->back_N =
-                Partition_Group(back, reached_cluster, new_node, 1);
+                Partition_Group(build, back, reached_cluster, new_node, 1);
         }
 
 #if (NODE_DEBUG == 1)
@@ -2082,10 +2127,130 @@ static quake_node_c *Partition_Group(quake_group_c &group,
         }
 #endif
 
-        return Partition_Z(group, reached_cluster);
+        return Partition_Z(build, group, reached_cluster);
     }
 }
 
+static quake_node_c *Partition_Seeds(
+    quake_group_c &group, quake_node_c *parent, int parent_side,
+    std::vector<std::unique_ptr<cluster_build_t>> &builds) {
+    // this splits the group along seed boundaries until each piece is
+    // inside a single cluster.  Those pieces are not partitioned here,
+    // they are queued for Partition_Clusters() and the node is linked
+    // to its parent later.
+
+    SYS_ASSERT(!group.sides.empty());
+
+    quake_side_c part;
+    qCluster_c *reached_cluster = NULL;
+
+    bool found = FindPartition_XY(group, &part, &reached_cluster);
+
+    if (reached_cluster) {
+        std::unique_ptr<cluster_build_t> build(new cluster_build_t);
+
+        build->group.sides.swap(group.sides);
+        build->group.brushes.swap(group.brushes);
+
+        build->cluster = reached_cluster;
+        build->parent = parent;
+        build->parent_side = parent_side;
+        build->root = NULL;
+
+        builds.push_back(std::move(build));
+
+        return NULL;
+    }
+
+    if (!found) {
+        Main::FatalError("Quake build failure: no partition between seeds\n");
+    }
+
+    quake_plane_c p_plane;
+
+    part.ToPlane(&p_plane);
+
+    quake_node_c *new_node = new quake_node_c(p_plane);
+
+    quake_group_c front;
+    quake_group_c back;
+
+    Split_XY(group, new_node, &part, front, back);
+
+    SYS_ASSERT(!front.sides.empty());
+
+    new_node->front_N = Partition_Seeds(front, new_node, 0, builds);
+
+    if (back.sides.empty()) {
+        new_node->back_L = Solid_Wall_Leaf(back);
+    } else {
+        new_node->back_N = Partition_Seeds(back, new_node, 1, builds);
+    }
+
+    return new_node;
+}
+
+static void MergeClusterBuild(cluster_build_t &build) {
+    for (const std::string &msg : build.warnings) {
+        LogPrintf("{}", msg);
+    }
+
+    for (unsigned int i = 0; i < build.faces.size(); i++) {
+        build.face_nodes[i]->AddFace(build.faces[i]);
+
+        qk_all_faces.push_back(build.faces[i]);
+    }
+
+    for (quake_leaf_c *leaf : build.leafs) {
+        build.cluster->AddLeaf(leaf);
+    }
+
+    for (int kind : build.ambients) {
+        build.cluster->MarkAmbient(kind);
+    }
+}
+
+static quake_node_c *Partition_Clusters(quake_group_c &group) {
+    // the part of the tree above the clusters is done first (and is
+    // cheap), then the subtree of each cluster is built on its own
+    // thread.  They only share nodes above the clusters and the read
+    // only CSG data.
+
+    std::vector<std::unique_ptr<cluster_build_t>> builds;
+
+    quake_node_c *root = Partition_Seeds(group, NULL, 0, builds);
+
+    int total = (int)builds.size();
+
+    // the tree must be complete, so never stop early
+    QCOM_ParallelFor(total, INT_MAX, [&](int thread, int i) {
+        cluster_build_t &build = *builds[i];
+
+        build.root = Partition_Group(build, build.group, build.cluster);
+    });
+
+    // merge in the same order as a depth-first build
+    for (int i = 0; i < total; i++) {
+        cluster_build_t &build = *builds[i];
+
+        MergeClusterBuild(build);
+
+        if (!build.parent) {
+            SYS_ASSERT(total == 1);
+            root = build.root;
+        } else if (build.parent_side == 0) {
+            build.parent->front_N = build.root;
+        } else {
+            build.parent->back_N = build.root;
+        }
+    }
+
+    LogPrintf("Built BSP subtrees for {} clusters with {} threads\n", total,
+              QCOM_NumThreads(total));
+
+    return root;
+}
+
 //------------------------------------------------------------------------
 
 void quake_bbox_c::Begin() {
@@ -2205,26 +2370,36 @@ void quake_node_c::ComputeBBox() {
     bbox.End();
 }
 
-void quake_node_c::FilterBrush(csg_brush_c *B, leaf_map_t *touched) {
-    int side = plane.BrushSide(B);
+static void FilterBrushPoints(quake_node_c *node, csg_brush_c *B,
+                              csg_points_c &points, leaf_map_t *touched) {
+    int side = PointsSide(node->plane, points, 0.1);
 
     if (side >= 0) {
-        if (front_N) {
-            front_N->FilterBrush(B, touched);
-        } else if (front_L != qk_solid_leaf) {
-            front_L->FilterBrush(B, touched);
+        if (node->front_N) {
+            FilterBrushPoints(node->front_N, B, points, touched);
+        } else if (node->front_L != qk_solid_leaf) {
+            node->front_L->FilterBrush(B, touched);
         }
     }
 
     if (side <= 0) {
-        if (back_N) {
-            back_N->FilterBrush(B, touched);
-        } else if (back_L != qk_solid_leaf) {
-            back_L->FilterBrush(B, touched);
+        if (node->back_N) {
+            FilterBrushPoints(node->back_N, B, points, touched);
+        } else if (node->back_L != qk_solid_leaf) {
+            node->back_L->FilterBrush(B, touched);
         }
     }
 }
 
+void quake_node_c::FilterBrush(csg_brush_c *B, leaf_map_t *touched) {
+    // the brush is only gathered once, for all the nodes
+    csg_points_c points;
+
+    GatherBrushPoints(B, points);
+
+    FilterBrushPoints(this, B, points, touched);
+}
+
 static void AssignLeafIndex(quake_leaf_c *leaf, int *cur_leaf) {
     SYS_ASSERT(leaf);
 
@@ -2587,7 +2762,7 @@ void CSG_QUAKE_Build() {
     LogPrintf("begin_node_stuff\n");
 #endif
 
-    qk_bsp_root = Partition_Group(GROUP, NULL, NULL, 0);
+    qk_bsp_root = Partition_Clusters(GROUP);
 
 #if (NODE_DEBUG == 1)
     LogPrintf("root = {}\n", static_cast<const void *>(qk_bsp_root));
@@ -53,10 +53,14 @@ extern int spot_high_h;
 // number of grid squares
 static int grid_W, grid_H;
 
-static byte **spot_grid;
+// the grid is stored row by row, so that filling a span of a row is a
+// single run of memory.  the memory is kept for the next grid.
+static std::vector<byte> spot_grid;
 
-static int *grid_lefties;
-static int *grid_righties;
+#define SPOT_CELL(x, y) spot_grid[(y) * grid_W + (x)]
+
+static std::vector<int> grid_lefties;
+static std::vector<int> grid_righties;
 
 // declare this here (don't pull in all CSG headers)
 extern void CSG_spot_processing(int x1, int y1, int x2, int y2, int floor_h);
@@ -79,28 +83,15 @@ void SPOT_CreateGrid(byte content, int min_x, int min_y, int max_x, int max_y) {
     grid_H += 2;
 #endif
 
-    spot_grid = new byte *[grid_W];
-
-    for (int x = 0; x < grid_W; x++) {
-        spot_grid[x] = new byte[grid_H];
-
-        memset(spot_grid[x], content, grid_H);
-    }
+    spot_grid.assign(grid_W * grid_H, content);
 
-    grid_lefties = new int[grid_H];
-    grid_righties = new int[grid_H];
+    grid_lefties.resize(grid_H);
+    grid_righties.resize(grid_H);
 }
 
 void SPOT_FreeGrid() {
-    if (spot_grid) {
-        for (int x = 0; x < grid_W; x++) {
-            delete[] spot_grid[x];
-        }
-
-        delete[] spot_grid;
-
-        spot_grid = NULL;
-    }
+    // keep the memory around, the next SPOT_CreateGrid() will reuse it
+    spot_grid.clear();
 }
 
 void SPOT_DumpGrid(const char *info) {
@@ -115,7 +106,7 @@ void SPOT_DumpGrid(const char *info) {
         int width = MIN(MAX_WIDTH, grid_W);
 
         for (int x = 0; x < width; x++) {
-            byte content = spot_grid[x][y];
+            byte content = SPOT_CELL(x, y);
 
             if (content & HAS_MON) {
                 buffer[x] = 'm';
@@ -159,7 +150,7 @@ static void test_item_spot(int x, int y, std::vector<grid_point_c> &spots) {
 
     for (int dx = 0; dx < 2; dx++) {
         for (int dy = 0; dy < 2; dy++) {
-            byte content = spot_grid[x + dx][y + dy];
+            byte content = SPOT_CELL(x + dx, y + dy);
 
             if (content & (7 | HAS_ITEM)) {
                 return;  // no good, something in the way
@@ -188,17 +179,15 @@ static void test_item_spot(int x, int y, std::vector<grid_point_c> &spots) {
     spots.push_back(grid_point_c(real_x, real_y));
 
     // reserve these cells, prevent overlapping item spots
-    spot_grid[x + 0][y + 0] |= HAS_ITEM;
-    spot_grid[x + 0][y + 1] |= HAS_ITEM;
-    spot_grid[x + 1][y + 0] |= HAS_ITEM;
-    spot_grid[x + 1][y + 1] |= HAS_ITEM;
+    SPOT_CELL(x + 0, y + 0) |= HAS_ITEM;
+    SPOT_CELL(x + 0, y + 1) |= HAS_ITEM;
+    SPOT_CELL(x + 1, y + 0) |= HAS_ITEM;
+    SPOT_CELL(x + 1, y + 1) |= HAS_ITEM;
 }
 
 static void clean_up_grid() {
-    for (int x = 0; x < grid_W; x++) {
-        for (int y = 0; y < grid_H; y++) {
-            spot_grid[x][y] &= 7;
-        }
+    for (byte &content : spot_grid) {
+        content &= 7;
     }
 }
 
@@ -214,19 +203,19 @@ void SPOT_ItemSpots(std::vector<grid_point_c> &spots) {
     // first, mark squares which are near a wall
     for (x = 0; x < grid_W; x++) {
         for (y = 0; y < grid_H; y++) {
-            if ((spot_grid[x][y] & 3) == SPOT_WALL) {
+            if ((SPOT_CELL(x, y) & 3) == SPOT_WALL) {
                 if (x > 0) {
-                    spot_grid[x - 1][y] |= NEAR_WALL;
+                    SPOT_CELL(x - 1, y) |= NEAR_WALL;
                 }
                 if (x < w2) {
-                    spot_grid[x + 1][y] |= NEAR_WALL;
+                    SPOT_CELL(x + 1, y) |= NEAR_WALL;
                 }
 
                 if (y > 0) {
-                    spot_grid[x][y - 1] |= NEAR_WALL;
+                    SPOT_CELL(x, y - 1) |= NEAR_WALL;
                 }
                 if (y < h2) {
-                    spot_grid[x][y + 1] |= NEAR_WALL;
+                    SPOT_CELL(x, y + 1) |= NEAR_WALL;
                 }
             }
         }
@@ -242,33 +231,54 @@ void SPOT_ItemSpots(std::vector<grid_point_c> &spots) {
 //----------------------------------------------------------------------
 
 static void remove_dud_cells() {
-    for (int x = 0; x < grid_W; x++) {
-        for (int y = 0; y < grid_H; y++) {
-            spot_grid[x][y] &= ~IS_DUD;
-        }
+    for (byte &content : spot_grid) {
+        content &= ~IS_DUD;
     }
 }
 
-static bool test_mon_area(int x1, int y1, int x2, int y2, int want) {
+// summed-area table of the cells which a monster cannot use, i.e. the
+// value at (x, y) is the number of blocked cells below and left of it.
+// biggest_gap() builds it while scanning the grid, and it stays valid
+// until the next mark_monster().  Which cells count as blocked depends
+// on the 'want' given to biggest_gap(), so the table only answers for
+// that 'want'.
+static std::vector<int> blocked_sums;
+
+#define BLOCKED_SUM(x, y) blocked_sums[(x) * (grid_H + 1) + (y)]
+
+static inline bool mon_cell_blocked(int x, int y, int want) {
+    byte content = SPOT_CELL(x, y);
+
+    if (content & (HAS_MON | IS_DUD)) {
+        return true;
+    }
+
+    return (content & 3) > want;
+}
+
+static bool test_mon_area(int x1, int y1, int x2, int y2) {
     if (x1 < 0 or x2 >= grid_W or y1 < 0 or y2 >= grid_H) {
         return false;
     }
 
-    for (int x = x1; x <= x2; x++) {
-        for (int y = y1; y <= y2; y++) {
-            byte content = spot_grid[x][y];
+    int count = BLOCKED_SUM(x2 + 1, y2 + 1) - BLOCKED_SUM(x1, y2 + 1) -
+                BLOCKED_SUM(x2 + 1, y1) + BLOCKED_SUM(x1, y1);
 
-            if (content & (HAS_MON | IS_DUD)) {
-                return false;
-            }
+    return (count == 0);
+}
 
-            if ((content & 3) > want) {
-                return false;
-            }
+static void sum_blocked_column(int x, int want) {
+    int column = 0;
+
+    BLOCKED_SUM(x + 1, 0) = 0;
+
+    for (int y = 0; y < grid_H; y++) {
+        if (mon_cell_blocked(x, y, want)) {
+            column++;
         }
-    }
 
-    return true;
+        BLOCKED_SUM(x + 1, y + 1) = BLOCKED_SUM(x, y + 1) + column;
+    }
 }
 
 static int biggest_gap(int *y1, int *y2, int want) {
@@ -278,19 +288,24 @@ static int biggest_gap(int *y1, int *y2, int want) {
     int best_x = -1;
     int best_num = 0;
 
+    blocked_sums.resize((grid_W + 1) * (grid_H + 1));
+
+    for (int y = 0; y <= grid_H; y++) {
+        BLOCKED_SUM(0, y) = 0;
+    }
+
     for (int x = 0; x < grid_W; x++) {
         int y = 0;
 
         while (y < grid_H - 1) {
-            if (!test_mon_area(x, y, x, y, want)) {
+            if (mon_cell_blocked(x, y, want)) {
                 y++;
                 continue;
             }
 
             int ey = y;
 
-            while (ey < grid_H - 1 &&
-                   test_mon_area(x, ey + 1, x, ey + 1, want)) {
+            while (ey < grid_H - 1 && !mon_cell_blocked(x, ey + 1, want)) {
                 ey++;
             }
 
@@ -298,7 +313,7 @@ static int biggest_gap(int *y1, int *y2, int want) {
 
             if (num == 1) {
                 // single squares are useless, remove them now
-                spot_grid[x][y] |= IS_DUD;
+                SPOT_CELL(x, y) |= IS_DUD;
             } else if (num > best_num) {
                 best_x = x;
                 best_num = num;
@@ -309,34 +324,38 @@ static int biggest_gap(int *y1, int *y2, int want) {
 
             y = ey + 1;
         }
+
+        // the column is finished (including new duds), so add it
+        sum_blocked_column(x, want);
     }
 
     return best_x;
 }
 
-static bool grow_spot(int &x1, int &y1, int &x2, int &y2, int want) {
+// uses the blocked_sums from the last biggest_gap() call
+static bool grow_spot(int &x1, int &y1, int &x2, int &y2) {
     // (passing parameters by reference for nicer code)
 
     // special case for initial square, try to become a 2x2 square
     // since that is the minimum requirement.
 
     if (x1 == x2 && y1 == y2) {
-        if (test_mon_area(x1, y1, x2 + 1, y2 + 1, want)) {
+        if (test_mon_area(x1, y1, x2 + 1, y2 + 1)) {
             x2++;
             y2++;
             return true;
         }
-        if (test_mon_area(x1, y1 - 1, x2 + 1, y2, want)) {
+        if (test_mon_area(x1, y1 - 1, x2 + 1, y2)) {
             x2++;
             y1--;
             return true;
         }
-        if (test_mon_area(x1 - 1, y1, x2, y2 + 1, want)) {
+        if (test_mon_area(x1 - 1, y1, x2, y2 + 1)) {
             x1--;
             y2++;
             return true;
         }
-        if (test_mon_area(x1 - 1, y1 - 1, x2, y2, want)) {
+        if (test_mon_area(x1 - 1, y1 - 1, x2, y2)) {
             x1--;
             y1--;
             return true;
@@ -392,20 +411,20 @@ static bool grow_spot(int &x1, int &y1, int &x2, int &y2, int want) {
     }
 
     for (int pass = 0; pass < 4; pass++) {
-        if (pass == x1_pass && test_mon_area(x1 - 1, y1, x1 - 1, y2, want)) {
+        if (pass == x1_pass && test_mon_area(x1 - 1, y1, x1 - 1, y2)) {
             x1--;
             return true;
         }
-        if (pass == x2_pass && test_mon_area(x2 + 1, y1, x2 + 1, y2, want)) {
+        if (pass == x2_pass && test_mon_area(x2 + 1, y1, x2 + 1, y2)) {
             x2++;
             return true;
         }
 
-        if (pass == y1_pass && test_mon_area(x1, y1 - 1, x2, y1 - 1, want)) {
+        if (pass == y1_pass && test_mon_area(x1, y1 - 1, x2, y1 - 1)) {
             y1--;
             return true;
         }
-        if (pass == y2_pass && test_mon_area(x1, y2 + 1, x2, y2 + 1, want)) {
+        if (pass == y2_pass && test_mon_area(x1, y2 + 1, x2, y2 + 1)) {
             y2++;
             return true;
         }
@@ -414,10 +433,11 @@ static bool grow_spot(int &x1, int &y1, int &x2, int &y2, int want) {
     return false;
 }
 
+// Note: this makes blocked_sums out of date.
 static void mark_monster(int x1, int y1, int x2, int y2, byte flag) {
     for (int x = x1; x <= x2; x++) {
         for (int y = y1; y <= y2; y++) {
-            spot_grid[x][y] |= flag;
+            SPOT_CELL(x, y) |= flag;
         }
     }
 }
@@ -442,12 +462,12 @@ void SPOT_MonsterSpots(std::vector<grid_point_c> &spots, int want) {
 
         y1 = (y1 + y2) / 2;
 
-        SYS_ASSERT((spot_grid[x1][y1] & 3) <= want);
+        SYS_ASSERT((SPOT_CELL(x1, y1) & 3) <= want);
 
         x2 = x1;
         y2 = y1;
 
-        while (grow_spot(x1, y1, x2, y2, want)) {
+        while (grow_spot(x1, y1, x2, y2)) {
         }
 
         if (x2 > x1 && y2 > y1) {
@@ -600,23 +620,27 @@ static void draw_line(int x1, int y1, int x2, int y2) {
     }
 }
 
-static inline void replace_cell(int x, int y, byte content) {
-    byte &target = spot_grid[x][y];
-
+static void fill_span(byte *cells, int count, byte content) {
     // Note : we allow SPOT_CLEAR to replace anything, though
     //        generally it is only used to initialize the grid.
-
-    // never replace a WALL
-    if (content != SPOT_CLEAR && target == SPOT_WALL) {
+    //        Putting a WALL over a WALL changes nothing, so both of
+    //        these can simply overwrite the span.
+    if (content == SPOT_CLEAR || content == SPOT_WALL) {
+        memset(cells, content, count);
         return;
     }
 
-    // LOW_CEIL cannot replace a LEDGE
-    if (content == SPOT_LOW_CEIL && target == SPOT_LEDGE) {
-        return;
-    }
+    // never replace a WALL, and LOW_CEIL cannot replace a LEDGE.
+    // [ written without branches so the compiler can vectorize it ]
+    bool is_low = (content == SPOT_LOW_CEIL);
 
-    target = content;
+    for (int i = 0; i < count; i++) {
+        byte target = cells[i];
+
+        bool keep = (target == SPOT_WALL) | (is_low & (target == SPOT_LEDGE));
+
+        cells[i] = keep ? target : content;
+    }
 }
 
 static void fill_rows(byte content) {
@@ -630,9 +654,11 @@ static void fill_rows(byte content) {
         int low_x = MAX(0, grid_lefties[y]);
         int high_x = MIN(w2, grid_righties[y]);
 
-        for (int x = low_x; x <= high_x; x++) {
-            replace_cell(x, y, content);
+        if (low_x > high_x) {
+            continue;
         }
+
+        fill_span(&SPOT_CELL(low_x, y), high_x - low_x + 1, content);
     }
 }
 
@@ -25,8 +25,10 @@
 #include <bitset>
 #include <string>
 
+#include "csg_main.h"
 #include "hdr_fltk.h"
 #include "lib_file.h"
+#include "lib_udmf.h"
 #include "lib_util.h"
 #include "lib_wad.h"
 #include "m_cookie.h"
@@ -63,15 +65,22 @@ static qLump_c *vertex_lump;
 static qLump_c *sector_lump;
 static qLump_c *sidedef_lump;
 static qLump_c *linedef_lump;
-static qLump_c *textmap_lump;
 static qLump_c *endmap_lump;
 
+// TEXTMAP is kept between levels so its buffer only grows once
+static udmf_writer_c textmap;
+
+// enough for most maps to fit without growing the buffer
+#define TEXTMAP_RESERVE (4 << 20)
+
 static int errors_seen;
 
 std::string current_engine;
 std::string map_format;
 bool build_nodes;
 bool build_reject;
+bool fast_nodes;
+bool node_cache;
 
 static bool UDMF_mode;
 
@@ -245,8 +254,6 @@ static void FreeLumps() {
         delete linedef_lump;
         linedef_lump = nullptr;
     } else {
-        delete textmap_lump;
-        textmap_lump = nullptr;
         delete endmap_lump;
         endmap_lump = nullptr;
     }
@@ -264,13 +271,14 @@ void Doom::BeginLevel() {
         linedef_lump = new qLump_c();
         sidedef_lump = new qLump_c();
     } else {
-        textmap_lump = new qLump_c();
+        textmap.Clear();
+        textmap.Reserve(TEXTMAP_RESERVE);
         if (sub_format == SUBFMT_Hexen) {
-            textmap_lump->Printf("namespace = \"Hexen\";\n\n");
+            textmap.Raw("namespace = \"Hexen\";\n\n");
         } else {
-            textmap_lump->Printf("namespace = \"ZDoomTranslated\";\n\n");
+            textmap.Raw("namespace = \"ZDoomTranslated\";\n\n");
             if (current_engine == "eternity") {
-                textmap_lump->Printf("ee_compat = true;\n\n");
+                textmap.Raw("ee_compat = true;\n\n");
             }
         }
         endmap_lump = new qLump_c();
@@ -287,7 +295,7 @@ void Doom::EndLevel(std::string_view level_name) {
     WriteLump(level_name, header_lump);
 
     if (UDMF_mode) {
-        WriteLump("TEXTMAP", textmap_lump);
+        WriteLump("TEXTMAP", textmap.GetBuffer(), textmap.GetSize());
     }
 
     if (not UDMF_mode) {
@@ -342,10 +350,10 @@ void Doom::AddVertex(int x, int y) {
         vert.y = LE_S16(y);
         vertex_lump->Append(&vert, sizeof(vert));
     } else {
-        textmap_lump->Printf("\nvertex\n{\n");
-        textmap_lump->Printf("\tx = %f;\n", (double)x);
-        textmap_lump->Printf("\ty = %f;\n", (double)y);
-        textmap_lump->Printf("}\n");
+        textmap.Begin("vertex");
+        textmap.AddCoord("x", x);
+        textmap.AddCoord("y", y);
+        textmap.End();
         udmf_vertexes += 1;
     }
 }
@@ -366,15 +374,15 @@ void Doom::AddSector(int f_h, std::string f_tex, int c_h, std::string c_tex,
         sec.tag = LE_S16(tag);
         sector_lump->Append(&sec, sizeof(sec));
     } else {
-        textmap_lump->Printf("\nsector\n{\n");
-        textmap_lump->Printf("\theightfloor = %d;\n", f_h);
-        textmap_lump->Printf("\theightceiling = %d;\n", c_h);
-        textmap_lump->Printf("\ttexturefloor = \"%s\";\n", f_tex.c_str());
-        textmap_lump->Printf("\ttextureceiling = \"%s\";\n", c_tex.c_str());
-        textmap_lump->Printf("\tlightlevel = %d;\n", light);
-        textmap_lump->Printf("\tspecial = %d;\n", special);
-        textmap_lump->Printf("\tid = %d;\n", tag);
-        textmap_lump->Printf("}\n");
+        textmap.Begin("sector");
+        textmap.AddInt("heightfloor", f_h, 0);
+        textmap.AddInt("heightceiling", c_h, 0);
+        textmap.AddString("texturefloor", f_tex);
+        textmap.AddString("textureceiling", c_tex);
+        textmap.AddInt("lightlevel", light, 160);
+        textmap.AddInt("special", special, 0);
+        textmap.AddInt("id", tag, 0);
+        textmap.End();
         udmf_sectors += 1;
     }
 }
@@ -394,14 +402,14 @@ void Doom::AddSidedef(int sector, std::string l_tex, std::string m_tex,
         side.y_offset = LE_S16(y_offset);
         sidedef_lump->Append(&side, sizeof(side));
     } else {
-        textmap_lump->Printf("\nsidedef\n{\n");
-        textmap_lump->Printf("\toffsetx = %d;\n", x_offset);
-        textmap_lump->Printf("\toffsety = %d;\n", y_offset);
-        textmap_lump->Printf("\ttexturetop = \"%s\";\n", u_tex.c_str());
-        textmap_lump->Printf("\ttexturemiddle = \"%s\";\n", m_tex.c_str());
-        textmap_lump->Printf("\ttexturebottom = \"%s\";\n", l_tex.c_str());
-        textmap_lump->Printf("\tsector = %d;\n", sector);
-        textmap_lump->Printf("}\n");
+        textmap.Begin("sidedef");
+        textmap.AddInt("offsetx", x_offset, 0);
+        textmap.AddInt("offsety", y_offset, 0);
+        textmap.AddString("texturetop", u_tex, "-");
+        textmap.AddString("texturemiddle", m_tex, "-");
+        textmap.AddString("texturebottom", l_tex, "-");
+        textmap.AddInt("sector", sector);
+        textmap.End();
         udmf_sidedefs += 1;
     }
 }
@@ -423,46 +431,26 @@ void Doom::AddLinedef(int vert1, int vert2, int side1, int side2, int type,
             line.tag = LE_U16(tag);
             linedef_lump->Append(&line, sizeof(line));
         } else {
-            textmap_lump->Printf("\nlinedef\n{\n");
-            textmap_lump->Printf("\tid = %d;\n", tag);
-            textmap_lump->Printf("\tv1 = %d;\n", vert1);
-            textmap_lump->Printf("\tv2 = %d;\n", vert2);
-            textmap_lump->Printf("\tsidefront = %d;\n", side1 < 0 ? -1 : side1);
-            textmap_lump->Printf("\tsideback = %d;\n", side2 < 0 ? -1 : side2);
-            textmap_lump->Printf("\targ0 = %d;\n", tag);
-            textmap_lump->Printf("\tspecial = %d;\n", type);
+            textmap.Begin("linedef");
+            textmap.AddInt("id", tag, -1);
+            textmap.AddInt("v1", vert1);
+            textmap.AddInt("v2", vert2);
+            textmap.AddInt("sidefront", side1 < 0 ? -1 : side1);
+            textmap.AddInt("sideback", side2 < 0 ? -1 : side2, -1);
+            textmap.AddInt("arg0", tag, 0);
+            textmap.AddInt("special", type, 0);
             std::bitset<16> udmf_flags(flags);
-            if (udmf_flags.test(0)) {
-                textmap_lump->Printf("\tblocking = true;\n");
-            }
-            if (udmf_flags.test(1)) {
-                textmap_lump->Printf("\tblockmonsters = true;\n");
-            }
-            if (udmf_flags.test(2)) {
-                textmap_lump->Printf("\ttwosided = true;\n");
-            }
-            if (udmf_flags.test(3)) {
-                textmap_lump->Printf("\tdontpegtop = true;\n");
-            }
-            if (udmf_flags.test(4)) {
-                textmap_lump->Printf("\tdontpegbottom = true;\n");
-            }
-            if (udmf_flags.test(5)) {
-                textmap_lump->Printf("\tsecret = true;\n");
-            }
-            if (udmf_flags.test(6)) {
-                textmap_lump->Printf("\tblocksound = true;\n");
-            }
-            if (udmf_flags.test(7)) {
-                textmap_lump->Printf("\tdontdraw = true;\n");
-            }
-            if (udmf_flags.test(8)) {
-                textmap_lump->Printf("\tmapped = true;\n");
-            }
-            if (udmf_flags.test(9)) {
-                textmap_lump->Printf("\tpassuse = true;\n");
-            }
-            textmap_lump->Printf("}\n");
+            textmap.AddFlag("blocking", udmf_flags.test(0));
+            textmap.AddFlag("blockmonsters", udmf_flags.test(1));
+            textmap.AddFlag("twosided", udmf_flags.test(2));
+            textmap.AddFlag("dontpegtop", udmf_flags.test(3));
+            textmap.AddFlag("dontpegbottom", udmf_flags.test(4));
+            textmap.AddFlag("secret", udmf_flags.test(5));
+            textmap.AddFlag("blocksound", udmf_flags.test(6));
+            textmap.AddFlag("dontdraw", udmf_flags.test(7));
+            textmap.AddFlag("mapped", udmf_flags.test(8));
+            textmap.AddFlag("passuse", udmf_flags.test(9));
+            textmap.End();
             udmf_linedefs += 1;
         }
     } else  // Hexen format
@@ -490,78 +478,44 @@ void Doom::AddLinedef(int vert1, int vert2, int side1, int side2, int type,
 
             linedef_lump->Append(&line, sizeof(line));
         } else {
-            textmap_lump->Printf("\nlinedef\n{\n");
-            if (type == 121) {
-                textmap_lump->Printf("\tid = %d;\n", args[0]);
-            }
-            textmap_lump->Printf("\tv1 = %d;\n", vert1);
-            textmap_lump->Printf("\tv2 = %d;\n", vert2);
-            textmap_lump->Printf("\tsidefront = %d;\n", side1 < 0 ? -1 : side1);
-            textmap_lump->Printf("\tsideback = %d;\n", side2 < 0 ? -1 : side2);
+            textmap.Begin("linedef");
             if (type == 121) {
-                textmap_lump->Printf("\tspecial = 0;\n");
-                textmap_lump->Printf("\targ0 = 0;\n");
-            } else {
-                textmap_lump->Printf("\tspecial = %d;\n", type);
-                textmap_lump->Printf("\targ0 = %d;\n", args[0]);
-            }
-            textmap_lump->Printf("\targ1 = %d;\n", args[1]);
-            textmap_lump->Printf("\targ2 = %d;\n", args[2]);
-            textmap_lump->Printf("\targ3 = %d;\n", args[3]);
-            textmap_lump->Printf("\targ4 = %d;\n", args[4]);
+                textmap.AddInt("id", args[0], -1);
+            }
+            textmap.AddInt("v1", vert1);
+            textmap.AddInt("v2", vert2);
+            textmap.AddInt("sidefront", side1 < 0 ? -1 : side1);
+            textmap.AddInt("sideback", side2 < 0 ? -1 : side2, -1);
+            // Line_SetIdentification (121) only carries the id
+            if (type != 121) {
+                textmap.AddInt("special", type, 0);
+                textmap.AddInt("arg0", args[0], 0);
+            }
+            textmap.AddInt("arg1", args[1], 0);
+            textmap.AddInt("arg2", args[2], 0);
+            textmap.AddInt("arg3", args[3], 0);
+            textmap.AddInt("arg4", args[4], 0);
             std::bitset<16> udmf_flags(flags);
-            if (udmf_flags.test(0)) {
-                textmap_lump->Printf("\tblocking = true;\n");
-            }
-            if (udmf_flags.test(1)) {
-                textmap_lump->Printf("\tblockmonsters = true;\n");
-            }
-            if (udmf_flags.test(2)) {
-                textmap_lump->Printf("\ttwosided = true;\n");
-            }
-            if (udmf_flags.test(3)) {
-                textmap_lump->Printf("\tdontpegtop = true;\n");
-            }
-            if (udmf_flags.test(4)) {
-                textmap_lump->Printf("\tdontpegbottom = true;\n");
-            }
-            if (udmf_flags.test(5)) {
-                textmap_lump->Printf("\tsecret = true;\n");
-            }
-            if (udmf_flags.test(6)) {
-                textmap_lump->Printf("\tblocksound = true;\n");
-            }
-            if (udmf_flags.test(7)) {
-                textmap_lump->Printf("\tdontdraw = true;\n");
-            }
-            if (udmf_flags.test(8)) {
-                textmap_lump->Printf("\tmapped = true;\n");
-            }
-            if (udmf_flags.test(9)) {
-                textmap_lump->Printf("\trepeatspecial = true;\n");
-            }
+            textmap.AddFlag("blocking", udmf_flags.test(0));
+            textmap.AddFlag("blockmonsters", udmf_flags.test(1));
+            textmap.AddFlag("twosided", udmf_flags.test(2));
+            textmap.AddFlag("dontpegtop", udmf_flags.test(3));
+            textmap.AddFlag("dontpegbottom", udmf_flags.test(4));
+            textmap.AddFlag("secret", udmf_flags.test(5));
+            textmap.AddFlag("blocksound", udmf_flags.test(6));
+            textmap.AddFlag("dontdraw", udmf_flags.test(7));
+            textmap.AddFlag("mapped", udmf_flags.test(8));
+            textmap.AddFlag("repeatspecial", udmf_flags.test(9));
             int spac = (flags & 0x1C00) >> 10;
             if (type > 0) {
-                if (spac == 0) {
-                    textmap_lump->Printf("\tplayercross = true;\n");
-                }
-                if (spac == 1) {
-                    textmap_lump->Printf("\tplayeruse = true;\n");
-                }
-                if (spac == 2) {
-                    textmap_lump->Printf("\tmonstercross = true;\n");
-                }
-                if (spac == 3) {
-                    textmap_lump->Printf("\timpact = true;\n");
-                }
-                if (spac == 4) {
-                    textmap_lump->Printf("\tplayerpush = true;\n");
-                }
-                if (spac == 5) {
-                    textmap_lump->Printf("\tmissilecross = true;\n");
-                }
-            }
-            textmap_lump->Printf("}\n");
+                textmap.AddFlag("playercross", spac == 0);
+                textmap.AddFlag("playeruse", spac == 1);
+                textmap.AddFlag("monstercross", spac == 2);
+                textmap.AddFlag("impact", spac == 3);
+                textmap.AddFlag("playerpush", spac == 4);
+                textmap.AddFlag("missilecross", spac == 5);
+            }
+            textmap.End();
             udmf_linedefs += 1;
         }
     }
@@ -586,50 +540,28 @@ void Doom::AddThing(int x, int y, int h, int type, int angle, int options,
             thing.options = LE_U16(options);
             thing_lump->Append(&thing, sizeof(thing));
         } else {
-            textmap_lump->Printf("\nthing\n{\n");
-            textmap_lump->Printf("\tx = %f;\n", (double)x);
-            textmap_lump->Printf("\ty = %f;\n", (double)y);
-            textmap_lump->Printf("\ttype = %d;\n", type);
-            textmap_lump->Printf("\tangle = %d;\n", angle);
+            textmap.Begin("thing");
+            textmap.AddCoord("x", x);
+            textmap.AddCoord("y", y);
+            textmap.AddInt("type", type);
+            textmap.AddInt("angle", angle, 0);
             std::bitset<16> udmf_flags(options);
-            if (udmf_flags.test(0)) {
-                textmap_lump->Printf("\tskill1 = true;\n");
-                textmap_lump->Printf("\tskill2 = true;\n");
-            }
-            if (udmf_flags.test(1)) {
-                textmap_lump->Printf("\tskill3 = true;\n");
-            }
-            if (udmf_flags.test(2)) {
-                textmap_lump->Printf("\tskill4 = true;\n");
-                textmap_lump->Printf("\tskill5 = true;\n");
-            }
-            if (udmf_flags.test(3)) {
-                textmap_lump->Printf("\tambush = true;\n");
-            }
-            if (udmf_flags.test(4)) {
-                textmap_lump->Printf("\tsingle = false;\n");
-            } else {
-                textmap_lump->Printf("\tsingle = true;\n");
-            }
-            if (udmf_flags.test(5)) {
-                textmap_lump->Printf("\tdm = false;\n");
-            } else {
-                textmap_lump->Printf("\tdm = true;\n");
-            }
-            if (udmf_flags.test(6)) {
-                textmap_lump->Printf("\tcoop = false;\n");
-            } else {
-                textmap_lump->Printf("\tcoop = true;\n");
-            }
-            if (udmf_flags.test(7)) {
-                textmap_lump->Printf("\tfriend = true;\n");
-            }
+            textmap.AddFlag("skill1", udmf_flags.test(0));
+            textmap.AddFlag("skill2", udmf_flags.test(0));
+            textmap.AddFlag("skill3", udmf_flags.test(1));
+            textmap.AddFlag("skill4", udmf_flags.test(2));
+            textmap.AddFlag("skill5", udmf_flags.test(2));
+            textmap.AddFlag("ambush", udmf_flags.test(3));
+            textmap.AddFlag("single", !udmf_flags.test(4));
+            textmap.AddFlag("dm", !udmf_flags.test(5));
+            textmap.AddFlag("coop", !udmf_flags.test(6));
+            textmap.AddFlag("friend", udmf_flags.test(7));
             // Testing fix for compatibility with ZDoom mods that add classes in
             // games other than Hexen
-            textmap_lump->Printf("\tclass1 = true;\n");
-            textmap_lump->Printf("\tclass2 = true;\n");
-            textmap_lump->Printf("\tclass3 = true;\n");
-            textmap_lump->Printf("}\n");
+            textmap.AddFlag("class1", true);
+            textmap.AddFlag("class2", true);
+            textmap.AddFlag("class3", true);
+            textmap.End();
             udmf_things += 1;
         }
     } else  // Hexen format
@@ -657,58 +589,36 @@ void Doom::AddThing(int x, int y, int h, int type, int angle, int options,
 
             thing_lump->Append(&thing, sizeof(thing));
         } else {
-            textmap_lump->Printf("\nthing\n{\n");
-            textmap_lump->Printf("\tid = %d;\n", tid);
-            textmap_lump->Printf("\tx = %f;\n", (double)x);
-            textmap_lump->Printf("\ty = %f;\n", (double)y);
-            textmap_lump->Printf("\theight = %f;\n", (double)h);
-            textmap_lump->Printf("\ttype = %d;\n", type);
-            textmap_lump->Printf("\tangle = %d;\n", angle);
+            textmap.Begin("thing");
+            textmap.AddInt("id", tid, 0);
+            textmap.AddCoord("x", x);
+            textmap.AddCoord("y", y);
+            textmap.AddCoord("height", h, 0);
+            textmap.AddInt("type", type);
+            textmap.AddInt("angle", angle, 0);
             std::bitset<16> udmf_flags(options);
-            if (udmf_flags.test(0)) {
-                textmap_lump->Printf("\tskill1 = true;\n");
-                textmap_lump->Printf("\tskill2 = true;\n");
-            }
-            if (udmf_flags.test(1)) {
-                textmap_lump->Printf("\tskill3 = true;\n");
-            }
-            if (udmf_flags.test(2)) {
-                textmap_lump->Printf("\tskill4 = true;\n");
-                textmap_lump->Printf("\tskill5 = true;\n");
-            }
-            if (udmf_flags.test(3)) {
-                textmap_lump->Printf("\tambush = true;\n");
-            }
-            if (udmf_flags.test(4)) {
-                textmap_lump->Printf("\tdormant = true;\n");
-            }
-            if (udmf_flags.test(5)) {
-                textmap_lump->Printf("\tclass1 = true;\n");
-            }
-            if (udmf_flags.test(6)) {
-                textmap_lump->Printf("\tclass2 = true;\n");
-            }
-            if (udmf_flags.test(7)) {
-                textmap_lump->Printf("\tclass3 = true;\n");
-            }
-            if (udmf_flags.test(8)) {
-                textmap_lump->Printf("\tsingle = true;\n");
-            }
-            if (udmf_flags.test(9)) {
-                textmap_lump->Printf("\tcoop = true;\n");
-            }
-            if (udmf_flags.test(10)) {
-                textmap_lump->Printf("\tdm = true;\n");
-            }
-            textmap_lump->Printf("\tspecial = %d;\n", special);
+            textmap.AddFlag("skill1", udmf_flags.test(0));
+            textmap.AddFlag("skill2", udmf_flags.test(0));
+            textmap.AddFlag("skill3", udmf_flags.test(1));
+            textmap.AddFlag("skill4", udmf_flags.test(2));
+            textmap.AddFlag("skill5", udmf_flags.test(2));
+            textmap.AddFlag("ambush", udmf_flags.test(3));
+            textmap.AddFlag("dormant", udmf_flags.test(4));
+            textmap.AddFlag("class1", udmf_flags.test(5));
+            textmap.AddFlag("class2", udmf_flags.test(6));
+            textmap.AddFlag("class3", udmf_flags.test(7));
+            textmap.AddFlag("single", udmf_flags.test(8));
+            textmap.AddFlag("coop", udmf_flags.test(9));
+            textmap.AddFlag("dm", udmf_flags.test(10));
+            textmap.AddInt("special", special, 0);
             if (args) {
-                textmap_lump->Printf("\targ0 = %d;\n", args[0]);
-                textmap_lump->Printf("\targ1 = %d;\n", args[1]);
-                textmap_lump->Printf("\targ2 = %d;\n", args[2]);
-                textmap_lump->Printf("\targ3 = %d;\n", args[3]);
-                textmap_lump->Printf("\targ4 = %d;\n", args[4]);
+                textmap.AddInt("arg0", args[0], 0);
+                textmap.AddInt("arg1", args[1], 0);
+                textmap.AddInt("arg2", args[2], 0);
+                textmap.AddInt("arg3", args[3], 0);
+                textmap.AddInt("arg4", args[4], 0);
             }
-            textmap_lump->Printf("}\n");
+            textmap.End();
             udmf_things += 1;
         }
     }
@@ -818,8 +728,16 @@ static bool BuildNodes(std::filesystem::path filename) {
             map_nums = 45;
         }
     }
-    if (zdmain(filename, current_engine, UDMF_mode, build_reject, map_nums) !=
-        0) {
+    // Fast mode hands ZDBSP the CSG chunk grid, which is where the seed
+    // layout (and thus the best top-level splits) lines up.
+    int hint_grid = fast_nodes ? I_ROUND(CHUNK_SIZE) : 0;
+    std::filesystem::path cache_dir;
+    if (node_cache) {
+        cache_dir = home_dir / "cache" / "nodes";
+    }
+
+    if (zdmain(filename, current_engine, UDMF_mode, build_reject, map_nums,
+               hint_grid, cache_dir) != 0) {
         Main::ProgStatus(_("ZDBSP Error!"));
         return false;
     }
@@ -877,11 +795,14 @@ bool Doom::game_interface_c::Start(const char *preset) {
     }
 
     current_engine = ob_get_param("engine");
+    node_cache = StringToInt(ob_get_param("bool_node_cache"));
 
     // Need to preempt the rest of this process for now if we are using Vanilla
     // Doom
     if (StringCaseCmp(current_engine, "vanilla") == 0) {
         build_reject = StringToInt(ob_get_param("bool_build_reject"));
+        // SLUMP maps are not laid out on the seed grid
+        fast_nodes = false;
         return true;
     }
 
@@ -908,6 +829,7 @@ bool Doom::game_interface_c::Start(const char *preset) {
         map_format = "binary";
         build_nodes = true;
     }
+    fast_nodes = StringToInt(ob_get_param("bool_fast_nodes"));
     if (StringCaseCmp(map_format, "udmf") == 0) {
         UDMF_mode = true;
     } else {
@@ -60,7 +60,7 @@
 #define NODE_PADDING 16
 #define MODEL_PADDING 1.0
 
-extern void Q1_ClippingHull(int hull);
+extern void Q1_ClippingHulls();
 
 static std::string level_name;
 static std::string description;
@@ -1128,9 +1128,7 @@ static void Q1_ClipModels() {
     q1_clip = BSP_NewLump(LUMP_CLIPNODES);
     q1_total_clip = 0;
 
-    for (int hull = 1; hull < 6; hull++) {
-        Q1_ClippingHull(hull);
-    }
+    Q1_ClippingHulls();
 }
 
 static void Q1_WriteModels() {
@@ -502,8 +502,8 @@ static void Q3_CreateDrawVert(quake_face_c *face, quake_vertex_c *V,
 
         if (is_dark) {
             // middle of the top-left 2x2 block
-            out->lightmap[0] = 1.0 / 128.0;
-            out->lightmap[1] = 1.0 / 128.0;
+            out->lightmap[0] = 1.0 / q3_lightmap_size;
+            out->lightmap[1] = 1.0 / q3_lightmap_size;
         } else {
             out->lightmap[0] = face->lmap->lm_mat->Calc_S(V->x, V->y, V->z);
             out->lightmap[1] = face->lmap->lm_mat->Calc_T(V->x, V->y, V->z);
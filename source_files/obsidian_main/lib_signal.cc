@@ -21,6 +21,7 @@
 #include "lib_signal.h"
 
 #include <algorithm>
+#include <csignal>
 
 #include "fmt/format.h"
 #include "headers.h"
@@ -143,5 +144,44 @@ void Signal_Raise(std::string name) {
     }
 }
 
+//------------------------------------------------------------------------
+//  CRASH HANDLING
+//------------------------------------------------------------------------
+
+#define MAX_CRASH_FUNCS 8
+
+// a plain array, so the handler never touches anything which
+// could be in the middle of changing.
+static signal_crash_f crash_funcs[MAX_CRASH_FUNCS];
+static volatile std::sig_atomic_t num_crash_funcs = 0;
+
+void Signal_OnCrash(signal_crash_f func) {
+    if (num_crash_funcs >= MAX_CRASH_FUNCS) {
+        Main::FatalError("Signal_OnCrash : too many crash functions!\n");
+    }
+
+    crash_funcs[num_crash_funcs] = func;
+    num_crash_funcs = num_crash_funcs + 1;
+}
+
+static void Signal_CrashHandler(int sig_num) {
+    // go back to the default first, so that crashing again in here
+    // (or the raise below) will not loop.
+    std::signal(sig_num, SIG_DFL);
+
+    for (int i = 0; i < num_crash_funcs; i++) {
+        (*crash_funcs[i])();
+    }
+
+    std::raise(sig_num);
+}
+
+void Signal_CatchCrashes(void) {
+    std::signal(SIGSEGV, Signal_CrashHandler);
+    std::signal(SIGABRT, Signal_CrashHandler);
+    std::signal(SIGFPE, Signal_CrashHandler);
+    std::signal(SIGILL, Signal_CrashHandler);
+}
+
 //--- editor settings ---
 // vi:ts=4:sw=4:noexpandtab
@@ -43,6 +43,19 @@ void Signal_Raise(const char *name);
 // Care must be taked to prevent infinite loops (excessive
 // looping will be detected and cause a fatal error).
 
+typedef void (*signal_crash_f)(void);
+
+void Signal_OnCrash(signal_crash_f func);
+// adds a function to be called when the program crashes.
+// These are called from inside a signal handler, so they must be
+// async-signal-safe: no locks, no memory allocation, no stdio or
+// iostreams (a plain write() to a file descriptor is fine).
+
+void Signal_CatchCrashes(void);
+// installs handlers for the system's crash signals (segfault, abort,
+// etc).  When one occurs, every function given to Signal_OnCrash()
+// is called, then the program dies as it normally would.
+
 #endif /* __LIB_SIGNAL_H__ */
 
 //--- editor settings ---
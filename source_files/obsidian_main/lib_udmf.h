@@ -0,0 +1,105 @@
+//------------------------------------------------------------------------
+//  UDMF : TEXTMAP writer
+//------------------------------------------------------------------------
+//
+//  OBSIDIAN Level Maker
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//------------------------------------------------------------------------
+//
+//  Used by both the Doom backend and ZDBSP. Everything is formatted
+//  straight into one growing buffer, which keeps its capacity across
+//  Clear() so that later maps don't reallocate at all.
+//
+//  The typed Add methods leave out any field that equals its UDMF
+//  default, so callers pass the default along with the value.
+//
+//------------------------------------------------------------------------
+
+#ifndef __LIB_UDMF_H__
+#define __LIB_UDMF_H__
+
+#include <string_view>
+
+#include "fmt/format.h"
+
+class udmf_writer_c {
+   private:
+    fmt::memory_buffer buf;
+
+   public:
+    udmf_writer_c() {}
+    ~udmf_writer_c() {}
+
+    void Reserve(size_t bytes) { buf.reserve(bytes); }
+    void Clear() { buf.clear(); }
+
+    const char *GetBuffer() const { return buf.data(); }
+    size_t GetSize() const { return buf.size(); }
+
+    // starts a block like 'linedef' or 'thing'
+    void Begin(std::string_view kind) {
+        fmt::format_to(fmt::appender(buf), "{}\n{{\n", kind);
+    }
+    void Begin(std::string_view kind, int comment) {
+        fmt::format_to(fmt::appender(buf), "{} // {}\n{{\n", kind, comment);
+    }
+    void End() { Raw("}\n\n"); }
+
+    // appends text as-is (e.g. already formatted values)
+    void Raw(std::string_view text) { buf.append(text); }
+    void Raw(std::string_view key, std::string_view value) {
+        fmt::format_to(fmt::appender(buf), "{} = {};\n", key, value);
+    }
+
+    void AddInt(std::string_view key, int value) {
+        fmt::format_to(fmt::appender(buf), "{} = {};\n", key, value);
+    }
+    void AddInt(std::string_view key, int value, int def) {
+        if (value != def) {
+            AddInt(key, value);
+        }
+    }
+
+    // a float field holding a whole number. UDMF floats need the
+    // decimal point, so this writes e.g. '64.0'.
+    void AddCoord(std::string_view key, int value) {
+        fmt::format_to(fmt::appender(buf), "{} = {}.0;\n", key, value);
+    }
+    void AddCoord(std::string_view key, int value, int def) {
+        if (value != def) {
+            AddCoord(key, value);
+        }
+    }
+
+    void AddString(std::string_view key, std::string_view value) {
+        fmt::format_to(fmt::appender(buf), "{} = \"{}\";\n", key, value);
+    }
+    void AddString(std::string_view key, std::string_view value,
+                   std::string_view def) {
+        if (value != def) {
+            AddString(key, value);
+        }
+    }
+
+    // flags all default to false
+    void AddFlag(std::string_view key, bool value) {
+        if (value) {
+            fmt::format_to(fmt::appender(buf), "{} = true;\n", key);
+        }
+    }
+};
+
+#endif /* __LIB_UDMF_H__ */
+
+//--- editor settings ---
+// vi:ts=4:sw=4:noexpandtab
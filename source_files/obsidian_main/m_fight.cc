@@ -0,0 +1,482 @@
+//------------------------------------------------------------------------
+//  FIGHT SIMULATOR
+//------------------------------------------------------------------------
+//
+//  OBSIDIAN Level Maker
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//------------------------------------------------------------------------
+//
+//  The battle loop of Fight_Simulator() (fight.lua).
+//
+//  The script boils the monsters and weapons down to plain numbers:
+//  each kind of monster gets its weapon probabilities, immunities and
+//  who it can infight with worked out once, instead of once per shot.
+//  The loop here then does the rest with flat arrays.
+//
+//  Everything is done in the same order and with the same arithmetic
+//  as the Lua code was, and random numbers come from the same generator
+//  as gui.random(), so the results are identical.
+//
+//------------------------------------------------------------------------
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "hdr_lua.h"
+#include "headers.h"
+#include "lib_util.h"
+#include "main.h"
+#include "sys_xoshiro.h"
+
+// luaL_error() longjmps straight past C++ destructors, so nothing here
+// raises a Lua error while the arrays are alive.  Instead the message
+// goes into an error buffer, and FIGHT_simulate() raises it after they
+// have been freed.
+#define FIGHT_ERROR_LEN 200
+
+// a Lua number which remembers whether it is an integer, so that
+// totals come back with the same type as adding them up in Lua.
+typedef struct {
+    bool is_int;
+    lua_Integer i;
+    double d;
+} fight_num_t;
+
+// nil counts as zero, returns false for anything else not a number
+static bool Fight_ToNum(lua_State *L, int idx, fight_num_t &N) {
+    N = {true, 0, 0};
+
+    if (lua_isinteger(L, idx)) {
+        N.i = lua_tointeger(L, idx);
+    } else if (!lua_isnil(L, idx)) {
+        int isnum;
+
+        N.is_int = false;
+        N.d = lua_tonumberx(L, idx, &isnum);
+
+        return isnum != 0;
+    }
+
+    return true;
+}
+
+// reads a field with Fight_ToNum(), then pops it
+static bool Fight_GetNum(lua_State *L, int idx, const char *field,
+                         fight_num_t &N, char *error) {
+    lua_getfield(L, idx, field);
+    bool ok = Fight_ToNum(L, -1, N);
+    lua_pop(L, 1);
+
+    if (!ok) {
+        snprintf(error, FIGHT_ERROR_LEN,
+                 "gui.fight_simulate: bad '%s' value", field);
+    }
+
+    return ok;
+}
+
+static void Fight_AddNum(fight_num_t &N, const fight_num_t &B) {
+    if (N.is_int && B.is_int) {
+        N.i += B.i;
+        return;
+    }
+
+    double a = N.is_int ? (double)N.i : N.d;
+    double b = B.is_int ? (double)B.i : B.d;
+
+    N.is_int = false;
+    N.d = a + b;
+}
+
+static void Fight_PushNum(lua_State *L, const fight_num_t &N) {
+    if (N.is_int) {
+        lua_pushinteger(L, N.i);
+    } else {
+        lua_pushnumber(L, N.d);
+    }
+}
+
+static bool Fight_GetNumber(lua_State *L, int idx, const char *field,
+                            double *value, char *error) {
+    lua_getfield(L, idx, field);
+
+    int isnum;
+    *value = lua_tonumberx(L, -1, &isnum);
+
+    lua_pop(L, 1);
+
+    if (!isnum) {
+        snprintf(error, FIGHT_ERROR_LEN,
+                 "gui.fight_simulate: bad '%s' value", field);
+        return false;
+    }
+
+    return true;
+}
+
+// a missing field gives an empty array
+static void Fight_GetArray(lua_State *L, int idx, const char *field,
+                           std::vector<double> &out) {
+    lua_getfield(L, idx, field);
+
+    if (lua_istable(L, -1)) {
+        int count = (int)lua_rawlen(L, -1);
+
+        for (int i = 1; i <= count; i++) {
+            lua_rawgeti(L, -1, i);
+            out.push_back(lua_tonumber(L, -1));
+            lua_pop(L, 1);
+        }
+    }
+
+    lua_pop(L, 1);
+}
+
+typedef struct {
+    double health;
+    double infight;
+
+    fight_num_t damage;
+
+    // per weapon
+    std::vector<double> probs;
+    std::vector<double> immune;
+
+    double total_prob;
+
+    // per kind : true if this kind can hurt that kind
+    std::vector<bool> fights;
+} fight_kind_t;
+
+typedef struct {
+    double damage;
+    double accuracy;
+
+    std::vector<double> splash;
+
+    // index into the ammo list, -1 for none
+    int ammo;
+    fight_num_t per;
+} fight_weapon_t;
+
+typedef struct {
+    int kind;
+    double health;
+    double order;
+} fight_mon_t;
+
+// the arguments must already have been checked to be tables
+static void Fight_Simulate(lua_State *L, char *error) {
+    int num_kinds = (int)lua_rawlen(L, 1);
+    int num_mons = (int)lua_rawlen(L, 2);
+    int num_weaps = (int)lua_rawlen(L, 3);
+
+    // read the weapons, collecting the ammo types they use
+
+    std::vector<fight_weapon_t> weapons(num_weaps);
+    std::vector<std::string> ammo_names;
+
+    for (int w = 0; w < num_weaps; w++) {
+        fight_weapon_t &W = weapons[w];
+
+        if (lua_rawgeti(L, 3, w + 1) != LUA_TTABLE) {
+            snprintf(error, FIGHT_ERROR_LEN, "gui.fight_simulate: bad weapon");
+            return;
+        }
+
+        int idx = lua_gettop(L);
+
+        if (!Fight_GetNumber(L, idx, "damage", &W.damage, error) ||
+            !Fight_GetNumber(L, idx, "accuracy", &W.accuracy, error)) {
+            return;
+        }
+
+        Fight_GetArray(L, idx, "splash", W.splash);
+
+        W.ammo = -1;
+
+        lua_getfield(L, idx, "ammo");
+        if (lua_isstring(L, -1)) {
+            std::string name = lua_tostring(L, -1);
+
+            auto it = std::find(ammo_names.begin(), ammo_names.end(), name);
+
+            W.ammo = (int)(it - ammo_names.begin());
+
+            if (it == ammo_names.end()) {
+                ammo_names.push_back(name);
+            }
+        }
+        lua_pop(L, 1);
+
+        if (!Fight_GetNum(L, idx, "per", W.per, error)) {
+            return;
+        }
+
+        lua_pop(L, 1);
+    }
+
+    // read the kinds of monster
+
+    std::vector<fight_kind_t> kinds(num_kinds);
+
+    for (int k = 0; k < num_kinds; k++) {
+        fight_kind_t &K = kinds[k];
+
+        if (lua_rawgeti(L, 1, k + 1) != LUA_TTABLE) {
+            snprintf(error, FIGHT_ERROR_LEN,
+                     "gui.fight_simulate: bad monster kind");
+            return;
+        }
+
+        int idx = lua_gettop(L);
+
+        if (!Fight_GetNumber(L, idx, "health", &K.health, error) ||
+            !Fight_GetNumber(L, idx, "infight", &K.infight, error) ||
+            !Fight_GetNum(L, idx, "damage", K.damage, error)) {
+            return;
+        }
+
+        Fight_GetArray(L, idx, "probs", K.probs);
+        Fight_GetArray(L, idx, "immune", K.immune);
+
+        if ((int)K.probs.size() != num_weaps ||
+            (int)K.immune.size() != num_weaps) {
+            snprintf(error, FIGHT_ERROR_LEN,
+                     "gui.fight_simulate: bad weapon tables");
+            return;
+        }
+
+        // summed in the same order as rand.index_by_probs()
+        K.total_prob = 0;
+
+        for (double prob : K.probs) {
+            K.total_prob += prob;
+        }
+
+        if (lua_getfield(L, idx, "fights") != LUA_TTABLE) {
+            snprintf(error, FIGHT_ERROR_LEN,
+                     "gui.fight_simulate: bad 'fights' table");
+            return;
+        }
+
+        for (int k2 = 1; k2 <= num_kinds; k2++) {
+            lua_rawgeti(L, -1, k2);
+            K.fights.push_back(lua_toboolean(L, -1) ? true : false);
+            lua_pop(L, 1);
+        }
+
+        lua_pop(L, 2);
+    }
+
+    // create the monsters.
+    // the random part of 'order' is picked in the original order.
+
+    std::vector<fight_mon_t> active;
+
+    active.reserve(num_mons);
+
+    for (int m = 1; m <= num_mons; m++) {
+        lua_rawgeti(L, 2, m);
+
+        int isnum;
+        lua_Integer kind = lua_tointegerx(L, -1, &isnum) - 1;
+
+        lua_pop(L, 1);
+
+        if (!isnum || kind < 0 || kind >= num_kinds) {
+            snprintf(error, FIGHT_ERROR_LEN,
+                     "gui.fight_simulate: bad monster kind");
+            return;
+        }
+
+        fight_mon_t M;
+
+        M.kind = (int)kind;
+        M.health = kinds[kind].health;
+        M.order = kinds[kind].health + xoshiro_Double();
+
+        active.push_back(M);
+    }
+
+    // put toughest monster first, weakest last.
+    std::stable_sort(active.begin(), active.end(),
+                     [](const fight_mon_t &A, const fight_mon_t &B) {
+                         return A.order > B.order;
+                     });
+
+    // compute health needed by player
+    fight_num_t health;
+
+    if (!Fight_GetNum(L, 4, "health", health, error)) {
+        return;
+    }
+
+    for (const fight_mon_t &M : active) {
+        Fight_AddNum(health, kinds[M.kind].damage);
+    }
+
+    Fight_PushNum(L, health);
+    lua_setfield(L, 4, "health");
+
+    // simulate infighting.
+    // we don't check if monsters "die" here, not needed.
+
+    std::vector<int> others;
+
+    for (const fight_mon_t &M : active) {
+        const fight_kind_t &K = kinds[M.kind];
+
+        others.clear();
+
+        double total_weight = 0;
+
+        for (int i = 0; i < (int)active.size(); i++) {
+            const fight_mon_t &P = active[i];
+
+            if (&P != &M && K.fights[P.kind]) {
+                others.push_back(i);
+                total_weight = total_weight + kinds[P.kind].health;
+            }
+        }
+
+        if (others.empty()) {
+            continue;
+        }
+
+        SYS_ASSERT(total_weight > 0);
+
+        // bump up the damage (higher than demo analysis, but seems necessary)
+        double damage = K.infight * 1.5;
+
+        for (int i : others) {
+            fight_mon_t &P = active[i];
+
+            // damage is weighted, bigger monsters get a bigger share
+            double factor = kinds[P.kind].health / total_weight;
+
+            P.health = P.health - damage * factor;
+        }
+    }
+
+    auto remove_dead_mon = [&active]() {
+        active.erase(std::remove_if(active.begin(), active.end(),
+                                    [](const fight_mon_t &M) {
+                                        return M.health <= 0;
+                                    }),
+                     active.end());
+    };
+
+    remove_dead_mon();
+
+    // run simulation until all monsters are dead
+
+    std::vector<fight_num_t> ammo_used(ammo_names.size());
+
+    // ammo types in the order they were first used, so the new fields
+    // go into 'stats' in the same order as before.
+    std::vector<int> ammo_order;
+
+    for (size_t a = 0; a < ammo_names.size(); a++) {
+        if (!Fight_GetNum(L, 4, ammo_names[a].c_str(), ammo_used[a], error)) {
+            return;
+        }
+    }
+
+    if (!active.empty() && num_weaps == 0) {
+        snprintf(error, FIGHT_ERROR_LEN, "gui.fight_simulate: no weapons");
+        return;
+    }
+
+    while (!active.empty()) {
+        const fight_kind_t &first = kinds[active[0].kind];
+
+        // select a weapon, like rand.index_by_probs()
+        int index = 0;
+
+        if (first.total_prob > 0) {
+            double value = xoshiro_Double() * first.total_prob;
+
+            for (int w = 0; w < num_weaps; w++) {
+                value = value - first.probs[w];
+
+                if (value <= 0) {
+                    index = w;
+                    break;
+                }
+            }
+        }
+
+        const fight_weapon_t &W = weapons[index];
+
+        // shoot the first monster, and the splash damage (or shotgun
+        // spread) hits the following ones
+        int count = 1 + (int)W.splash.size();
+
+        for (int i = 0; i < count && i < (int)active.size(); i++) {
+            fight_mon_t &M = active[i];
+
+            double damage = (i == 0) ? W.damage : W.splash[i - 1];
+
+            damage = damage * W.accuracy / 100;
+            damage = damage * kinds[M.kind].immune[index];
+
+            M.health = M.health - damage;
+        }
+
+        if (W.ammo >= 0) {
+            if (std::find(ammo_order.begin(), ammo_order.end(), W.ammo) ==
+                ammo_order.end()) {
+                ammo_order.push_back(W.ammo);
+            }
+
+            Fight_AddNum(ammo_used[W.ammo], W.per);
+        }
+
+        remove_dead_mon();
+    }
+
+    for (int a : ammo_order) {
+        Fight_PushNum(L, ammo_used[a]);
+        lua_setfield(L, 4, ammo_names[a].c_str());
+    }
+}
+
+// LUA: fight_simulate(kinds, mons, weapons, stats)
+//
+// kinds   : list of { health, damage, infight, probs, immune, fights }
+// mons    : list of indexes into 'kinds', one per monster
+// weapons : list of { damage, accuracy, splash, ammo, per }
+//
+// Adds the health and ammo needed into the 'stats' table.
+//
+int FIGHT_simulate(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+    luaL_checktype(L, 2, LUA_TTABLE);
+    luaL_checktype(L, 3, LUA_TTABLE);
+    luaL_checktype(L, 4, LUA_TTABLE);
+
+    char error[FIGHT_ERROR_LEN] = "";
+
+    Fight_Simulate(L, error);
+
+    if (error[0]) {
+        return luaL_error(L, "%s", error);
+    }
+
+    return 0;
+}
+
+//--- editor settings ---
+// vi:ts=4:sw=4:noexpandtab
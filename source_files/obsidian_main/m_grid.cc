@@ -0,0 +1,791 @@
+//------------------------------------------------------------------------
+//  CELLULAR AUTOMATA GRIDS
+//------------------------------------------------------------------------
+//
+//  OBSIDIAN Level Maker
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//------------------------------------------------------------------------
+//
+//  Native versions of the busy GRID_CLASS methods (automata.lua).
+//
+//  The grids themselves stay as Lua tables (a table per column), since
+//  the cave code reads and writes cells directly.  Each function here
+//  copies the cells into a contiguous array, does all the work there,
+//  and then stores the result back into a Lua grid.  Cells must be nil
+//  or integers.
+//
+//  Everything visits cells in the same order as the Lua code did, and
+//  random numbers come from the same generator as gui.random(), so the
+//  results are identical.
+//
+//------------------------------------------------------------------------
+
+#include <climits>
+#include <map>
+#include <vector>
+
+#include "hdr_lua.h"
+#include "headers.h"
+#include "lib_util.h"
+#include "main.h"
+#include "sys_xoshiro.h"
+
+// value for a nil cell
+#define GRID_NIL INT_MIN
+
+class cell_grid_c {
+   public:
+    int W, H;
+
+    // column by column, like the Lua tables
+    std::vector<int> cells;
+
+   public:
+    cell_grid_c() : W(0), H(0) {}
+
+    cell_grid_c(int w, int h) : W(w), H(h), cells(w * h, GRID_NIL) {}
+
+    ~cell_grid_c() {}
+
+    // coordinates are zero-based here
+    inline int &At(int x, int y) { return cells[x * H + y]; }
+    inline int At(int x, int y) const { return cells[x * H + y]; }
+
+    inline bool Valid(int x, int y) const {
+        return (0 <= x && x < W) && (0 <= y && y < H);
+    }
+
+    // returns GRID_NIL when off the grid
+    inline int Get(int x, int y) const {
+        return Valid(x, y) ? At(x, y) : GRID_NIL;
+    }
+};
+
+// neighbor deltas in geom.nudge() order: 2, 4, 6, 8 and then
+// 1, 2, 3, 4, 6, 7, 8, 9.
+static const int dirs4[4][2] = {{0, -1}, {-1, 0}, {1, 0}, {0, 1}};
+
+static const int dirs8[8][2] = {{-1, -1}, {0, -1}, {1, -1}, {-1, 0},
+                                {1, 0},   {-1, 1}, {0, 1},  {1, 1}};
+
+// luaL_error() longjmps straight past C++ destructors, so nothing here
+// raises a Lua error while a grid is alive.  Instead the message goes
+// into an error buffer, and the GRID_xxx functions raise it after the
+// grids have been freed.
+#define GRID_ERROR_LEN 200
+
+static bool Grid_Size(lua_State *L, int idx, const char *field, int *value,
+                      char *error) {
+    lua_getfield(L, idx, field);
+
+    int isnum;
+    lua_Integer size = lua_tointegerx(L, -1, &isnum);
+
+    lua_pop(L, 1);
+
+    if (!isnum || size < 0 || size > INT_MAX) {
+        snprintf(error, GRID_ERROR_LEN, "gui.grid: bad grid size");
+        return false;
+    }
+
+    *value = (int)size;
+    return true;
+}
+
+// the table at 'idx' must already have been checked
+static bool Grid_Read(lua_State *L, int idx, cell_grid_c &G, char *error) {
+    int W, H;
+
+    if (!Grid_Size(L, idx, "w", &W, error) ||
+        !Grid_Size(L, idx, "h", &H, error)) {
+        return false;
+    }
+
+    G = cell_grid_c(W, H);
+
+    for (int x = 0; x < W; x++) {
+        if (lua_rawgeti(L, idx, x + 1) != LUA_TTABLE) {
+            lua_pop(L, 1);
+            snprintf(error, GRID_ERROR_LEN, "gui.grid: missing column %d",
+                     x + 1);
+            return false;
+        }
+
+        for (int y = 0; y < H; y++) {
+            lua_rawgeti(L, -1, y + 1);
+
+            if (!lua_isnil(L, -1)) {
+                int isnum;
+                lua_Integer value = lua_tointegerx(L, -1, &isnum);
+
+                if (!isnum || value == GRID_NIL) {
+                    lua_pop(L, 2);
+                    snprintf(error, GRID_ERROR_LEN,
+                             "gui.grid: cell (%d %d) is not an integer", x + 1,
+                             y + 1);
+                    return false;
+                }
+
+                G.At(x, y) = (int)value;
+            }
+
+            lua_pop(L, 1);
+        }
+
+        lua_pop(L, 1);
+    }
+
+    return true;
+}
+
+// when 'old' is given, only cells which differ from it are stored
+static bool Grid_Write(lua_State *L, int idx, const cell_grid_c &G,
+                       char *error, const cell_grid_c *old = NULL) {
+    for (int x = 0; x < G.W; x++) {
+        if (lua_rawgeti(L, idx, x + 1) != LUA_TTABLE) {
+            lua_pop(L, 1);
+            snprintf(error, GRID_ERROR_LEN, "gui.grid: missing column %d",
+                     x + 1);
+            return false;
+        }
+
+        for (int y = 0; y < G.H; y++) {
+            int value = G.At(x, y);
+
+            if (old && old->At(x, y) == value) {
+                continue;
+            }
+
+            if (value == GRID_NIL) {
+                lua_pushnil(L);
+            } else {
+                lua_pushinteger(L, value);
+            }
+
+            lua_rawseti(L, -2, y + 1);
+        }
+
+        lua_pop(L, 1);
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------
+
+static void Cave_ColumnSums(const std::vector<byte> &work, int W, int H,
+                            std::vector<byte> &sum3,
+                            std::vector<byte> &sum5) {
+    // vertical sums of 3 and 5 cells, centered on each cell.
+    // the columns are contiguous, so these loops vectorize nicely.
+
+    for (int x = 0; x < W; x++) {
+        const byte *col = &work[x * H];
+
+        byte *s3 = &sum3[x * H];
+        byte *s5 = &sum5[x * H];
+
+        for (int y = 1; y < H - 1; y++) {
+            s3[y] = col[y - 1] + col[y] + col[y + 1];
+        }
+
+        for (int y = 2; y < H - 2; y++) {
+            s5[y] = s3[y] + col[y - 2] + col[y + 2];
+        }
+    }
+}
+
+static void Cave_Generate(const cell_grid_c *grid, cell_grid_c *result,
+                          double solid_prob) {
+    int W = grid->W;
+    int H = grid->H;
+
+    // these arrays only use 0 and 1 as values
+    std::vector<byte> work(W * H);
+    std::vector<byte> temp(W * H);
+
+    std::vector<byte> sum3(W * H, 0);
+    std::vector<byte> sum5(W * H, 0);
+
+    // populate initial map
+    for (int x = 0; x < W; x++) {
+        for (int y = 0; y < H; y++) {
+            int val = grid->At(x, y);
+
+            if (val == GRID_NIL || val < 0) {
+                work[x * H + y] = 0;
+            } else if (val > 0) {
+                work[x * H + y] = 1;
+            } else {
+                work[x * H + y] = (xoshiro_Double() * 100 <= solid_prob);
+            }
+        }
+    }
+
+    // perform the cellular automation steps
+    for (int loop = 1; loop <= 7; loop++) {
+        Cave_ColumnSums(work, W, H, sum3, sum5);
+
+        for (int x = 0; x < W; x++) {
+            for (int y = 0; y < H; y++) {
+                int c = x * H + y;
+                int val = grid->At(x, y);
+
+                if (val == GRID_NIL || val < 0) {
+                    temp[c] = 0;
+                    continue;
+                }
+
+                if (val > 0) {
+                    temp[c] = 1;
+                    continue;
+                }
+
+                if (x == 0 || x == W - 1 || y == 0 || y == H - 1) {
+                    temp[c] = work[c];
+                    continue;
+                }
+
+                int neighbors = sum3[c - H] + sum3[c] + sum3[c + H];
+
+                if (neighbors >= 5) {
+                    temp[c] = 1;
+                    continue;
+                }
+
+                if (loop >= 5) {
+                    temp[c] = 0;
+                    continue;
+                }
+
+                if (x <= 1 || x >= W - 2 || y <= 1 || y >= H - 2) {
+                    temp[c] = 0;
+                    continue;
+                }
+
+                // check larger area : a 5x5 block without the corners
+                neighbors = sum5[c - H] + sum5[c] + sum5[c + H] +
+                            sum3[c - 2 * H] + sum3[c + 2 * H];
+
+                temp[c] = (neighbors <= 2) ? 1 : 0;
+            }
+        }
+
+        work.swap(temp);
+    }
+
+    // convert values for the result
+    for (int x = 0; x < W; x++) {
+        for (int y = 0; y < H; y++) {
+            int val = grid->At(x, y);
+
+            if (val == 0) {
+                result->At(x, y) = work[x * H + y] ? 1 : -1;
+            } else {
+                result->At(x, y) = val;
+            }
+        }
+    }
+}
+
+static void Grid_FloodFill(const cell_grid_c *grid, cell_grid_c *flood) {
+    // each contiguous area gets the id which its first cell (in x then
+    // y order) was given initially.  Solid ids count up from 1 and empty
+    // ids count down from -1, one per cell.
+
+    int W = grid->W;
+    int H = grid->H;
+
+    int cur_solid = 1;
+    int cur_empty = -1;
+
+    std::vector<int> stack;
+
+    for (int x = 0; x < W; x++) {
+        for (int y = 0; y < H; y++) {
+            int val = grid->At(x, y);
+
+            if (val == GRID_NIL) {
+                continue;
+            }
+
+            bool solid = (val >= 0);
+
+            int id = solid ? cur_solid++ : cur_empty--;
+
+            if (flood->At(x, y) != GRID_NIL) {
+                continue;
+            }
+
+            flood->At(x, y) = id;
+            stack.push_back(x * H + y);
+
+            while (!stack.empty()) {
+                int c = stack.back();
+                stack.pop_back();
+
+                int cx = c / H;
+                int cy = c % H;
+
+                for (int d = 0; d < 4; d++) {
+                    int nx = cx + dirs4[d][0];
+                    int ny = cy + dirs4[d][1];
+
+                    int nval = grid->Get(nx, ny);
+
+                    if (nval == GRID_NIL || (nval >= 0) != solid ||
+                        flood->At(nx, ny) != GRID_NIL) {
+                        continue;
+                    }
+
+                    flood->At(nx, ny) = id;
+                    stack.push_back(nx * H + ny);
+                }
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------
+//  LUA INTERFACE
+//------------------------------------------------------------------------
+
+static void Grid_GenerateCave(lua_State *L, double solid_prob, char *error) {
+    cell_grid_c grid;
+
+    if (!Grid_Read(L, 1, grid, error)) {
+        return;
+    }
+
+    cell_grid_c result(grid.W, grid.H);
+
+    Cave_Generate(&grid, &result, solid_prob);
+
+    Grid_Write(L, 2, result, error);
+}
+
+// LUA: grid_generate_cave(grid, result, solid_prob)
+//
+int GRID_generate_cave(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+    luaL_checktype(L, 2, LUA_TTABLE);
+
+    double solid_prob = luaL_checknumber(L, 3);
+
+    char error[GRID_ERROR_LEN] = "";
+
+    Grid_GenerateCave(L, solid_prob, error);
+
+    if (error[0]) {
+        return luaL_error(L, "%s", error);
+    }
+
+    return 0;
+}
+
+static void Grid_FloodRegions(lua_State *L, char *error) {
+    cell_grid_c grid;
+
+    if (!Grid_Read(L, 1, grid, error)) {
+        return;
+    }
+
+    cell_grid_c flood(grid.W, grid.H);
+
+    Grid_FloodFill(&grid, &flood);
+
+    if (!Grid_Write(L, 2, flood, error)) {
+        return;
+    }
+
+    // collect region info, in order of first appearance
+    struct region_info_t {
+        int id;
+        int cx1, cy1, cx2, cy2;
+        int size;
+    };
+
+    std::vector<region_info_t> regions;
+    std::map<int, int> region_index;
+
+    for (int x = 0; x < grid.W; x++) {
+        for (int y = 0; y < grid.H; y++) {
+            int id = flood.At(x, y);
+
+            if (id == GRID_NIL) {
+                continue;
+            }
+
+            auto it = region_index.find(id);
+
+            if (it == region_index.end()) {
+                region_index[id] = (int)regions.size();
+                regions.push_back(region_info_t{id, x, y, x, y, 1});
+                continue;
+            }
+
+            region_info_t &REG = regions[it->second];
+
+            REG.cx1 = MIN(REG.cx1, x);
+            REG.cy1 = MIN(REG.cy1, y);
+            REG.cx2 = MAX(REG.cx2, x);
+            REG.cy2 = MAX(REG.cy2, y);
+            REG.size += 1;
+        }
+    }
+
+    lua_newtable(L);
+
+    for (const region_info_t &REG : regions) {
+        lua_createtable(L, 0, 6);
+
+        lua_pushinteger(L, REG.id);
+        lua_setfield(L, -2, "id");
+        lua_pushinteger(L, REG.cx1 + 1);
+        lua_setfield(L, -2, "cx1");
+        lua_pushinteger(L, REG.cy1 + 1);
+        lua_setfield(L, -2, "cy1");
+        lua_pushinteger(L, REG.cx2 + 1);
+        lua_setfield(L, -2, "cx2");
+        lua_pushinteger(L, REG.cy2 + 1);
+        lua_setfield(L, -2, "cy2");
+        lua_pushinteger(L, REG.size);
+        lua_setfield(L, -2, "size");
+
+        lua_rawseti(L, -2, REG.id);
+    }
+}
+
+// LUA: grid_flood_fill(grid, flood) --> regions
+//
+// Also creates the region table, in the order the Lua code did.
+//
+int GRID_flood_fill(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+    luaL_checktype(L, 2, LUA_TTABLE);
+
+    char error[GRID_ERROR_LEN] = "";
+
+    Grid_FloodRegions(L, error);
+
+    if (error[0]) {
+        return luaL_error(L, "%s", error);
+    }
+
+    return 1;
+}
+
+static void Grid_FindIslands(lua_State *L, char *error) {
+    cell_grid_c flood;
+
+    if (!Grid_Read(L, 1, flood, error)) {
+        return;
+    }
+
+    int W = flood.W;
+    int H = flood.H;
+
+    std::vector<int> order;
+    std::map<int, bool> potentials;
+
+    for (int x = 0; x < W; x++) {
+        for (int y = 0; y < H; y++) {
+            int reg = flood.At(x, y);
+
+            if (reg == GRID_NIL || reg <= 0) {
+                continue;
+            }
+
+            if (potentials.find(reg) == potentials.end()) {
+                potentials[reg] = true;
+                order.push_back(reg);
+            }
+
+            if (x == 0 || x == W - 1 || y == 0 || y == H - 1) {
+                potentials[reg] = false;
+                continue;
+            }
+
+            for (int d = 0; d < 4; d++) {
+                if (flood.At(x + dirs4[d][0], y + dirs4[d][1]) == GRID_NIL) {
+                    potentials[reg] = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    lua_newtable(L);
+
+    int index = 1;
+
+    for (int reg : order) {
+        if (potentials[reg]) {
+            lua_pushinteger(L, reg);
+            lua_rawseti(L, -2, index++);
+        }
+    }
+}
+
+// LUA: grid_find_islands(flood) --> list of region ids
+//
+// Islands are solid regions which do not touch the edge of the grid
+// or any nil cell.
+//
+int GRID_find_islands(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+
+    char error[GRID_ERROR_LEN] = "";
+
+    Grid_FindIslands(L, error);
+
+    if (error[0]) {
+        return luaL_error(L, "%s", error);
+    }
+
+    return 1;
+}
+
+static void Grid_GrowOrShrink(lua_State *L, bool shrink, bool eight,
+                              bool keep_edges, char *error) {
+    // a cell takes the value of the last neighbor which is solid (for
+    // growing) or empty (for shrinking).  Nil cells are not affected.
+
+    cell_grid_c grid;
+
+    if (!Grid_Read(L, 1, grid, error)) {
+        return;
+    }
+
+    cell_grid_c work(grid.W, grid.H);
+
+    const int(*dirs)[2] = eight ? dirs8 : dirs4;
+    int num_dirs = eight ? 8 : 4;
+
+    for (int x = 0; x < grid.W; x++) {
+        for (int y = 0; y < grid.H; y++) {
+            int val = grid.At(x, y);
+
+            if (val == GRID_NIL) {
+                continue;
+            }
+
+            bool hit_edge = false;
+
+            for (int d = 0; d < num_dirs; d++) {
+                int nval = grid.Get(x + dirs[d][0], y + dirs[d][1]);
+
+                if (nval == GRID_NIL) {
+                    hit_edge = true;
+                } else if (shrink ? (nval < 0) : (nval > 0)) {
+                    val = nval;
+                }
+            }
+
+            if (keep_edges && hit_edge) {
+                val = grid.At(x, y);
+            }
+
+            work.At(x, y) = val;
+        }
+    }
+
+    Grid_Write(L, 2, work, error);
+}
+
+static int Grid_GrowOrShrink(lua_State *L, bool shrink) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+    luaL_checktype(L, 2, LUA_TTABLE);
+
+    bool eight = lua_toboolean(L, 3) ? true : false;
+    bool keep_edges = lua_toboolean(L, 4) ? true : false;
+
+    char error[GRID_ERROR_LEN] = "";
+
+    Grid_GrowOrShrink(L, shrink, eight, keep_edges, error);
+
+    if (error[0]) {
+        return luaL_error(L, "%s", error);
+    }
+
+    return 0;
+}
+
+// LUA: grid_grow(grid, work, eight, keep_edges)
+//
+int GRID_grow(lua_State *L) { return Grid_GrowOrShrink(L, false); }
+
+// LUA: grid_shrink(grid, work, eight, keep_edges)
+//
+int GRID_shrink(lua_State *L) { return Grid_GrowOrShrink(L, true); }
+
+static void Grid_RemoveDots(lua_State *L, char *error) {
+    cell_grid_c grid;
+
+    if (!Grid_Read(L, 1, grid, error)) {
+        return;
+    }
+
+    cell_grid_c old(grid);
+
+    int W = grid.W;
+    int H = grid.H;
+
+    for (int x = 0; x < W; x++) {
+        for (int y = 0; y < H; y++) {
+            int val = grid.At(x, y);
+
+            if (val == GRID_NIL || val == 0) {
+                continue;
+            }
+
+            bool isolated = true;
+
+            for (int d = 0; d < 4; d++) {
+                if (grid.Get(x + dirs4[d][0], y + dirs4[d][1]) == val) {
+                    isolated = false;
+                    break;
+                }
+            }
+
+            if (!isolated) {
+                continue;
+            }
+
+            // same test as the Lua code, which used 1-based coords
+            int dx = (x + 1 > W / 2.0) ? -1 : 1;
+
+            if (!grid.Valid(x + dx, y)) {
+                snprintf(error, GRID_ERROR_LEN,
+                         "gui.grid_remove_dots: grid too small");
+                return;
+            }
+
+            grid.At(x, y) = grid.At(x + dx, y);
+        }
+    }
+
+    Grid_Write(L, 1, grid, error, &old);
+}
+
+// LUA: grid_remove_dots(grid)
+//
+// Works in-place, so a cell sees the changes made to earlier cells.
+//
+int GRID_remove_dots(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+
+    char error[GRID_ERROR_LEN] = "";
+
+    Grid_RemoveDots(L, error);
+
+    if (error[0]) {
+        return luaL_error(L, "%s", error);
+    }
+
+    return 0;
+}
+
+static void Grid_DistanceMap(lua_State *L, int empty_id, char *error) {
+    cell_grid_c flood;
+
+    if (!Grid_Read(L, 1, flood, error)) {
+        return;
+    }
+
+    cell_grid_c work(flood.W, flood.H);
+
+    int H = flood.H;
+
+    std::vector<int> queue;
+
+    int count = (int)lua_rawlen(L, 4);
+
+    for (int i = 1; i <= count; i++) {
+        lua_rawgeti(L, 4, i);
+
+        if (!lua_istable(L, -1)) {
+            lua_pop(L, 1);
+            snprintf(error, GRID_ERROR_LEN, "gui.grid_distance_map: bad point");
+            return;
+        }
+
+        lua_getfield(L, -1, "x");
+        lua_getfield(L, -2, "y");
+
+        int x_ok, y_ok;
+
+        int x = (int)lua_tointegerx(L, -2, &x_ok) - 1;
+        int y = (int)lua_tointegerx(L, -1, &y_ok) - 1;
+
+        lua_pop(L, 3);
+
+        if (!x_ok || !y_ok || !flood.Valid(x, y)) {
+            snprintf(error, GRID_ERROR_LEN, "gui.grid_distance_map: bad point");
+            return;
+        }
+
+        if (work.At(x, y) != 0) {
+            work.At(x, y) = 0;
+            queue.push_back(x * H + y);
+        }
+    }
+
+    for (size_t pos = 0; pos < queue.size(); pos++) {
+        int cx = queue[pos] / H;
+        int cy = queue[pos] % H;
+
+        int dist = work.At(cx, cy) + 1;
+
+        for (int d = 0; d < 4; d++) {
+            int nx = cx + dirs4[d][0];
+            int ny = cy + dirs4[d][1];
+
+            if (flood.Get(nx, ny) != empty_id || work.At(nx, ny) != GRID_NIL) {
+                continue;
+            }
+
+            work.At(nx, ny) = dist;
+            queue.push_back(nx * H + ny);
+        }
+    }
+
+    Grid_Write(L, 2, work, error);
+}
+
+// LUA: grid_distance_map(flood, work, empty_id, ref_points)
+//
+// Breadth-first distances from the reference points (a list of {x,y}
+// tables), spreading through cells of the empty region.
+//
+int GRID_distance_map(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+    luaL_checktype(L, 2, LUA_TTABLE);
+
+    int empty_id = (int)luaL_checkinteger(L, 3);
+
+    luaL_checktype(L, 4, LUA_TTABLE);
+
+    char error[GRID_ERROR_LEN] = "";
+
+    Grid_DistanceMap(L, empty_id, error);
+
+    if (error[0]) {
+        return luaL_error(L, "%s", error);
+    }
+
+    return 0;
+}
+
+//--- editor settings ---
+// vi:ts=4:sw=4:noexpandtab
@@ -151,6 +151,15 @@ int gui_raw_debug_print(lua_State *L) {
     return 0;
 }
 
+// LUA: debug_enabled() --> boolean
+//
+// lets gui.debugf() skip formatting messages which would be thrown away.
+//
+int gui_debug_enabled(lua_State *L) {
+    lua_pushboolean(L, debugging ? 1 : 0);
+    return 1;
+}
+
 // LUA: gettext(str)
 //
 int gui_gettext(lua_State *L) {
@@ -1017,6 +1026,36 @@ int gui_random_int(lua_State *L) {
     return 1;
 }
 
+// LUA: rand_stream(subsystem, level, index)
+//
+// makes random() and random_int() use a separate stream of numbers,
+// see xoshiro_Stream().  'subsystem' is a name like "room", and level
+// and index default to 0.  with no arguments, the legacy single
+// stream is used again.
+//
+int gui_rand_stream(lua_State *L) {
+    static const char *const subsystem_names[] = {
+        "script", "level", "room", "fight", "slump", "texture", NULL};
+
+    if (lua_isnoneornil(L, 1)) {
+        xoshiro_SelectLegacy();
+        return 0;
+    }
+
+    int subsystem = luaL_checkoption(L, 1, NULL, subsystem_names);
+
+    int level = (int)luaL_optinteger(L, 2, 0);
+    int index = (int)luaL_optinteger(L, 3, 0);
+
+    if (level < 0 || index < 0) {
+        return luaL_error(L, "gui.rand_stream: bad level or index");
+    }
+
+    xoshiro_SelectStream(subsystem, level, index);
+
+    return 0;
+}
+
 // LUA: bit_and(A, B) --> number
 //
 int gui_bit_and(lua_State *L) {
@@ -1178,6 +1217,13 @@ extern int CSG_end_level(lua_State *L);
 extern int CSG_property(lua_State *L);
 extern int CSG_tex_property(lua_State *L);
 extern int CSG_add_brush(lua_State *L);
+extern int CSG_brush_begin(lua_State *L);
+extern int CSG_brush_verts(lua_State *L);
+extern int CSG_brush_top(lua_State *L);
+extern int CSG_brush_bottom(lua_State *L);
+extern int CSG_brush_key(lua_State *L);
+extern int CSG_brush_prop(lua_State *L);
+extern int CSG_brush_end(lua_State *L);
 extern int CSG_add_entity(lua_State *L);
 extern int CSG_trace_ray(lua_State *L);
 
@@ -1227,12 +1273,47 @@ extern int wadfab_get_thing_hexen(lua_State *L);
 extern int Q1_add_mapmodel(lua_State *L);
 extern int Q1_add_tex_wad(lua_State *L);
 
+extern int GRID_generate_cave(lua_State *L);
+extern int GRID_flood_fill(lua_State *L);
+extern int GRID_find_islands(lua_State *L);
+extern int GRID_grow(lua_State *L);
+extern int GRID_shrink(lua_State *L);
+extern int GRID_remove_dots(lua_State *L);
+extern int GRID_distance_map(lua_State *L);
+
+extern int SEEDS_begin(lua_State *L);
+extern int SEEDS_end(lua_State *L);
+extern int SEEDS_set_diagonal(lua_State *L);
+extern int SEEDS_set_room(lua_State *L);
+extern int SEEDS_set_area(lua_State *L);
+extern int SEEDS_set_edge(lua_State *L);
+extern int SEEDS_room(lua_State *L);
+extern int SEEDS_area(lua_State *L);
+extern int SEEDS_has_edge(lua_State *L);
+extern int SEEDS_block_free(lua_State *L);
+extern int SEEDS_neighbor(lua_State *L);
+
+extern int GRAMMAR_compile(lua_State *L);
+extern int GRAMMAR_match(lua_State *L);
+
+extern int FIGHT_simulate(lua_State *L);
+
+extern int QGRAPH_build(lua_State *L);
+extern int QGRAPH_end(lua_State *L);
+extern int QGRAPH_set_quest(lua_State *L);
+extern int QGRAPH_split(lua_State *L);
+extern int QGRAPH_exit_dists(lua_State *L);
+extern int QGRAPH_entry_conns(lua_State *L);
+extern int QGRAPH_visit_order(lua_State *L);
+extern int QGRAPH_path(lua_State *L);
+
 static const luaL_Reg gui_script_funcs[] = {
 
     {"format_prefix", gui_format_prefix},
 
     {"raw_log_print", gui_raw_log_print},
     {"raw_debug_print", gui_raw_debug_print},
+    {"debug_enabled", gui_debug_enabled},
 
     {"gettext", gui_gettext},
     {"config_line", gui_config_line},
@@ -1265,6 +1346,7 @@ static const luaL_Reg gui_script_funcs[] = {
     {"rand_seed", gui_rand_seed},
     {"random", gui_random},
     {"random_int", gui_random_int},
+    {"rand_stream", gui_rand_stream},
 
     // file & directory functions
     {"import", gui_import},
@@ -1279,6 +1361,13 @@ static const luaL_Reg gui_script_funcs[] = {
     {"property", CSG_property},
     {"tex_property", CSG_tex_property},
     {"add_brush", CSG_add_brush},
+    {"brush_begin", CSG_brush_begin},
+    {"brush_verts", CSG_brush_verts},
+    {"brush_top", CSG_brush_top},
+    {"brush_bottom", CSG_brush_bottom},
+    {"brush_key", CSG_brush_key},
+    {"brush_prop", CSG_brush_prop},
+    {"brush_end", CSG_brush_end},
     {"add_entity", CSG_add_entity},
     {"trace_ray", CSG_trace_ray},
 
@@ -1348,6 +1437,45 @@ static const luaL_Reg gui_script_funcs[] = {
     {"spots_get_items", SPOT_get_items},
     {"spots_end", SPOT_end},
 
+    // GRID functions
+    {"grid_generate_cave", GRID_generate_cave},
+    {"grid_flood_fill", GRID_flood_fill},
+    {"grid_find_islands", GRID_find_islands},
+    {"grid_grow", GRID_grow},
+    {"grid_shrink", GRID_shrink},
+    {"grid_remove_dots", GRID_remove_dots},
+    {"grid_distance_map", GRID_distance_map},
+
+    // SEED functions
+    {"seeds_begin", SEEDS_begin},
+    {"seeds_end", SEEDS_end},
+    {"seed_set_diagonal", SEEDS_set_diagonal},
+    {"seed_set_room", SEEDS_set_room},
+    {"seed_set_area", SEEDS_set_area},
+    {"seed_set_edge", SEEDS_set_edge},
+    {"seed_room", SEEDS_room},
+    {"seed_area", SEEDS_area},
+    {"seed_has_edge", SEEDS_has_edge},
+    {"seeds_block_free", SEEDS_block_free},
+    {"seed_neighbor", SEEDS_neighbor},
+
+    // GRAMMAR functions
+    {"grammar_compile", GRAMMAR_compile},
+    {"grammar_match", GRAMMAR_match},
+
+    // FIGHT functions
+    {"fight_simulate", FIGHT_simulate},
+
+    // QUEST GRAPH functions
+    {"qgraph_build", QGRAPH_build},
+    {"qgraph_end", QGRAPH_end},
+    {"qgraph_set_quest", QGRAPH_set_quest},
+    {"qgraph_split", QGRAPH_split},
+    {"qgraph_exit_dists", QGRAPH_exit_dists},
+    {"qgraph_entry_conns", QGRAPH_entry_conns},
+    {"qgraph_visit_order", QGRAPH_visit_order},
+    {"qgraph_path", QGRAPH_path},
+
     {NULL, NULL}  // the end
 };
 
@@ -0,0 +1,619 @@
+//------------------------------------------------------------------------
+//  QUEST GRAPH
+//------------------------------------------------------------------------
+//
+//  OBSIDIAN Level Maker
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//------------------------------------------------------------------------
+//
+//  A native copy of the rooms and connections of a level, for the
+//  graph walking done by the quest planner (quest.lua).
+//
+//  Rooms and conns are known by their 'id' fields.  Each room keeps
+//  its conns in the same order as its R.conns list, and the conns are
+//  kept in the order of LEVEL.conns, so every walk here visits things
+//  in the same order as the Lua code did.  The script decides what to
+//  do with the results, and keeps the quest of each room up to date
+//  with qgraph_set_quest().
+//
+//------------------------------------------------------------------------
+
+#include <map>
+#include <vector>
+
+#include "hdr_lua.h"
+#include "headers.h"
+#include "lib_util.h"
+#include "main.h"
+#include "sys_xoshiro.h"
+
+class quest_graph_c {
+   public:
+    // per room, in the order given to qgraph_build()
+    std::vector<int> room_id;
+    std::vector<bool> hallway;
+    std::vector<int> quest;
+
+    // conn indexes, in the same order as R.conns
+    std::vector<std::vector<int>> room_conns;
+
+    // per conn, in the order of LEVEL.conns
+    std::vector<int> conn_id;
+    std::vector<int> conn_R1;
+    std::vector<int> conn_R2;
+
+    std::map<int, int> room_index;
+    std::map<int, int> conn_index;
+
+   public:
+    quest_graph_c() {}
+
+    ~quest_graph_c() {}
+
+    int NumRooms() const { return (int)room_id.size(); }
+
+    int OtherRoom(int c, int r) const {
+        return (conn_R1[c] == r) ? conn_R2[c] : conn_R1[c];
+    }
+
+    bool SameQuest(int c) const {
+        return quest[conn_R1[c]] == quest[conn_R2[c]];
+    }
+
+    // collects the rooms reachable from 'start' without leaving the
+    // quest or passing through the 'skip' conn, in depth-first order.
+    void Collect(int start, int skip, std::vector<int> &list) const {
+        std::vector<bool> seen(NumRooms(), false);
+
+        // each entry is a room and the position in its conn list
+        std::vector<std::pair<int, int>> stack;
+
+        seen[start] = true;
+        list.push_back(start);
+        stack.push_back(std::make_pair(start, 0));
+
+        while (!stack.empty()) {
+            int r = stack.back().first;
+            int pos = stack.back().second++;
+
+            if (pos >= (int)room_conns[r].size()) {
+                stack.pop_back();
+                continue;
+            }
+
+            int c = room_conns[r][pos];
+
+            if (c == skip || !SameQuest(c)) {
+                continue;
+            }
+
+            int r2 = OtherRoom(c, r);
+
+            if (seen[r2]) {
+                continue;
+            }
+
+            seen[r2] = true;
+            list.push_back(r2);
+            stack.push_back(std::make_pair(r2, 0));
+        }
+    }
+
+    // finds the first path (as a list of conns) from r1 to r2, like a
+    // depth-first search which never revisits a room on the current path.
+    bool FindPath(int r1, int r2, std::vector<int> &on_path,
+                  std::vector<int> &path) const {
+        for (int c : room_conns[r1]) {
+            int N = OtherRoom(c, r1);
+
+            if (N == r2) {
+                path.push_back(c);
+                return true;
+            }
+
+            if (on_path[N] > 0) {
+                continue;
+            }
+
+            on_path[r1] += 1;
+
+            bool found = FindPath(N, r2, on_path, path);
+
+            on_path[r1] -= 1;
+
+            if (found) {
+                path.insert(path.begin(), c);
+                return true;
+            }
+        }
+
+        return false;
+    }
+};
+
+static quest_graph_c *quest_graph;
+
+static void QGraph_Free() {
+    delete quest_graph;
+    quest_graph = NULL;
+}
+
+static quest_graph_c *QGraph_Get(lua_State *L) {
+    if (!quest_graph) {
+        luaL_error(L, "gui.qgraph: graph not built");
+    }
+
+    return quest_graph;
+}
+
+static int QGraph_Lookup(lua_State *L, const std::map<int, int> &index,
+                         int id, const char *what) {
+    auto it = index.find(id);
+
+    if (it == index.end()) {
+        return luaL_error(L, "gui.qgraph: unknown %s id %d", what, id);
+    }
+
+    return it->second;
+}
+
+static int QGraph_Room(lua_State *L, int arg) {
+    quest_graph_c *G = QGraph_Get(L);
+
+    return QGraph_Lookup(L, G->room_index, (int)luaL_checkinteger(L, arg),
+                         "room");
+}
+
+static int QGraph_Conn(lua_State *L, int arg) {
+    quest_graph_c *G = QGraph_Get(L);
+
+    return QGraph_Lookup(L, G->conn_index, (int)luaL_checkinteger(L, arg),
+                         "conn");
+}
+
+// reads obj[field].id, where obj is at the top of the stack
+static int QGraph_GetId(lua_State *L, const char *field) {
+    lua_getfield(L, -1, field);
+    lua_getfield(L, -1, "id");
+
+    int id = (int)luaL_checkinteger(L, -1);
+
+    lua_pop(L, 2);
+
+    return id;
+}
+
+static void QGraph_PushRoomList(lua_State *L, const std::vector<int> &list) {
+    lua_createtable(L, (int)list.size(), 0);
+
+    for (int i = 0; i < (int)list.size(); i++) {
+        lua_pushinteger(L, quest_graph->room_id[list[i]]);
+        lua_rawseti(L, -2, i + 1);
+    }
+}
+
+//------------------------------------------------------------------------
+//  LUA INTERFACE
+//------------------------------------------------------------------------
+
+// LUA: qgraph_build(rooms, conns)
+//
+// 'rooms' is the LEVEL.rooms list and 'conns' is LEVEL.conns.
+// Every room starts in quest 0.
+//
+int QGRAPH_build(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+    luaL_checktype(L, 2, LUA_TTABLE);
+
+    QGraph_Free();
+
+    quest_graph = new quest_graph_c();
+
+    quest_graph_c *G = quest_graph;
+
+    int num_rooms = (int)lua_rawlen(L, 1);
+    int num_conns = (int)lua_rawlen(L, 2);
+
+    for (int i = 1; i <= num_rooms; i++) {
+        lua_rawgeti(L, 1, i);
+
+        lua_getfield(L, -1, "id");
+        int id = (int)luaL_checkinteger(L, -1);
+        lua_pop(L, 1);
+
+        lua_getfield(L, -1, "is_hallway");
+        bool is_hallway = lua_toboolean(L, -1) ? true : false;
+        lua_pop(L, 1);
+
+        lua_pop(L, 1);
+
+        G->room_index[id] = (int)G->room_id.size();
+
+        G->room_id.push_back(id);
+        G->hallway.push_back(is_hallway);
+        G->quest.push_back(0);
+    }
+
+    for (int i = 1; i <= num_conns; i++) {
+        lua_rawgeti(L, 2, i);
+
+        lua_getfield(L, -1, "id");
+        int id = (int)luaL_checkinteger(L, -1);
+        lua_pop(L, 1);
+
+        int R1 = QGraph_Lookup(L, G->room_index, QGraph_GetId(L, "R1"), "room");
+        int R2 = QGraph_Lookup(L, G->room_index, QGraph_GetId(L, "R2"), "room");
+
+        lua_pop(L, 1);
+
+        G->conn_index[id] = (int)G->conn_id.size();
+
+        G->conn_id.push_back(id);
+        G->conn_R1.push_back(R1);
+        G->conn_R2.push_back(R2);
+    }
+
+    // the conns of each room, in R.conns order
+
+    G->room_conns.resize(num_rooms);
+
+    for (int i = 1; i <= num_rooms; i++) {
+        lua_rawgeti(L, 1, i);
+        lua_getfield(L, -1, "conns");
+
+        int count = lua_istable(L, -1) ? (int)lua_rawlen(L, -1) : 0;
+
+        for (int k = 1; k <= count; k++) {
+            lua_rawgeti(L, -1, k);
+            lua_getfield(L, -1, "id");
+
+            G->room_conns[i - 1].push_back(QGraph_Conn(L, -1));
+
+            lua_pop(L, 2);
+        }
+
+        lua_pop(L, 2);
+    }
+
+    return 0;
+}
+
+// LUA: qgraph_end()
+//
+int QGRAPH_end(lua_State *L) {
+    QGraph_Free();
+
+    return 0;
+}
+
+// LUA: qgraph_set_quest(room_id, quest_id)
+//
+int QGRAPH_set_quest(lua_State *L) {
+    int r = QGraph_Room(L, 1);
+
+    quest_graph->quest[r] = (int)luaL_checkinteger(L, 2);
+
+    return 0;
+}
+
+// LUA: qgraph_split(conn_id) --> before, after
+//
+// collects the rooms on each side of the connection, staying inside the
+// quest of the connection and never passing through it.  'before' are
+// the ids of the rooms reached from R1, and 'after' from R2.  When the
+// connection is not a bridge, both lists contain the whole quest.
+//
+int QGRAPH_split(lua_State *L) {
+    int c = QGraph_Conn(L, 1);
+
+    std::vector<int> before;
+    std::vector<int> after;
+
+    quest_graph->Collect(quest_graph->conn_R1[c], c, before);
+    quest_graph->Collect(quest_graph->conn_R2[c], c, after);
+
+    QGraph_PushRoomList(L, before);
+    QGraph_PushRoomList(L, after);
+
+    return 2;
+}
+
+// LUA: qgraph_exit_dists(sources) --> list
+//
+// 'sources' is a list of room ids which have a distance of zero.  The
+// distances spread through connections, but never between quests, with
+// a step of 1.0 (or 0.3 when either room is a hallway).
+//
+// returns a flat list of room id and distance pairs, for every room
+// which got a distance.
+//
+int QGRAPH_exit_dists(lua_State *L) {
+    quest_graph_c *G = QGraph_Get(L);
+
+    luaL_checktype(L, 1, LUA_TTABLE);
+
+    int count = (int)lua_rawlen(L, 1);
+
+    // check the room ids before the arrays exist, since luaL_error()
+    // would skip freeing them.
+    for (int i = 1; i <= count; i++) {
+        lua_rawgeti(L, 1, i);
+        QGraph_Room(L, -1);
+        lua_pop(L, 1);
+    }
+
+    int num_rooms = G->NumRooms();
+
+    std::vector<bool> has_dist(num_rooms, false);
+    std::vector<bool> is_source(num_rooms, false);
+    std::vector<double> dist(num_rooms, 0);
+
+    for (int i = 1; i <= count; i++) {
+        lua_rawgeti(L, 1, i);
+        int r = QGraph_Room(L, -1);  // cannot fail now
+        lua_pop(L, 1);
+
+        has_dist[r] = true;
+        is_source[r] = true;
+        dist[r] = 0;
+    }
+
+    // relax every connection in turn, until nothing changes.
+    // this is the same as the old Lua code, including the limit.
+
+    for (int loop = 1; loop <= 99; loop++) {
+        bool did_spread = false;
+
+        for (int c = 0; c < (int)G->conn_id.size(); c++) {
+            if (!G->SameQuest(c)) {
+                continue;
+            }
+
+            int R1 = G->conn_R1[c];
+            int R2 = G->conn_R2[c];
+
+            if (!has_dist[R1]) {
+                std::swap(R1, R2);
+            }
+
+            if (!has_dist[R1]) {
+                continue;
+            }
+
+            double step = 1.0;
+
+            if (G->hallway[R1] || G->hallway[R2]) {
+                step = 0.3;
+            }
+
+            double new_dist = dist[R1] + step;
+
+            if (!has_dist[R2] || dist[R2] > new_dist) {
+                has_dist[R2] = true;
+                dist[R2] = new_dist;
+
+                did_spread = true;
+            }
+        }
+
+        if (!did_spread) {
+            break;
+        }
+    }
+
+    lua_newtable(L);
+
+    int pos = 1;
+
+    for (int r = 0; r < num_rooms; r++) {
+        if (has_dist[r]) {
+            lua_pushinteger(L, G->room_id[r]);
+            lua_rawseti(L, -2, pos++);
+
+            // sources keep an integer zero, like the old code
+            if (is_source[r]) {
+                lua_pushinteger(L, 0);
+            } else {
+                lua_pushnumber(L, dist[r]);
+            }
+            lua_rawseti(L, -2, pos++);
+        }
+    }
+
+    return 1;
+}
+
+// LUA: qgraph_entry_conns(start_id) --> list
+//
+// walks the whole graph depth-first from the start room, returning
+// a flat list of room id and conn id pairs, where the conn is the one
+// used to first enter that room.  The start room is not included.
+//
+int QGRAPH_entry_conns(lua_State *L) {
+    quest_graph_c *G = QGraph_Get(L);
+
+    int start = QGraph_Room(L, 1);
+
+    std::vector<bool> seen(G->NumRooms(), false);
+    std::vector<std::pair<int, int>> stack;
+
+    seen[start] = true;
+    stack.push_back(std::make_pair(start, 0));
+
+    lua_newtable(L);
+
+    int pos = 1;
+
+    while (!stack.empty()) {
+        int r = stack.back().first;
+        int k = stack.back().second++;
+
+        if (k >= (int)G->room_conns[r].size()) {
+            stack.pop_back();
+            continue;
+        }
+
+        int c = G->room_conns[r][k];
+        int r2 = G->OtherRoom(c, r);
+
+        if (seen[r2]) {
+            continue;
+        }
+
+        seen[r2] = true;
+        stack.push_back(std::make_pair(r2, 0));
+
+        lua_pushinteger(L, G->room_id[r2]);
+        lua_rawseti(L, -2, pos++);
+
+        lua_pushinteger(L, G->conn_id[c]);
+        lua_rawseti(L, -2, pos++);
+    }
+
+    return 1;
+}
+
+// LUA: qgraph_visit_order(start_id, quest_along, rough_dists) --> list
+//
+// 'quest_along' is indexed by quest id, giving the lev_along of each
+// quest, and 'rough_dists' gives the rough_exit_dist of the rooms
+// (indexed by room id) which have one.
+//
+// returns the room ids in the order the player will most likely visit
+// them.  Like the old Lua code, a room may appear more than once, and
+// it uses random numbers to break ties.
+//
+int QGRAPH_visit_order(lua_State *L) {
+    quest_graph_c *G = QGraph_Get(L);
+
+    int start = QGraph_Room(L, 1);
+
+    luaL_checktype(L, 2, LUA_TTABLE);
+    luaL_checktype(L, 3, LUA_TTABLE);
+
+    int num_rooms = G->NumRooms();
+
+    std::vector<double> quest_along(num_rooms, 0);
+    std::vector<bool> has_rough(num_rooms, false);
+    std::vector<double> rough(num_rooms, 0);
+
+    for (int r = 0; r < num_rooms; r++) {
+        lua_rawgeti(L, 2, G->quest[r]);
+        quest_along[r] = lua_tonumber(L, -1);
+        lua_pop(L, 1);
+
+        lua_rawgeti(L, 3, G->room_id[r]);
+        if (!lua_isnil(L, -1)) {
+            has_rough[r] = true;
+            rough[r] = lua_tonumber(L, -1);
+        }
+        lua_pop(L, 1);
+    }
+
+    typedef struct {
+        int room;
+        double cost;
+    } visit_loc_t;
+
+    std::vector<visit_loc_t> next_locs;
+    std::vector<bool> visited(num_rooms, false);
+
+    next_locs.push_back({start, 0});
+
+    lua_newtable(L);
+
+    int pos = 1;
+
+    while (!next_locs.empty()) {
+        // take the cheapest location
+        int best = 0;
+
+        for (int i = 1; i < (int)next_locs.size(); i++) {
+            if (next_locs[i].cost < next_locs[best].cost) {
+                best = i;
+            }
+        }
+
+        int r = next_locs[best].room;
+
+        next_locs.erase(next_locs.begin() + best);
+
+        visited[r] = true;
+
+        lua_pushinteger(L, G->room_id[r]);
+        lua_rawseti(L, -2, pos++);
+
+        // collect which rooms to visit next
+        for (int c : G->room_conns[r]) {
+            int r2 = G->OtherRoom(c, r);
+
+            // done the other room?
+            if (visited[r2]) {
+                continue;
+            }
+
+            visit_loc_t loc = {r2, 0};
+
+            // we MUST honor the quest ordering
+            if (G->quest[r2] != G->quest[r]) {
+                loc.cost =
+                    100 + 100 * std::max(quest_along[r2], quest_along[r]);
+            } else if (has_rough[r2]) {
+                loc.cost = 80 - rough[r2];
+            }
+
+            // tie breaker
+            loc.cost = loc.cost + xoshiro_Double() * 0.1;
+
+            next_locs.push_back(loc);
+        }
+    }
+
+    return 1;
+}
+
+// LUA: qgraph_path(start_id, end_id) --> list
+//
+// returns the ids of the conns on a path between two rooms, or nil
+// when there is none.
+//
+int QGRAPH_path(lua_State *L) {
+    quest_graph_c *G = QGraph_Get(L);
+
+    int r1 = QGraph_Room(L, 1);
+    int r2 = QGraph_Room(L, 2);
+
+    if (r1 == r2) {
+        return luaL_error(L, "gui.qgraph_path: same room");
+    }
+
+    std::vector<int> on_path(G->NumRooms(), 0);
+    std::vector<int> path;
+
+    if (!G->FindPath(r1, r2, on_path, path)) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    lua_createtable(L, (int)path.size(), 0);
+
+    for (int i = 0; i < (int)path.size(); i++) {
+        lua_pushinteger(L, G->conn_id[path[i]]);
+        lua_rawseti(L, -2, i + 1);
+    }
+
+    return 1;
+}
+
+//--- editor settings ---
+// vi:ts=4:sw=4:noexpandtab
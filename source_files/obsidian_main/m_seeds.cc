@@ -0,0 +1,660 @@
+//------------------------------------------------------------------------
+//  SEED GRID
+//------------------------------------------------------------------------
+//
+//  OBSIDIAN Level Maker
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//------------------------------------------------------------------------
+//
+//  A native copy of the busiest fields of the seed map (seed.lua).
+//
+//  The seeds are still Lua tables, but their diagonal split, room and
+//  area ids and which sides have an edge are mirrored here, one array
+//  per field.  The SEED_CLASS setters keep this in sync, which lets
+//  neighbor lookups and "is this block free" queries run without
+//  touching the Lua tables at all.
+//
+//  Each seed has two halves: the bottom half (which is the whole seed
+//  when it is not split) and the top half of a diagonal seed.
+//
+//------------------------------------------------------------------------
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "hdr_lua.h"
+#include "headers.h"
+#include "lib_util.h"
+#include "main.h"
+
+class seed_grid_c {
+   public:
+    int W, H;
+
+    // per seed : 0 when square, otherwise the corner of the bottom
+    // half (1 or 3).  The top half has the opposite corner.
+    std::vector<byte> diagonal;
+
+    // per half : ids of the room and area, 0 for none
+    std::vector<int> room;
+    std::vector<int> area;
+
+    // per half : bit (1 << dir) set when that side has an edge
+    std::vector<unsigned short> edges;
+
+    // reference to the SEEDS table
+    int seeds_ref;
+
+   public:
+    seed_grid_c(int w, int h, int ref)
+        : W(w),
+          H(h),
+          diagonal(w * h, 0),
+          room(w * h * 2, 0),
+          area(w * h * 2, 0),
+          edges(w * h * 2, 0),
+          seeds_ref(ref) {}
+
+    ~seed_grid_c() {}
+
+    // coordinates are 1-based, like in the Lua code
+    inline bool Valid(int sx, int sy) const {
+        return (1 <= sx && sx <= W) && (1 <= sy && sy <= H);
+    }
+
+    inline int Seed(int sx, int sy) const { return (sx - 1) * H + (sy - 1); }
+
+    inline int Half(int sx, int sy, int top) const {
+        return Seed(sx, sy) * 2 + top;
+    }
+
+    // the corner of a half, 0 for a square seed, -1 for a dead half
+    // (the top of a seed which has been joined again).
+    inline int Corner(int sx, int sy, int top) const {
+        int diag = diagonal[Seed(sx, sy)];
+
+        if (top) {
+            return diag ? (10 - diag) : -1;
+        }
+
+        return diag;
+    }
+
+    bool BlockFree(int x1, int y1, int x2, int y2) const {
+        for (int x = x1; x <= x2; x++) {
+            const int *col = &room[Half(x, y1, 0)];
+
+            for (int y = 0; y <= y2 - y1; y++) {
+                if (col[y * 2] != 0) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+};
+
+static seed_grid_c *seed_grid;
+
+static void Seeds_Free(lua_State *L) {
+    if (seed_grid) {
+        luaL_unref(L, LUA_REGISTRYINDEX, seed_grid->seeds_ref);
+
+        delete seed_grid;
+        seed_grid = NULL;
+    }
+}
+
+static seed_grid_c *Seeds_Get(lua_State *L) {
+    if (!seed_grid) {
+        luaL_error(L, "gui.seeds: seed grid not created");
+    }
+
+    return seed_grid;
+}
+
+static void Seeds_CheckCoord(lua_State *L, int sx, int sy) {
+    if (!Seeds_Get(L)->Valid(sx, sy)) {
+        luaL_error(L, "gui.seeds: bad seed coord (%d %d)", sx, sy);
+    }
+}
+
+// the 'top' argument can be any value, like S.bottom, where nil or
+// false means the bottom half.
+static int Seeds_CheckHalf(lua_State *L, int arg) {
+    return lua_toboolean(L, arg) ? 1 : 0;
+}
+
+static int Seeds_OptId(lua_State *L, int arg) {
+    if (lua_isnoneornil(L, arg)) {
+        return 0;
+    }
+
+    return (int)luaL_checkinteger(L, arg);
+}
+
+static void Seeds_PushId(lua_State *L, int id) {
+    if (id == 0) {
+        lua_pushnil(L);
+    } else {
+        lua_pushinteger(L, id);
+    }
+}
+
+//------------------------------------------------------------------------
+//  LUA INTERFACE
+//------------------------------------------------------------------------
+
+// LUA: seeds_begin(SEEDS)
+//
+int SEEDS_begin(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+
+    lua_getfield(L, 1, "w");
+    lua_getfield(L, 1, "h");
+
+    int W = (int)luaL_checkinteger(L, -2);
+    int H = (int)luaL_checkinteger(L, -1);
+
+    lua_pop(L, 2);
+
+    if (W < 1 || H < 1) {
+        return luaL_error(L, "gui.seeds_begin: bad size");
+    }
+
+    Seeds_Free(L);
+
+    lua_pushvalue(L, 1);
+
+    seed_grid = new seed_grid_c(W, H, luaL_ref(L, LUA_REGISTRYINDEX));
+
+    return 0;
+}
+
+// LUA: seeds_end()
+//
+int SEEDS_end(lua_State *L) {
+    Seeds_Free(L);
+
+    return 0;
+}
+
+// LUA: seed_set_diagonal(sx, sy, diagonal)
+//
+// 'diagonal' is the corner of the bottom half, or nil to join it.
+//
+int SEEDS_set_diagonal(lua_State *L) {
+    int sx = (int)luaL_checkinteger(L, 1);
+    int sy = (int)luaL_checkinteger(L, 2);
+
+    int diag = Seeds_OptId(L, 3);
+
+    Seeds_CheckCoord(L, sx, sy);
+
+    if (!(diag == 0 || diag == 1 || diag == 3)) {
+        return luaL_argerror(L, 3, "bad diagonal");
+    }
+
+    seed_grid_c *G = seed_grid;
+
+    G->diagonal[G->Seed(sx, sy)] = diag;
+
+    if (diag == 0) {
+        // top half is dead now
+        int h = G->Half(sx, sy, 1);
+
+        G->room[h] = 0;
+        G->area[h] = 0;
+        G->edges[h] = 0;
+    }
+
+    return 0;
+}
+
+// LUA: seed_set_room(sx, sy, top, id)
+//
+int SEEDS_set_room(lua_State *L) {
+    int sx = (int)luaL_checkinteger(L, 1);
+    int sy = (int)luaL_checkinteger(L, 2);
+    int top = Seeds_CheckHalf(L, 3);
+    int id = Seeds_OptId(L, 4);
+
+    Seeds_CheckCoord(L, sx, sy);
+
+    seed_grid->room[seed_grid->Half(sx, sy, top)] = id;
+
+    return 0;
+}
+
+// LUA: seed_set_area(sx, sy, top, id)
+//
+int SEEDS_set_area(lua_State *L) {
+    int sx = (int)luaL_checkinteger(L, 1);
+    int sy = (int)luaL_checkinteger(L, 2);
+    int top = Seeds_CheckHalf(L, 3);
+    int id = Seeds_OptId(L, 4);
+
+    Seeds_CheckCoord(L, sx, sy);
+
+    seed_grid->area[seed_grid->Half(sx, sy, top)] = id;
+
+    return 0;
+}
+
+// LUA: seed_set_edge(sx, sy, top, dir)
+//
+int SEEDS_set_edge(lua_State *L) {
+    int sx = (int)luaL_checkinteger(L, 1);
+    int sy = (int)luaL_checkinteger(L, 2);
+    int top = Seeds_CheckHalf(L, 3);
+    int dir = (int)luaL_checkinteger(L, 4);
+
+    Seeds_CheckCoord(L, sx, sy);
+
+    if (dir < 1 || dir > 9) {
+        return luaL_argerror(L, 4, "bad dir");
+    }
+
+    seed_grid->edges[seed_grid->Half(sx, sy, top)] |= (1 << dir);
+
+    return 0;
+}
+
+// LUA: seed_room(sx, sy, top) --> id
+//
+int SEEDS_room(lua_State *L) {
+    int sx = (int)luaL_checkinteger(L, 1);
+    int sy = (int)luaL_checkinteger(L, 2);
+    int top = Seeds_CheckHalf(L, 3);
+
+    Seeds_CheckCoord(L, sx, sy);
+
+    Seeds_PushId(L, seed_grid->room[seed_grid->Half(sx, sy, top)]);
+    return 1;
+}
+
+// LUA: seed_area(sx, sy, top) --> id
+//
+int SEEDS_area(lua_State *L) {
+    int sx = (int)luaL_checkinteger(L, 1);
+    int sy = (int)luaL_checkinteger(L, 2);
+    int top = Seeds_CheckHalf(L, 3);
+
+    Seeds_CheckCoord(L, sx, sy);
+
+    Seeds_PushId(L, seed_grid->area[seed_grid->Half(sx, sy, top)]);
+    return 1;
+}
+
+// LUA: seed_has_edge(sx, sy, top, dir) --> boolean
+//
+int SEEDS_has_edge(lua_State *L) {
+    int sx = (int)luaL_checkinteger(L, 1);
+    int sy = (int)luaL_checkinteger(L, 2);
+    int top = Seeds_CheckHalf(L, 3);
+    int dir = (int)luaL_checkinteger(L, 4);
+
+    Seeds_CheckCoord(L, sx, sy);
+
+    int mask = seed_grid->edges[seed_grid->Half(sx, sy, top)];
+
+    lua_pushboolean(L, (dir >= 1 && dir <= 9 && (mask & (1 << dir))) ? 1 : 0);
+    return 1;
+}
+
+// LUA: seeds_block_free(sx1, sy1, sx2, sy2) --> boolean
+//
+// True when the whole block is on the map and no seed belongs to a
+// room yet.
+//
+int SEEDS_block_free(lua_State *L) {
+    int sx1 = (int)luaL_checkinteger(L, 1);
+    int sy1 = (int)luaL_checkinteger(L, 2);
+    int sx2 = (int)luaL_checkinteger(L, 3);
+    int sy2 = (int)luaL_checkinteger(L, 4);
+
+    seed_grid_c *G = Seeds_Get(L);
+
+    bool result = false;
+
+    if (sx1 <= sx2 && sy1 <= sy2 && G->Valid(sx1, sy1) &&
+        G->Valid(sx2, sy2)) {
+        result = G->BlockFree(sx1, sy1, sx2, sy2);
+    }
+
+    lua_pushboolean(L, result ? 1 : 0);
+    return 1;
+}
+
+// LUA: seed_neighbor(sx, sy, top, dir) --> SEED
+//
+// This is the logic of SEED_CLASS.neighbor().  The result is the
+// neighboring seed (or half), nil at the edge of the map, or false
+// when 'dir' makes no sense for this seed.
+//
+int SEEDS_neighbor(lua_State *L) {
+    int sx = (int)luaL_checkinteger(L, 1);
+    int sy = (int)luaL_checkinteger(L, 2);
+    int top = Seeds_CheckHalf(L, 3);
+    int dir = (int)luaL_checkinteger(L, 4);
+
+    Seeds_CheckCoord(L, sx, sy);
+
+    seed_grid_c *G = seed_grid;
+
+    int corner = G->Corner(sx, sy, top);
+
+    // the result, as a seed coordinate and half
+    int nx = sx;
+    int ny = sy;
+    int n_top = 0;
+
+    bool raw = false;
+
+    if (corner == 0) {
+        // square seeds
+        if (!(dir == 2 || dir == 4 || dir == 6 || dir == 8)) {
+            lua_pushboolean(L, 0);
+            return 1;
+        }
+
+        raw = true;
+    } else if (corner < 0) {
+        // dead halves have no neighbors
+        lua_pushboolean(L, 0);
+        return 1;
+    } else if (((corner == 7 || corner == 9) && dir == 8) ||
+               ((corner == 1 || corner == 3) && dir == 2) ||
+               ((corner == 1 || corner == 7) && dir == 4) ||
+               ((corner == 3 || corner == 9) && dir == 6)) {
+        raw = true;
+    } else if ((corner == 1 && dir == 9) || (corner == 3 && dir == 7)) {
+        // the other half of this seed
+        n_top = 1;
+    } else if ((corner == 7 && dir == 3) || (corner == 9 && dir == 1)) {
+        n_top = 0;
+    } else {
+        lua_pushboolean(L, 0);
+        return 1;
+    }
+
+    if (raw) {
+        nx += (dir == 6) ? 1 : (dir == 4) ? -1 : 0;
+        ny += (dir == 8) ? 1 : (dir == 2) ? -1 : 0;
+
+        if (!G->Valid(nx, ny)) {
+            lua_pushnil(L);
+            return 1;
+        }
+
+        int n_diag = G->diagonal[G->Seed(nx, ny)];
+
+        // we are looking into the other seed from 'dir', so pick the
+        // half which touches this side.
+        if (dir == 2 && n_diag) {
+            n_top = 1;
+        } else if (dir == 4 && n_diag == 1) {
+            n_top = 1;
+        } else if (dir == 6 && n_diag == 3) {
+            n_top = 1;
+        }
+    }
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, G->seeds_ref);
+    lua_rawgeti(L, -1, nx);
+    lua_rawgeti(L, -1, ny);
+
+    if (n_top) {
+        lua_getfield(L, -1, "top");
+    }
+
+    return 1;
+}
+
+//------------------------------------------------------------------------
+//  GRAMMAR MATCHING
+//------------------------------------------------------------------------
+//
+//  The shape grammar (grower.lua) tries each rule at every spot near
+//  a room, under all eight transforms.  Most spots fail because some
+//  element lands on a seed of the wrong sort, so each rule is compiled
+//  into a small table of element offsets, one set per transform, and
+//  every seed gets a bitmask of which sorts of element it could match.
+//  Only spots passing that test are handed back to the script, which
+//  still does the full match.
+//
+
+// bits which an element needs in the seed mask
+enum {
+    GNEED_INSIDE = (1 << 0),  // not on the edge of the map
+    GNEED_EMPTY = (1 << 1),   // no area at all    ['!' elements]
+    GNEED_FREE = (1 << 2),    // no area of room   ['.' elements]
+    GNEED_ROOM = (1 << 3),    // an area of room   [most others]
+};
+
+#define GRAMMAR_TRANSFORMS 8
+
+typedef struct {
+    int need;
+
+    // seed offsets, indexed by transpose*4 + flip_x*2 + flip_y
+    int dx[GRAMMAR_TRANSFORMS];
+    int dy[GRAMMAR_TRANSFORMS];
+} grammar_elem_t;
+
+static int Grammar_CharToNeed(char ch) {
+    switch (ch) {
+        case '!':
+            return GNEED_INSIDE | GNEED_EMPTY;
+        case '.':
+            return GNEED_INSIDE | GNEED_FREE;
+        case 'r':
+            return GNEED_INSIDE | GNEED_ROOM;
+        default:
+            return GNEED_INSIDE;
+    }
+}
+
+static int Grammar_SeedMask(const seed_grid_c *G, const std::vector<byte> &in_room,
+                            int sx, int sy) {
+    if (sx <= 1 || sx >= G->W || sy <= 1 || sy >= G->H) {
+        return 0;
+    }
+
+    int mask = GNEED_INSIDE | GNEED_EMPTY | GNEED_FREE | GNEED_ROOM;
+
+    int halves = G->diagonal[G->Seed(sx, sy)] ? 2 : 1;
+
+    for (int top = 0; top < halves; top++) {
+        int id = G->area[G->Half(sx, sy, top)];
+
+        if (id != 0) {
+            mask &= ~GNEED_EMPTY;
+        }
+
+        if (id > 0 && id < (int)in_room.size() && in_room[id]) {
+            mask &= ~GNEED_FREE;
+        } else {
+            mask &= ~GNEED_ROOM;
+        }
+    }
+
+    return mask;
+}
+
+// LUA: grammar_compile(w, h, needs) --> string
+//
+// 'needs' has one character per element of the input pattern, going
+// up each column in turn: '!' for nothing at all, '.' for no area of
+// the room, 'r' for an area of the room, and 'x' for anything else.
+// The result is an opaque string for grammar_match().
+//
+int GRAMMAR_compile(lua_State *L) {
+    int W = (int)luaL_checkinteger(L, 1);
+    int H = (int)luaL_checkinteger(L, 2);
+
+    size_t len;
+    const char *needs = luaL_checklstring(L, 3, &len);
+
+    if (W < 1 || H < 1 || (int)len != W * H) {
+        return luaL_error(L, "gui.grammar_compile: bad pattern size");
+    }
+
+    std::vector<grammar_elem_t> elems;
+
+    for (int px = 0; px < W; px++) {
+        for (int py = 0; py < H; py++) {
+            grammar_elem_t E;
+
+            E.need = Grammar_CharToNeed(needs[px * H + py]);
+
+            // same as transform_coord() in grower.lua
+            for (int t = 0; t < GRAMMAR_TRANSFORMS; t++) {
+                int dx = (t & 2) ? -px : px;
+                int dy = (t & 1) ? -py : py;
+
+                if (t & 4) {
+                    std::swap(dx, dy);
+                }
+
+                E.dx[t] = dx;
+                E.dy[t] = dy;
+            }
+
+            // the most selective elements go first
+            if (E.need != GNEED_INSIDE) {
+                elems.insert(elems.begin(), E);
+            } else {
+                elems.push_back(E);
+            }
+        }
+    }
+
+    lua_pushlstring(L, (const char *)elems.data(),
+                    elems.size() * sizeof(grammar_elem_t));
+    return 1;
+}
+
+// LUA: grammar_match(rule, transpose, flip_x, flip_y, x1, y1, x2, y2, areas)
+//      --> { x1, y1, x2, y2, ... }
+//
+// Finds the spots in the given range where the compiled 'rule' could
+// match.  'areas' lists the ids of the areas in the current room.
+// The spots are in the same order as looping over X, then Y.
+//
+int GRAMMAR_match(lua_State *L) {
+    size_t len;
+    const char *rule = luaL_checklstring(L, 1, &len);
+
+    int t = (lua_toboolean(L, 2) ? 4 : 0) | (lua_toboolean(L, 3) ? 2 : 0) |
+            (lua_toboolean(L, 4) ? 1 : 0);
+
+    int x1 = (int)luaL_checkinteger(L, 5);
+    int y1 = (int)luaL_checkinteger(L, 6);
+    int x2 = (int)luaL_checkinteger(L, 7);
+    int y2 = (int)luaL_checkinteger(L, 8);
+
+    luaL_checktype(L, 9, LUA_TTABLE);
+
+    if (len == 0 || (len % sizeof(grammar_elem_t)) != 0) {
+        return luaL_argerror(L, 1, "bad compiled rule");
+    }
+
+    seed_grid_c *G = Seeds_Get(L);
+
+    // a simple set of area ids
+    std::vector<byte> in_room;
+
+    int num_areas = (int)lua_rawlen(L, 9);
+
+    for (int i = 1; i <= num_areas; i++) {
+        lua_rawgeti(L, 9, i);
+        int id = (int)lua_tointeger(L, -1);
+        lua_pop(L, 1);
+
+        if (id > 0) {
+            if (id >= (int)in_room.size()) {
+                in_room.resize(id + 1, 0);
+            }
+
+            in_room[id] = 1;
+        }
+    }
+
+    // copy the rule, since the string may not be suitably aligned
+    std::vector<grammar_elem_t> elems(len / sizeof(grammar_elem_t));
+    memcpy(elems.data(), rule, len);
+
+    // compute the masks for every seed the pattern could touch.
+    // seeds off the map are left as zero.
+    int min_dx = 0, min_dy = 0;
+    int max_dx = 0, max_dy = 0;
+
+    for (const grammar_elem_t &E : elems) {
+        min_dx = MIN(min_dx, E.dx[t]);
+        min_dy = MIN(min_dy, E.dy[t]);
+        max_dx = MAX(max_dx, E.dx[t]);
+        max_dy = MAX(max_dy, E.dy[t]);
+    }
+
+    lua_newtable(L);
+
+    if (x2 < x1 || y2 < y1) {
+        return 1;
+    }
+
+    int bx = x1 + min_dx;
+    int by = y1 + min_dy;
+    int bw = (x2 + max_dx) - bx + 1;
+    int bh = (y2 + max_dy) - by + 1;
+
+    std::vector<byte> masks(bw * bh, 0);
+
+    for (int x = MAX(bx, 1); x < MIN(bx + bw, G->W + 1); x++) {
+        for (int y = MAX(by, 1); y < MIN(by + bh, G->H + 1); y++) {
+            masks[(x - bx) * bh + (y - by)] = Grammar_SeedMask(G, in_room, x, y);
+        }
+    }
+
+    int index = 1;
+
+    for (int x = x1; x <= x2; x++) {
+        for (int y = y1; y <= y2; y++) {
+            bool ok = true;
+
+            for (const grammar_elem_t &E : elems) {
+                int m = masks[(x + E.dx[t] - bx) * bh + (y + E.dy[t] - by)];
+
+                if ((m & E.need) != E.need) {
+                    ok = false;
+                    break;
+                }
+            }
+
+            if (ok) {
+                lua_pushinteger(L, x);
+                lua_rawseti(L, -2, index++);
+                lua_pushinteger(L, y);
+                lua_rawseti(L, -2, index++);
+            }
+        }
+    }
+
+    return 1;
+}
+
+//--- editor settings ---
+// vi:ts=4:sw=4:noexpandtab
@@ -30,6 +30,7 @@
 #include "headers.h"
 #include "lib_argv.h"
 #include "lib_file.h"
+#include "lib_signal.h"
 #include "lib_util.h"
 #include "m_addons.h"
 #include "m_cookie.h"
@@ -1093,6 +1094,9 @@ skiprest:
 
     LogInit(logging_file);
 
+    // flush the logs if we crash
+    Signal_CatchCrashes();
+
     if (argv::Find('d', "debug") >= 0) {
         debug_messages = true;
     }
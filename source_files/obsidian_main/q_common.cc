@@ -21,6 +21,8 @@
 #include "q_common.h"
 
 #include <algorithm>
+#include <atomic>
+#include <thread>
 
 #include "csg_main.h"
 #include "csg_quake.h"
@@ -838,5 +840,63 @@ int BSP_NiceMidwayPoint(float low, float extent) {
     return mid;
 }
 
+//------------------------------------------------------------------------
+
+int QCOM_NumThreads(int count) {
+    int threads = (int)std::thread::hardware_concurrency();
+
+    return CLAMP(1, threads, MAX(1, count));
+}
+
+bool QCOM_ParallelFor(int count, int tick,
+                      const std::function<void(int, int)> &func) {
+    std::atomic<int> next_item(0);
+    std::atomic<int> done_items(0);
+    std::atomic<bool> cancelled(false);
+
+    auto worker = [&](int thread) {
+        int last_tick = 0;
+
+        while (!cancelled) {
+            int i = next_item++;
+
+            if (i >= count) {
+                break;
+            }
+
+            func(thread, i);
+
+            int done = ++done_items;
+
+            // only the main thread may touch the GUI
+            if (thread == 0 && done / tick != last_tick) {
+                last_tick = done / tick;
+
+                Main::Ticker();
+
+                if (main_action >= MAIN_CANCEL) {
+                    cancelled = true;
+                }
+            }
+        }
+    };
+
+    int num_threads = QCOM_NumThreads(count);
+
+    std::vector<std::thread> threads;
+
+    for (int t = 1; t < num_threads; t++) {
+        threads.emplace_back(worker, t);
+    }
+
+    worker(0);
+
+    for (unsigned int t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+
+    return !cancelled;
+}
+
 //--- editor settings ---
 // vi:ts=4:sw=4:noexpandtab
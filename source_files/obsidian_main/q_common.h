@@ -21,6 +21,7 @@
 #ifndef Q_COMMON_H_
 #define Q_COMMON_H_
 
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -105,6 +106,17 @@ void BSP_WriteEntities(int lump_num, const char *description);
 // utility function
 int BSP_NiceMidwayPoint(float low, float extent);
 
+// the number of threads QCOM_ParallelFor uses for 'count' items
+int QCOM_NumThreads(int count);
+
+// calls func(thread, i) for every i in [0, count), spread over
+// QCOM_NumThreads(count) threads.  Items are handed out in order.
+// The calling thread works too (as thread 0), calling Main::Ticker()
+// every 'tick' items and stopping early if the user cancels.
+// Returns false when cancelled.
+bool QCOM_ParallelFor(int count, int tick,
+                      const std::function<void(int, int)> &func);
+
 // q_tjuncs.cc
 void QCOM_Fix_T_Junctions();
 
@@ -25,6 +25,9 @@
 
 #include "q_light.h"
 
+#include <algorithm>
+#include <memory>
+
 #include "csg_main.h"
 #include "csg_quake.h"
 #include "fmt/core.h"
@@ -51,6 +54,13 @@ static float q_light_scale = 1.0;
 
 static float q3_luxel_size = 12.0;
 
+// Q3 lightmap pages are square.  Quake 3 itself only handles 128x128,
+// larger sizes are for engines which support them.
+#define MIN_Q3_LIGHTMAP_SIZE 128
+#define MAX_Q3_LIGHTMAP_SIZE 2048
+
+int q3_lightmap_size = 128;
+
 static bool q3_overbrighting = false;
 
 static float grid_ambient_scale = 4.0;
@@ -96,6 +106,7 @@ void QLIT_InitProperties() {
     q_mono_lighting = false;
 
     q3_luxel_size = 12.0;
+    q3_lightmap_size = 128;
     q3_overbrighting = false;
 
     q_light_scale = 1.0;
@@ -159,6 +170,17 @@ bool QLIT_ParseProperty(std::string key, std::string value) {
     {
         q3_luxel_size = StringToDouble(value);
         return true;
+    } else if (StringCaseCmp(key, "q3_lightmap_size") == 0)  // Q3 only
+    {
+        // must be a power of two
+        int size = MIN_Q3_LIGHTMAP_SIZE;
+
+        while (size < StringToInt(value) && size < MAX_Q3_LIGHTMAP_SIZE) {
+            size *= 2;
+        }
+
+        q3_lightmap_size = size;
+        return true;
     } else if (StringCaseCmp(key, "q3_overbrighting") == 0)  // Q3 only
     {
         q3_overbrighting = (StringToInt(value) > 0);
@@ -324,128 +346,170 @@ void qLightmap_c::Write(qLump_c *lump) {
 
 //------------------------------------------------------------------------
 
-#define LIGHTMAP_WIDTH 128
-#define LIGHTMAP_HEIGHT 128
-
 class q3_lightmap_block_c {
    public:
-    byte samples[LIGHTMAP_WIDTH][LIGHTMAP_HEIGHT][3];
+    int size;
+
+    // RGB samples, row by row
+    std::vector<byte> samples;
 
-    // index of first free luxel in each column of this block.
-    // hence 0 is completely empty, LIGHTMAP_HEIGHT is completely full.
-    int free_y[LIGHTMAP_WIDTH];
+    // luxels allocated so far
+    int used;
 
-    int fail_count;
+   private:
+    // the skyline : each segment is a run of columns which are free
+    // from 'y' upwards.  Segments are sorted by x, cover the whole
+    // width, and neighbors never have the same height.
+    struct segment_t {
+        int x, y, w;
+    };
+
+    std::vector<segment_t> skyline;
 
    public:
-    q3_lightmap_block_c() : fail_count(0) {
-        memset(samples, 0, sizeof(samples));
+    q3_lightmap_block_c(int _size) : size(_size), used(0) {
+        samples.resize(size * size * 3, 0);
 
-        for (int i = 0; i < LIGHTMAP_WIDTH; i++) {
-            free_y[i] = 0;
-        }
+        skyline.push_back(segment_t{0, 0, size});
     }
 
     ~q3_lightmap_block_c() {}
 
-    int Low_Y(int x, int w) {
-        int y = 0;
+    inline byte *Sample(int x, int y) { return &samples[(y * size + x) * 3]; }
 
-        for (; w > 0; x++, w--) {
-            y = MAX(y, free_y[x]);
+   private:
+    // check if a block of width 'bw' fits at the start of segment 'i',
+    // returning the y coordinate and how much area would be wasted
+    // underneath it.
+    bool Fits(unsigned int i, int bw, int bh, int *y, int *waste) const {
+        if (skyline[i].x + bw > size) {
+            return false;
         }
 
-        return y;
-    }
+        int top = 0;
+        int remain = bw;
+
+        for (unsigned int k = i; remain > 0; k++) {
+            top = MAX(top, skyline[k].y);
+            remain -= skyline[k].w;
+        }
+
+        if (top + bh > size) {
+            return false;
+        }
 
-    int WastedArea(int x, int y, int w) {
         int area = 0;
+        remain = bw;
+
+        for (unsigned int k = i; remain > 0; k++) {
+            int w = MIN(remain, skyline[k].w);
 
-        for (; w > 0; x++, w--) {
-            area += (y - free_y[x]);
+            area += (top - skyline[k].y) * w;
+            remain -= w;
         }
 
-        return area;
-    }
+        *y = top;
+        *waste = area;
 
-    // attempt to allocate a block
-    bool Alloc(int bw, int bh, int *bx, int *by) {
-#if 0
-		// skip when failure count reaches a certain limit
-		if (fail_count & 64)
-			return false;
-#endif
+        return true;
+    }
 
-        *bx = -1;
-        *by = -1;
+    void Place(unsigned int i, int x, int y, int bw, int bh) {
+        skyline.insert(skyline.begin() + i, segment_t{x, y + bh, bw});
 
-        int best_area = (1 << 30);
+        // shrink or remove the segments now underneath the block
+        unsigned int k = i + 1;
 
-        // find column that will waste the least amount of space
+        while (k < skyline.size()) {
+            segment_t &S = skyline[k];
 
-        for (int x = 0; x < LIGHTMAP_WIDTH - bw + 1; x++) {
-            int y = Low_Y(x, bw);
+            int cut = x + bw - S.x;
 
-            if (y + bh > LIGHTMAP_HEIGHT) {
-                continue;
+            if (cut <= 0) {
+                break;
             }
 
-            int area = WastedArea(x, y, bw);
+            if (cut < S.w) {
+                S.x += cut;
+                S.w -= cut;
+                break;
+            }
 
-            if (area < best_area) {
-                *bx = x;
-                *by = y;
+            skyline.erase(skyline.begin() + k);
+        }
 
-                best_area = area;
+        // merge neighbors at the same height
+        for (k = 0; k + 1 < skyline.size();) {
+            if (skyline[k].y == skyline[k + 1].y) {
+                skyline[k].w += skyline[k + 1].w;
+                skyline.erase(skyline.begin() + k + 1);
+            } else {
+                k++;
             }
         }
+    }
 
-        if (*bx < 0) {
-            fail_count++;
+   public:
+    // attempt to allocate a block.  Picks the position which wastes the
+    // least area under the block, preferring the lowest one.
+    bool Alloc(int bw, int bh, int *bx, int *by) {
+        if (used + bw * bh > size * size) {
             return false;
         }
 
-        // mark area as used
+        int best_i = -1;
+        int best_y = 0;
+        int best_waste = 0;
+
+        for (unsigned int i = 0; i < skyline.size(); i++) {
+            int y, waste;
+
+            if (!Fits(i, bw, bh, &y, &waste)) {
+                continue;
+            }
+
+            if (best_i < 0 || waste < best_waste ||
+                (waste == best_waste && y < best_y)) {
+                best_i = (int)i;
+                best_y = y;
+                best_waste = waste;
+            }
+        }
 
-        for (int i = 0; i < bw; i++) {
-            free_y[*bx + i] = *by + bh;
+        if (best_i < 0) {
+            return false;
         }
 
+        *bx = skyline[best_i].x;
+        *by = best_y;
+
+        Place(best_i, *bx, *by, bw, bh);
+
+        used += bw * bh;
+
         return true;  // Ok
     }
 
     void Write(qLump_c *lump) const {
-        for (int y = 0; y < LIGHTMAP_HEIGHT; y++) {
-            for (int x = 0; x < LIGHTMAP_WIDTH; x++) {
-                for (int c = 0; c < 3; c++) {
-                    lump->Append(&samples[x][y][c], 1);
-                }
-            }
-        }
+        lump->Append(samples.data(), samples.size());
     }
 
     void SavePPM(FILE *fp) {
         fmt::print(fp, "P6\n");
-        fmt::print(fp, "128 128\n");
+        fmt::print(fp, "{} {}\n", size, size);
         fmt::print(fp, "255\n");
 
-        for (int y = 0; y < LIGHTMAP_HEIGHT; y++) {
-            for (int x = 0; x < LIGHTMAP_WIDTH; x++) {
-                for (int c = 0; c < 3; c++) {
-                    fputc(samples[x][y][c], fp);
-                }
-            }
-        }
+        fwrite(samples.data(), 1, samples.size(), fp);
     }
 };
 
 static std::vector<q3_lightmap_block_c *> all_q3_light_blocks;
 
 static int Q3_AllocLightBlock(int bw, int bh, int *bx, int *by) {
-    // returns the block index numebr
+    // returns the block index number
 
-    SYS_ASSERT(bw <= LIGHTMAP_WIDTH);
-    SYS_ASSERT(bh <= LIGHTMAP_HEIGHT);
+    SYS_ASSERT(bw <= q3_lightmap_size);
+    SYS_ASSERT(bh <= q3_lightmap_size);
 
     for (unsigned int k = 0; k < all_q3_light_blocks.size(); k++) {
         q3_lightmap_block_c *BL = all_q3_light_blocks[k];
@@ -459,7 +523,7 @@ static int Q3_AllocLightBlock(int bw, int bh, int *bx, int *by) {
 
     int bnum = (int)all_q3_light_blocks.size();
 
-    q3_lightmap_block_c *BL = new q3_lightmap_block_c;
+    q3_lightmap_block_c *BL = new q3_lightmap_block_c(q3_lightmap_size);
 
     all_q3_light_blocks.push_back(BL);
 
@@ -492,12 +556,10 @@ void QLIT_FreeLightmaps() {
     }
 }
 
+// this may be called from any lighting thread, so the new lightmap
+// is only added to qk_all_lightmaps once all faces are done.
 static qLightmap_c *QLIT_NewLightmap(int w, int h) {
-    qLightmap_c *lmap = new qLightmap_c(w, h);
-
-    qk_all_lightmaps.push_back(lmap);
-
-    return lmap;
+    return new qLightmap_c(w, h);
 }
 
 static void WriteFlatBlock(int level, int count) {
@@ -537,8 +599,8 @@ void QLIT_BuildLightingLump(int lump, int max_size) {
 }
 
 void QLIT_BuildQ3Lighting(int lump, int max_size) {
-    // pack individual lightmaps into the 128x128 blocks
-    // [ this is lousy for memory usage.... ]
+    // the individual lightmaps were packed into blocks by
+    // Q3_PlaceLightmaps(), here they are simply written out
 
     lightmap_lump = BSP_NewLump(lump);
 
@@ -555,7 +617,18 @@ void QLIT_BuildQ3Lighting(int lump, int max_size) {
 #endif
     }
 
-    LogPrintf("created {} LM blocks\n", (int)all_q3_light_blocks.size());
+    int total = (int)all_q3_light_blocks.size();
+    int used = 0;
+
+    for (const q3_lightmap_block_c *BL : all_q3_light_blocks) {
+        used += BL->used;
+    }
+
+    double area = (double)total * q3_lightmap_size * q3_lightmap_size;
+
+    LogPrintf("created {} LM blocks ({}x{}), {:.1f}% used\n", total,
+              q3_lightmap_size, q3_lightmap_size,
+              area > 0 ? used * 100.0 / area : 0.0);
 }
 
 //------------------------------------------------------------------------
@@ -572,31 +645,37 @@ typedef struct {
 
 } light_point_t;
 
-// Lighting variables
+#define MAX_LM_SIZE 64
 
-static quake_face_c *lt_face;
+// Lighting variables for the face being lit.  Each lighting thread
+// has its own copy, so faces can be lit in parallel.
 
-static double lt_plane_normal[3];
-static double lt_plane_dist;
+struct light_context_t {
+    quake_face_c *face;
 
-static quake_bbox_c lt_face_bbox;
+    double plane_normal[3];
+    double plane_dist;
 
-static int lt_W, lt_H;
+    quake_bbox_c face_bbox;
 
-static int lt_current_style;
+    int W, H;
 
-#define MAX_LM_SIZE 64
+    // lights which may reach this face, normal lights first and then
+    // grouped by style (see QLIT_GatherLights)
+    std::vector<const quake_light_t *> lights;
+    std::vector<unsigned int> light_nums;
 
-static light_point_t lt_points[MAX_LM_SIZE * 2][MAX_LM_SIZE * 2];
+    light_point_t points[MAX_LM_SIZE * 2][MAX_LM_SIZE * 2];
 
-static int blocklights[MAX_LM_SIZE * 2][MAX_LM_SIZE * 2][3];
+    int blocklights[MAX_LM_SIZE * 2][MAX_LM_SIZE * 2][3];
+};
 
-static void Q1_CalcFaceStuff(quake_face_c *F) {
-    lt_plane_normal[0] = F->plane.nx;
-    lt_plane_normal[1] = F->plane.ny;
-    lt_plane_normal[2] = F->plane.nz;
+static void Q1_CalcFaceStuff(light_context_t &ctx, quake_face_c *F) {
+    ctx.plane_normal[0] = F->plane.nx;
+    ctx.plane_normal[1] = F->plane.ny;
+    ctx.plane_normal[2] = F->plane.nz;
 
-    lt_plane_dist = F->plane.CalcDist();
+    ctx.plane_dist = F->plane.CalcDist();
 
     /* Calc Vectors... */
 
@@ -616,7 +695,7 @@ static void Q1_CalcFaceStuff(quake_face_c *F) {
 
     // calculate a normal to the texture axis.  points can be moved
     // along this without changing their S/T
-    static quake_plane_c texnormal;
+    quake_plane_c texnormal;
 
     texnormal.nx = UV->s[2] * UV->t[1] - UV->s[1] * UV->t[2];
     texnormal.ny = UV->s[0] * UV->t[2] - UV->s[2] * UV->t[0];
@@ -625,9 +704,9 @@ static void Q1_CalcFaceStuff(quake_face_c *F) {
     texnormal.Normalize();
 
     // flip it towards plane normal
-    double distscale = texnormal.nx * lt_plane_normal[0] +
-                       texnormal.ny * lt_plane_normal[1] +
-                       texnormal.nz * lt_plane_normal[2];
+    double distscale = texnormal.nx * ctx.plane_normal[0] +
+                       texnormal.ny * ctx.plane_normal[1] +
+                       texnormal.nz * ctx.plane_normal[2];
 
     if (distscale < 0) {
         distscale = -distscale;
@@ -643,9 +722,9 @@ static void Q1_CalcFaceStuff(quake_face_c *F) {
                         lt_worldtotex[i][1] * lt_worldtotex[i][1] +
                         lt_worldtotex[i][2] * lt_worldtotex[i][2];
 
-        double dist = lt_worldtotex[i][0] * lt_plane_normal[0] +
-                      lt_worldtotex[i][1] * lt_plane_normal[1] +
-                      lt_worldtotex[i][2] * lt_plane_normal[2];
+        double dist = lt_worldtotex[i][0] * ctx.plane_normal[0] +
+                      lt_worldtotex[i][1] * ctx.plane_normal[1] +
+                      lt_worldtotex[i][2] * ctx.plane_normal[2];
 
         dist = dist * distscale / len_sq;
 
@@ -666,9 +745,9 @@ static void Q1_CalcFaceStuff(quake_face_c *F) {
 
     // AJA: I assume the "- 1" here means the sampling points are 1 unit
     //      away from the face.
-    double o_dist = lt_texorg[0] * lt_plane_normal[0] +
-                    lt_texorg[1] * lt_plane_normal[1] +
-                    lt_texorg[2] * lt_plane_normal[2] - lt_plane_dist - 1.0;
+    double o_dist = lt_texorg[0] * ctx.plane_normal[0] +
+                    lt_texorg[1] * ctx.plane_normal[1] +
+                    lt_texorg[2] * ctx.plane_normal[2] - ctx.plane_dist - 1.0;
 
     o_dist *= distscale;
 
@@ -699,12 +778,12 @@ static void Q1_CalcFaceStuff(quake_face_c *F) {
     lt_tex_mins[0] = bmin_s;
     lt_tex_mins[1] = bmin_t;
 
-    lt_W = MAX(2, bmax_s - bmin_s + 1);
-    lt_H = MAX(2, bmax_t - bmin_t + 1);
+    ctx.W = MAX(2, bmax_s - bmin_s + 1);
+    ctx.H = MAX(2, bmax_t - bmin_t + 1);
 
-    /// fprintf(stderr, "FACE %p  EXTENTS %d %d\n", F, lt_W, lt_H);
+    /// fprintf(stderr, "FACE %p  EXTENTS %d %d\n", F, ctx.W, ctx.H);
 
-    F->lmap = QLIT_NewLightmap(lt_W, lt_H);
+    F->lmap = QLIT_NewLightmap(ctx.W, ctx.H);
 
     /* Calc Points... */
 
@@ -716,19 +795,19 @@ static void Q1_CalcFaceStuff(quake_face_c *F) {
 
     if (q_light_quality > 0)  // "best" mode
     {
-        s_step = 16 * (lt_W - 1) / (float)(lt_W * 2 - 1);
-        t_step = 16 * (lt_H - 1) / (float)(lt_H * 2 - 1);
+        s_step = 16 * (ctx.W - 1) / (float)(ctx.W * 2 - 1);
+        t_step = 16 * (ctx.H - 1) / (float)(ctx.H * 2 - 1);
 
-        lt_W *= 2;
-        lt_H *= 2;
+        ctx.W *= 2;
+        ctx.H *= 2;
     }
 
-    for (int t = 0; t < lt_H; t++) {
-        for (int s = 0; s < lt_W; s++) {
+    for (int t = 0; t < ctx.H; t++) {
+        for (int s = 0; s < ctx.W; s++) {
             float us = s_start + s * s_step;
             float ut = t_start + t * t_step;
 
-            light_point_t &P = lt_points[s][t];
+            light_point_t &P = ctx.points[s][t];
 
             P.x = lt_texorg[0] + lt_textoworld[0][0] * us +
                   lt_textoworld[1][0] * ut;
@@ -792,7 +871,7 @@ static bool CheckLightPoint(light_point_t &P, quake_face_c *F, double s,
     return !(P.medium == MEDIUM_OFF_FACE || P.medium == MEDIUM_SOLID);
 }
 
-static void Q3_CalcFaceStuff(quake_face_c *F) {
+static void Q3_CalcFaceStuff(light_context_t &ctx, quake_face_c *F) {
     float px = F->plane.x;
     float py = F->plane.y;
     float pz = F->plane.z;
@@ -805,11 +884,11 @@ static void Q3_CalcFaceStuff(quake_face_c *F) {
     // [ i.e. vert[i] * N == n_dist, where '*' is dot product ]
     double n_dist = px * nx + py * ny + pz * nz;
 
-    lt_plane_normal[0] = nx;
-    lt_plane_normal[1] = ny;
-    lt_plane_normal[2] = nz;
+    ctx.plane_normal[0] = nx;
+    ctx.plane_normal[1] = ny;
+    ctx.plane_normal[2] = nz;
 
-    lt_plane_dist = F->plane.CalcDist();
+    ctx.plane_dist = F->plane.CalcDist();
 
     // compute T vector that basically goes "up" the slope of the
     // face's plane.  If the plane is purely vertical, direction of
@@ -840,11 +919,6 @@ static void Q3_CalcFaceStuff(quake_face_c *F) {
     // once here: N, T and S are three unit vectors which are
     // orthogonal to each other.
 
-    fmt::print(stderr, "Face {}\n", static_cast<const void *>(F));
-    fmt::print(stderr, "  n = ({:+5.4} {:+5.4} {:+5.4})\n", nx, ny, nz);
-    fmt::print(stderr, "  t = ({:+5.4} {:+5.4} {:+5.4})\n", tx, ty, tz);
-    fmt::print(stderr, "  s = ({:+5.4} {:+5.4} {:+5.4})\n", sx, sy, sz);
-
     // compute extents in the ST space...
 
     double min_s = +9e9;
@@ -875,9 +949,6 @@ static void Q3_CalcFaceStuff(quake_face_c *F) {
     avg_s /= (double)(F->verts.size());
     avg_t /= (double)(F->verts.size());
 
-    fmt::print(stderr, "  t range: %+8.2f .. %+8.2f\n", min_t, max_t);
-    fmt::print(stderr, "  s range: %+8.2f .. %+8.2f\n", min_s, max_s);
-
 #if 0  // DEBUG
 	for (unsigned int k = 0 ; k < F->verts.size() ; k++)
 	{
@@ -902,15 +973,13 @@ static void Q3_CalcFaceStuff(quake_face_c *F) {
 #endif
 
     // compute size of lightmap
-    lt_W = (int)ceil((max_s - min_s + q3_luxel_size * 0.6) / q3_luxel_size);
-    lt_H = (int)ceil((max_t - min_t + q3_luxel_size * 0.6) / q3_luxel_size);
-
-    fmt::print(stderr, "LM SIZE: %d x {}\n", lt_W, lt_H);
+    ctx.W = (int)ceil((max_s - min_s + q3_luxel_size * 0.6) / q3_luxel_size);
+    ctx.H = (int)ceil((max_t - min_t + q3_luxel_size * 0.6) / q3_luxel_size);
 
-    lt_W = CLAMP(1, lt_W, MAX_LM_SIZE);
-    lt_H = CLAMP(1, lt_H, MAX_LM_SIZE);
+    ctx.W = CLAMP(1, ctx.W, MAX_LM_SIZE);
+    ctx.H = CLAMP(1, ctx.H, MAX_LM_SIZE);
 
-    F->lmap = QLIT_NewLightmap(lt_W, lt_H);
+    F->lmap = QLIT_NewLightmap(ctx.W, ctx.H);
 
     // compute the UV matrix...
     // [ the offsets in s[3] and t[3] are updated later, when block is allocated
@@ -918,8 +987,8 @@ static void Q3_CalcFaceStuff(quake_face_c *F) {
 
     uv_matrix_c *mat = F->lmap->lm_mat;
 
-    double s3 = (lt_W - 1) / (double)LIGHTMAP_WIDTH;
-    double t3 = (lt_H - 1) / (double)LIGHTMAP_HEIGHT;
+    double s3 = (ctx.W - 1) / (double)q3_lightmap_size;
+    double t3 = (ctx.H - 1) / (double)q3_lightmap_size;
 
     double s_mul = s3 / (max_s - min_s);
     double t_mul = t3 / (max_t - min_t);
@@ -949,31 +1018,31 @@ static void Q3_CalcFaceStuff(quake_face_c *F) {
     // create the points...
 
     // nudge amounts
-    double s_nudge = 0.6 / (lt_W + 1);
-    double t_nudge = 0.6 / (lt_H + 1);
+    double s_nudge = 0.6 / (ctx.W + 1);
+    double t_nudge = 0.6 / (ctx.H + 1);
 
     const float away = 0.5;
 
     if (q_light_quality > 0) {
-        lt_W *= 2;
-        lt_H *= 2;
+        ctx.W *= 2;
+        ctx.H *= 2;
     }
 
-    for (int py = 0; py < lt_H; py++) {
-        for (int px = 0; px < lt_W; px++) {
-            float ax = (lt_W == 1) ? 0.5 : px / (float)(lt_W - 1);
-            float ay = (lt_H == 1) ? 0.5 : py / (float)(lt_H - 1);
+    for (int py = 0; py < ctx.H; py++) {
+        for (int px = 0; px < ctx.W; px++) {
+            float ax = (ctx.W == 1) ? 0.5 : px / (float)(ctx.W - 1);
+            float ay = (ctx.H == 1) ? 0.5 : py / (float)(ctx.H - 1);
 
             ax = 0.5 + (ax - 0.5) * 0.98;
             ay = 0.5 + (ay - 0.5) * 0.98;
 
-            light_point_t &P = lt_points[px][py];
+            light_point_t &P = ctx.points[px][py];
 
             // if the point is off the face or inside a solid brush,
             // try some locations closer to the middle of the face.
             for (int nudge = 0; nudge < 4; nudge++) {
-                double s = (lt_W == 1) ? avg_s : (min_s + (max_s - min_s) * ax);
-                double t = (lt_H == 1) ? avg_t : (min_t + (max_t - min_t) * ay);
+                double s = (ctx.W == 1) ? avg_s : (min_s + (max_s - min_s) * ax);
+                double t = (ctx.H == 1) ? avg_t : (min_t + (max_t - min_t) * ay);
 
                 if (nudge > 0) {
                     // nudge coordinate towards center of face
@@ -1001,19 +1070,19 @@ static void Q3_CalcFaceStuff(quake_face_c *F) {
     }
 }
 
-static void ClearLightBuffer(int level) {
+static void ClearLightBuffer(light_context_t &ctx, int level) {
     level <<= 8;
 
-    for (int s = 0; s < lt_W; s++) {
-        for (int t = 0; t < lt_H; t++) {
+    for (int s = 0; s < ctx.W; s++) {
+        for (int t = 0; t < ctx.H; t++) {
             for (int c = 0; c < 3; c++) {
-                blocklights[s][t][c] = level;
+                ctx.blocklights[s][t][c] = level;
             }
         }
     }
 }
 
-void qLightmap_c::Store() {
+void qLightmap_c::Store(const light_context_t &ctx) {
     rgb_color_t *dest = current_pos;
 
     float scale = q_light_scale / 1024.0;
@@ -1026,9 +1095,9 @@ void qLightmap_c::Store() {
 
     for (int t = 0; t < height; t++) {
         for (int s = 0; s < width; s++) {
-            float r = blocklights[s][t][0] * scale;
-            float g = blocklights[s][t][1] * scale;
-            float b = blocklights[s][t][2] * scale;
+            float r = ctx.blocklights[s][t][0] * scale;
+            float g = ctx.blocklights[s][t][1] * scale;
+            float b = ctx.blocklights[s][t][2] * scale;
 
             float ity = MAX(r, MAX(g, b));
 
@@ -1047,22 +1116,20 @@ void qLightmap_c::Store() {
             *dest++ = MAKE_RGBA(r2, g2, b2, 0);
         }
     }
+}
 
-    if (qk_game >= 3 && isDark()) {
-        fmt::print(stderr, "DARK LIGHTMAP !\n");
+void qLightmap_c::PlaceInBlock() {
+    if (isDark()) {
         offset = 0;
-    } else if (qk_game >= 3) {
+    } else {
         // this is lousy for memory usage...
         // [ but some stuff is using samples[], like CalcAverage() ]
 
         offset = Q3_AllocLightBlock(width, height, &lx, &ly);
         SYS_ASSERT(offset >= 0);
 
-        fmt::print(stderr, "LM POSITION: block #{} ({:3} {})\n", offset, lx,
-                   ly);
-
-        double s1 = (lx + 0.5) / (double)LIGHTMAP_WIDTH;
-        double t1 = (ly + 0.5) / (double)LIGHTMAP_HEIGHT;
+        double s1 = (lx + 0.5) / (double)q3_lightmap_size;
+        double t1 = (ly + 0.5) / (double)q3_lightmap_size;
 
         lm_mat->s[3] += s1;
         lm_mat->t[3] += t1;
@@ -1074,30 +1141,29 @@ void qLightmap_c::Store() {
             for (int x = 0; x < width; x++) {
                 const rgb_color_t col = At(x, y);
 
-                const int bx = lx + x;
-                const int by = ly + y;
+                byte *dest = BL->Sample(lx + x, ly + y);
 
-                BL->samples[bx][by][0] = RGB_RED(col);
-                BL->samples[bx][by][1] = RGB_GREEN(col);
-                BL->samples[bx][by][2] = RGB_BLUE(col);
+                dest[0] = RGB_RED(col);
+                dest[1] = RGB_GREEN(col);
+                dest[2] = RGB_BLUE(col);
             }
         }
     }
 }
 
-static bool Luxel_HasSetNeighbor(int s, int t) {
+static bool Luxel_HasSetNeighbor(const light_context_t &ctx, int s, int t) {
     for (int side = 0; side < 4; side++) {
         int ds = (side == 0) ? -1 : (side == 1) ? +1 : 0;
         int dt = (side == 2) ? -1 : (side == 3) ? +1 : 0;
 
-        if (s + ds < 0 || s + ds >= lt_W) {
+        if (s + ds < 0 || s + ds >= ctx.W) {
             continue;
         }
-        if (t + dt < 0 || t + dt >= lt_H) {
+        if (t + dt < 0 || t + dt >= ctx.H) {
             continue;
         }
 
-        if (lt_points[s + ds][t + dt].medium < MEDIUM_SOLID) {
+        if (ctx.points[s + ds][t + dt].medium < MEDIUM_SOLID) {
             return true;
         }
     }
@@ -1105,7 +1171,8 @@ static bool Luxel_HasSetNeighbor(int s, int t) {
     return false;
 }
 
-static void Luxel_ComputeAverage(int s, int t, bool do_avg) {
+static void Luxel_ComputeAverage(light_context_t &ctx, int s, int t,
+                                 bool do_avg) {
     int total = 0;
 
     int sum_r = 0;
@@ -1116,36 +1183,36 @@ static void Luxel_ComputeAverage(int s, int t, bool do_avg) {
         int ds = (side == 0) ? -1 : (side == 1) ? +1 : 0;
         int dt = (side == 2) ? -1 : (side == 3) ? +1 : 0;
 
-        if (s + ds < 0 || s + ds >= lt_W) {
+        if (s + ds < 0 || s + ds >= ctx.W) {
             continue;
         }
-        if (t + dt < 0 || t + dt >= lt_H) {
+        if (t + dt < 0 || t + dt >= ctx.H) {
             continue;
         }
 
-        if (lt_points[s + ds][t + dt].medium >= MEDIUM_SOLID) {
+        if (ctx.points[s + ds][t + dt].medium >= MEDIUM_SOLID) {
             continue;
         }
 
-        if (!do_avg && lt_points[s + ds][t + dt].medium == MEDIUM_AVERAGED) {
+        if (!do_avg && ctx.points[s + ds][t + dt].medium == MEDIUM_AVERAGED) {
             continue;
         }
 
-        sum_r += blocklights[s + ds][t + dt][0];
-        sum_g += blocklights[s + ds][t + dt][1];
-        sum_b += blocklights[s + ds][t + dt][2];
+        sum_r += ctx.blocklights[s + ds][t + dt][0];
+        sum_g += ctx.blocklights[s + ds][t + dt][1];
+        sum_b += ctx.blocklights[s + ds][t + dt][2];
 
         total += 1;
     }
 
     if (total > 0) {
-        blocklights[s][t][0] = sum_r / total;
-        blocklights[s][t][1] = sum_g / total;
-        blocklights[s][t][2] = sum_b / total;
+        ctx.blocklights[s][t][0] = sum_r / total;
+        ctx.blocklights[s][t][1] = sum_g / total;
+        ctx.blocklights[s][t][2] = sum_b / total;
     }
 }
 
-static void HandleOffFaceLuxels() {
+static void HandleOffFaceLuxels(light_context_t &ctx) {
     // set luxels in blocklights[] which are off the face or
     // underneath a solid brush to the average of nearby luxels.
     //
@@ -1157,16 +1224,16 @@ static void HandleOffFaceLuxels() {
         where.clear();
 
         // find all unset points with at least one set neighbor
-        for (int s = 0; s < lt_W; s++) {
-            for (int t = 0; t < lt_H; t++) {
-                if (lt_points[s][t].medium >= MEDIUM_SOLID &&
-                    Luxel_HasSetNeighbor(s, t)) {
+        for (int s = 0; s < ctx.W; s++) {
+            for (int t = 0; t < ctx.H; t++) {
+                if (ctx.points[s][t].medium >= MEDIUM_SOLID &&
+                    Luxel_HasSetNeighbor(ctx, s, t)) {
                     where.push_back((t << 10) + s);
 
                     // this logic means that we ignore AVERAGED neighbors
                     // unless none of them has come from a real light.
-                    Luxel_ComputeAverage(s, t, true /* do_avg */);
-                    Luxel_ComputeAverage(s, t, false);
+                    Luxel_ComputeAverage(ctx, s, t, true /* do_avg */);
+                    Luxel_ComputeAverage(ctx, s, t, false);
                 }
             }
         }
@@ -1180,27 +1247,27 @@ static void HandleOffFaceLuxels() {
             int s = where[k] & 1023;
             int t = where[k] >> 10;
 
-            lt_points[s][t].medium = MEDIUM_AVERAGED;
+            ctx.points[s][t].medium = MEDIUM_AVERAGED;
         }
     }
 }
 
-static void FilterSuperSamples() {
+static void FilterSuperSamples(light_context_t &ctx) {
     // the "best" mode visits 4 times as many points as normal,
     // then computes the average of each 2x2 block.
 
-    int W = lt_W / 2;
-    int H = lt_H / 2;
+    int W = ctx.W / 2;
+    int H = ctx.H / 2;
 
     for (int t = 0; t < H; t++) {
         for (int s = 0; s < W; s++) {
             for (int c = 0; c < 3; c++) {
-                int v = blocklights[s * 2 + 0][t * 2 + 0][c] +
-                        blocklights[s * 2 + 0][t * 2 + 1][c] +
-                        blocklights[s * 2 + 1][t * 2 + 0][c] +
-                        blocklights[s * 2 + 1][t * 2 + 1][c];
+                int v = ctx.blocklights[s * 2 + 0][t * 2 + 0][c] +
+                        ctx.blocklights[s * 2 + 0][t * 2 + 1][c] +
+                        ctx.blocklights[s * 2 + 1][t * 2 + 0][c] +
+                        ctx.blocklights[s * 2 + 1][t * 2 + 1][c];
 
-                blocklights[s][t][c] = v >> 2;
+                ctx.blocklights[s][t][c] = v >> 2;
             }
         }
     }
@@ -1210,7 +1277,152 @@ static void FilterSuperSamples() {
 
 std::vector<quake_light_t> qk_all_lights;
 
-static void QLIT_FreeLights() { qk_all_lights.clear(); }
+//
+// Normal lights are binned into a uniform grid of cubic cells, each
+// light going into every cell its radius reaches, so that a face only
+// needs to look at the cells covered by its bounding box.  Sun lights
+// reach everywhere and are kept in a list of their own.
+//
+
+#define LIGHT_CELL_SIZE 256.0
+#define LIGHT_GRID_MAX 64  // cells per axis
+
+static float light_grid_origin[3];
+static float light_cell_size;
+static int light_grid_size[3];
+
+// lights in cell N are light_cell_lights[light_cell_start[N] ..
+// light_cell_start[N+1]-1], as indices into qk_all_lights
+static std::vector<unsigned int> light_cell_start;
+static std::vector<unsigned int> light_cell_lights;
+
+static std::vector<unsigned int> light_suns;
+
+static void QLIT_FreeLights() {
+    qk_all_lights.clear();
+
+    light_cell_start.clear();
+    light_cell_lights.clear();
+    light_suns.clear();
+}
+
+static void LightGrid_CellRange(int b, float lo, float hi, int *c1, int *c2) {
+    *c1 = (int)floor((lo - light_grid_origin[b]) / light_cell_size);
+    *c2 = (int)floor((hi - light_grid_origin[b]) / light_cell_size);
+
+    *c1 = CLAMP(0, *c1, light_grid_size[b] - 1);
+    *c2 = CLAMP(0, *c2, light_grid_size[b] - 1);
+}
+
+static inline int LightGrid_Cell(int cx, int cy, int cz) {
+    return (cz * light_grid_size[1] + cy) * light_grid_size[0] + cx;
+}
+
+template <typename FUNC>
+static void LightGrid_VisitCells(float *mins, float *maxs, FUNC func) {
+    int c1[3], c2[3];
+
+    for (int b = 0; b < 3; b++) {
+        LightGrid_CellRange(b, mins[b], maxs[b], &c1[b], &c2[b]);
+    }
+
+    for (int cz = c1[2]; cz <= c2[2]; cz++) {
+        for (int cy = c1[1]; cy <= c2[1]; cy++) {
+            for (int cx = c1[0]; cx <= c2[0]; cx++) {
+                func(LightGrid_Cell(cx, cy, cz));
+            }
+        }
+    }
+}
+
+static void QLIT_BuildLightGrid() {
+    float mins[3] = {+9e9, +9e9, +9e9};
+    float maxs[3] = {-9e9, -9e9, -9e9};
+
+    for (unsigned int i = 0; i < qk_all_lights.size(); i++) {
+        const quake_light_t &light = qk_all_lights[i];
+
+        if (light.kind == LTK_Sun) {
+            light_suns.push_back(i);
+            continue;
+        }
+
+        const float pos[3] = {light.x, light.y, light.z};
+
+        for (int b = 0; b < 3; b++) {
+            mins[b] = MIN(mins[b], pos[b] - light.radius);
+            maxs[b] = MAX(maxs[b], pos[b] + light.radius);
+        }
+    }
+
+    if (light_suns.size() == qk_all_lights.size()) {
+        return;
+    }
+
+    // use bigger cells for huge maps
+    light_cell_size = LIGHT_CELL_SIZE;
+
+    for (int b = 0; b < 3; b++) {
+        light_cell_size =
+            MAX(light_cell_size, (maxs[b] - mins[b]) / LIGHT_GRID_MAX);
+    }
+
+    int total = 1;
+
+    for (int b = 0; b < 3; b++) {
+        light_grid_origin[b] = mins[b];
+        light_grid_size[b] =
+            (int)ceil((maxs[b] - mins[b]) / light_cell_size) + 1;
+        light_grid_size[b] = MIN(light_grid_size[b], LIGHT_GRID_MAX + 1);
+
+        total *= light_grid_size[b];
+    }
+
+    // count the lights in each cell, then fill them in
+
+    light_cell_start.assign(total + 1, 0);
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (unsigned int i = 0; i < qk_all_lights.size(); i++) {
+            const quake_light_t &light = qk_all_lights[i];
+
+            if (light.kind == LTK_Sun) {
+                continue;
+            }
+
+            float l_mins[3] = {light.x - light.radius, light.y - light.radius,
+                               light.z - light.radius};
+            float l_maxs[3] = {light.x + light.radius, light.y + light.radius,
+                               light.z + light.radius};
+
+            LightGrid_VisitCells(l_mins, l_maxs, [&](int cell) {
+                if (pass == 0) {
+                    light_cell_start[cell + 1] += 1;
+                } else {
+                    light_cell_lights[light_cell_start[cell]++] = i;
+                }
+            });
+        }
+
+        if (pass == 0) {
+            for (int c = 0; c < total; c++) {
+                light_cell_start[c + 1] += light_cell_start[c];
+            }
+
+            light_cell_lights.resize(light_cell_start[total]);
+        } else {
+            // the fill moved each start along to the next cell's start
+            for (int c = total; c > 0; c--) {
+                light_cell_start[c] = light_cell_start[c - 1];
+            }
+
+            light_cell_start[0] = 0;
+        }
+    }
+
+    LogPrintf("light grid: {} x {} x {} cells\n", light_grid_size[0],
+              light_grid_size[1], light_grid_size[2]);
+}
 
 static void QLIT_FindLights() {
     QLIT_FreeLights();
@@ -1244,115 +1456,175 @@ static void QLIT_FindLights() {
 
         qk_all_lights.push_back(light);
     }
+
+    QLIT_BuildLightGrid();
 }
 
-static inline void Bump(int s, int t, int value, rgb_color_t color) {
-    blocklights[s][t][0] += value * RGB_RED(color);
-    blocklights[s][t][1] += value * RGB_GREEN(color);
-    blocklights[s][t][2] += value * RGB_BLUE(color);
+static inline void Bump(light_context_t &ctx, int s, int t, int value,
+                        rgb_color_t color) {
+    ctx.blocklights[s][t][0] += value * RGB_RED(color);
+    ctx.blocklights[s][t][1] += value * RGB_GREEN(color);
+    ctx.blocklights[s][t][2] += value * RGB_BLUE(color);
 }
 
-static void QLIT_ProcessLight(qLightmap_c *lmap, quake_light_t &light,
-                              int pass) {
-    // first pass is normal lights, other passes are for styled lights
-    if (pass == 0) {
-        if (light.style) {
-            return;
-        }
-    } else {
-        if (light.style == 0) {
-            return;
+// traces a whole row of luxels to the light, TRACE_PACKET_SIZE at a
+// time.  Returns true if any luxel could see the light.
+static bool QLIT_ProcessLightRow(light_context_t &ctx,
+                                 const quake_light_t &light, int t) {
+    bool hit_it = false;
+
+    float xs[TRACE_PACKET_SIZE] = {};
+    float ys[TRACE_PACKET_SIZE] = {};
+    float zs[TRACE_PACKET_SIZE] = {};
+
+    for (int s0 = 0; s0 < ctx.W; s0 += TRACE_PACKET_SIZE) {
+        int count = MIN(TRACE_PACKET_SIZE, ctx.W - s0);
+
+        unsigned int mask = 0;
+
+        for (int i = 0; i < count; i++) {
+            const light_point_t &P = ctx.points[s0 + i][t];
+
+            xs[i] = P.x;
+            ys[i] = P.y;
+            zs[i] = P.z;
+
+            // ignore liquids, off-face points and points blocked by solids
+            if (P.medium <= MEDIUM_AIR) {
+                mask |= (1u << i);
+            }
         }
 
-        // skip light if we processed that style in an earlier pass
-        if (lt_current_style < 0 && lmap->hasStyle(light.style)) {
-            return;
+        if (mask == 0) {
+            continue;
         }
 
-        // skip light unless it matches the current style
-        if (lt_current_style > 0 && light.style != lt_current_style) {
-            return;
+        mask = QVIS_TraceRayPacket(mask, xs, ys, zs, light.x, light.y,
+                                   light.z);
+
+        for (int i = 0; i < count; i++) {
+            if (!(mask & (1u << i))) {
+                continue;
+            }
+
+            int s = s0 + i;
+
+            hit_it = true;
+
+            if (light.kind == LTK_Sun) {
+                Bump(ctx, s, t, (int)light.level, light.color);
+            } else {
+                float dist = ComputeDist(xs[i], ys[i], zs[i], light.x,
+                                         light.y, light.z);
+
+                if (dist < light.radius) {
+                    int value = light.level * (1.0 - dist / light.radius);
+
+                    Bump(ctx, s, t, value, light.color);
+                }
+            }
         }
     }
 
+    return hit_it;
+}
+
+// true if the light is in front of the face and close enough to it
+static bool QLIT_LightReachesFace(const light_context_t &ctx,
+                                  const quake_light_t &light) {
     // skip lights which are behind the face
-    float perp = lt_plane_normal[0] * light.x + lt_plane_normal[1] * light.y +
-                 lt_plane_normal[2] * light.z - lt_plane_dist;
+    float perp = ctx.plane_normal[0] * light.x + ctx.plane_normal[1] * light.y +
+                 ctx.plane_normal[2] * light.z - ctx.plane_dist;
 
     if (perp <= 0) {
-        return;
+        return false;
     }
 
     // skip lights which are too far away
     if (light.kind == LTK_Sun) {
         if (qk_game < 3) {
-            SYS_ASSERT(lt_face->leaf);
+            SYS_ASSERT(ctx.face->leaf);
 
-            if (lt_face->leaf->cluster &&
-                lt_face->leaf->cluster->ambient_dists[AMBIENT_SKY] > 4) {
-                return;
+            if (ctx.face->leaf->cluster &&
+                ctx.face->leaf->cluster->ambient_dists[AMBIENT_SKY] > 4) {
+                return false;
             }
         }
     } else {
         if (perp > light.radius) {
-            return;
+            return false;
         }
 
-        if (!lt_face_bbox.Touches(light.x, light.y, light.z, light.radius)) {
-            return;
+        if (!ctx.face_bbox.Touches(light.x, light.y, light.z, light.radius)) {
+            return false;
         }
     }
 
-    bool hit_it = false;
+    return true;
+}
 
-    for (int t = 0; t < lt_H; t++) {
-        for (int s = 0; s < lt_W; s++) {
-            const light_point_t &P = lt_points[s][t];
+static bool LightStyleLess(const quake_light_t *A, const quake_light_t *B) {
+    // normal lights (style 0) go first
+    if ((A->style != 0) != (B->style != 0)) {
+        return A->style == 0;
+    }
 
-            // ignore liquids, off-face points and points blocked by solids
-            if (P.medium > MEDIUM_AIR) {
-                continue;
-            }
+    return A->style < B->style;
+}
 
-            if (!QVIS_TraceRay(P.x, P.y, P.z, light.x, light.y, light.z)) {
-                continue;
-            }
+// builds the list of lights which may reach the current face, using
+// the light grid.  Within each style the lights keep their original
+// order.
+static void QLIT_GatherLights(light_context_t &ctx) {
+    ctx.lights.clear();
+    ctx.light_nums = light_suns;
+
+    if (!light_cell_start.empty()) {
+        LightGrid_VisitCells(
+            ctx.face_bbox.mins, ctx.face_bbox.maxs, [&](int cell) {
+                for (unsigned int k = light_cell_start[cell];
+                     k < light_cell_start[cell + 1]; k++) {
+                    ctx.light_nums.push_back(light_cell_lights[k]);
+                }
+            });
 
-            hit_it = true;
+        // lights can be in several cells
+        std::sort(ctx.light_nums.begin(), ctx.light_nums.end());
 
-            if (light.kind == LTK_Sun) {
-                Bump(s, t, (int)light.level, light.color);
-            } else {
-                float dist =
-                    ComputeDist(P.x, P.y, P.z, light.x, light.y, light.z);
+        ctx.light_nums.erase(
+            std::unique(ctx.light_nums.begin(), ctx.light_nums.end()),
+            ctx.light_nums.end());
+    }
 
-                if (dist < light.radius) {
-                    int value = light.level * (1.0 - dist / light.radius);
+    for (unsigned int k = 0; k < ctx.light_nums.size(); k++) {
+        const quake_light_t &light = qk_all_lights[ctx.light_nums[k]];
 
-                    Bump(s, t, value, light.color);
-                }
-            }
+        if (QLIT_LightReachesFace(ctx, light)) {
+            ctx.lights.push_back(&light);
         }
     }
 
-    // don't create a new style in the lightmap if the light never
-    // touched the face (e.g. when on the other side of a wall).
-
-    if (!hit_it) {
-        return;
-    }
+    std::stable_sort(ctx.lights.begin(), ctx.lights.end(), LightStyleLess);
+}
 
-    if (lt_current_style < 0) {
-        lt_current_style = light.style;
+// returns true if the light touched any luxel
+static bool QLIT_ProcessLight(light_context_t &ctx,
+                              const quake_light_t &light) {
+    bool hit_it = false;
 
-        lmap->AddStyle(light.style);
+    for (int t = 0; t < ctx.H; t++) {
+        if (QLIT_ProcessLightRow(ctx, light, t)) {
+            hit_it = true;
+        }
     }
+
+    return hit_it;
 }
 
-static void QLIT_LiquidLighting(qLightmap_c *lmap) {
-    for (int t = 0; t < lt_H; t++) {
-        for (int s = 0; s < lt_W; s++) {
-            const light_point_t &P = lt_points[s][t];
+static void QLIT_LiquidLighting(light_context_t &ctx, qLightmap_c *lmap) {
+    for (int t = 0; t < ctx.H; t++) {
+        for (int s = 0; s < ctx.W; s++) {
+            const light_point_t &P = ctx.points[s][t];
 
             if (P.medium >= MEDIUM_WATER && P.medium <= MEDIUM_LAVA) {
                 liquid_coloring_t &LC = (P.medium == MEDIUM_SLIME)  ? q_slime
@@ -1366,20 +1638,20 @@ static void QLIT_LiquidLighting(qLightmap_c *lmap) {
                     (fx + fy) * LC.intensity - P.liquid_depth * LC.dropoff;
 
                 if (level > 0) {
-                    Bump(s, t, level, LC.color);
+                    Bump(ctx, s, t, level, LC.color);
                 }
             }
         }
     }
 }
 
-void QLIT_TestingStuff(qLightmap_c *lmap) {
+void QLIT_TestingStuff(const light_context_t &ctx, qLightmap_c *lmap) {
     int W = lmap->width;
     int H = lmap->height;
 
     for (int t = 0; t < H; t++) {
         for (int s = 0; s < W; s++) {
-            const light_point_t &P = lt_points[s][t];
+            const light_point_t &P = ctx.points[s][t];
 
             int r = 40 + 10 * sin(P.x / 40.0);
             int g = 80 + 40 * sin(P.y / 40.0);
@@ -1397,41 +1669,67 @@ void QLIT_TestingStuff(qLightmap_c *lmap) {
     }
 }
 
-void QLIT_LightFace(quake_face_c *F) {
-    lt_face = F;
+static void QLIT_LightFace(light_context_t &ctx, quake_face_c *F) {
+    ctx.face = F;
 
-    F->GetBounds(&lt_face_bbox);
+    F->GetBounds(&ctx.face_bbox);
 
     if (qk_game < 3) {
-        Q1_CalcFaceStuff(F);
+        Q1_CalcFaceStuff(ctx, F);
     } else {
-        Q3_CalcFaceStuff(F);
+        Q3_CalcFaceStuff(ctx, F);
     }
 
 #if 0  // DEBUG
-	QLIT_TestingStuff(F->lmap);
+	QLIT_TestingStuff(ctx, F->lmap);
 	return;
 #endif
 
-    for (int pass = 0; pass < 4; pass++) {
-        lt_current_style = (pass == 0) ? 0 : -1;
+    QLIT_GatherLights(ctx);
 
-        ClearLightBuffer(pass ? 0 : q_low_light);
+    unsigned int k = 0;
+    unsigned int total = ctx.lights.size();
 
-        for (unsigned int i = 0; i < qk_all_lights.size(); i++) {
-            QLIT_ProcessLight(F->lmap, qk_all_lights[i], pass);
-        }
+    // first pass is normal lights
 
-        if (pass == 0) {
-            QLIT_LiquidLighting(F->lmap);
+    ClearLightBuffer(ctx, q_low_light);
+
+    for (; k < total && ctx.lights[k]->style == 0; k++) {
+        QLIT_ProcessLight(ctx, *ctx.lights[k]);
+    }
 
-            HandleOffFaceLuxels();
+    QLIT_LiquidLighting(ctx, F->lmap);
 
-            if (q_light_quality > 0) {
-                FilterSuperSamples();
+    HandleOffFaceLuxels(ctx);
+
+    if (q_light_quality > 0) {
+        FilterSuperSamples(ctx);
+    }
+
+    F->lmap->Store(ctx);
+
+    // other passes are for styled lights, one style per pass.  A style
+    // only gets a pass if one of its lights actually touched the face
+    // (e.g. it is not on the other side of a wall).
+
+    for (int pass = 1; pass < 4 && k < total; pass++) {
+        ClearLightBuffer(ctx, 0);
+
+        while (k < total) {
+            int style = ctx.lights[k]->style;
+
+            bool hit_it = false;
+
+            for (; k < total && ctx.lights[k]->style == style; k++) {
+                if (QLIT_ProcessLight(ctx, *ctx.lights[k])) {
+                    hit_it = true;
+                }
             }
 
-            F->lmap->Store();
+            if (hit_it) {
+                F->lmap->AddStyle(style);
+                break;
+            }
         }
     }
 }
@@ -1564,7 +1862,8 @@ static void Q3_VisitGridPoint(float gx, float gy, float gz,
     memset(out, 0, sizeof(dlightgrid3_t));
 
     // the point may lie inside a solid area, so look for a nearby
-    // spot that is open...
+    // spot that is open.  If there is none, the point stays black and
+    // no lights are processed for it.
 
     for (int i = 0; i <= 6 * 9; i++) {
         // everything failed?
@@ -1696,22 +1995,47 @@ static void Q3_GridLighting() {
     LogPrintf("grid counts: {} x {} x {}\n", g_count[0], g_count[1],
               g_count[2]);
 
-    qLump_c *lump = BSP_NewLump(LUMP_Q3_LIGHTGRID);
+    // every grid point is independent, so rows of points are lit in
+    // parallel straight into their place in the lump.
 
-    dlightgrid3_t raw_point;
+    int total = g_count[0] * g_count[1] * g_count[2];
 
-    for (int znum = 0; znum < g_count[2]; znum++) {
-        for (int ynum = 0; ynum < g_count[1]; ynum++) {
-            for (int xnum = 0; xnum < g_count[0]; xnum++) {
-                float gx = g_mins[0] + xnum * 64.0;
-                float gy = g_mins[1] + ynum * 64.0;
-                float gz = g_mins[2] + znum * 128.0;
+    std::vector<dlightgrid3_t> grid(total);
 
-                Q3_VisitGridPoint(gx, gy, gz, &raw_point);
+    QCOM_ParallelFor(g_count[1] * g_count[2], 64, [&](int thread, int row) {
+        int ynum = row % g_count[1];
+        int znum = row / g_count[1];
 
-                lump->Append(&raw_point, sizeof(raw_point));
-            }
+        for (int xnum = 0; xnum < g_count[0]; xnum++) {
+            float gx = g_mins[0] + xnum * 64.0;
+            float gy = g_mins[1] + ynum * 64.0;
+            float gz = g_mins[2] + znum * 128.0;
+
+            Q3_VisitGridPoint(gx, gy, gz, &grid[row * g_count[0] + xnum]);
         }
+    });
+
+    qLump_c *lump = BSP_NewLump(LUMP_Q3_LIGHTGRID);
+
+    lump->Append(grid.data(), total * sizeof(dlightgrid3_t));
+}
+
+static void Q3_PlaceLightmaps() {
+    // tallest first, which packs a lot tighter than face order.
+    // The sort is stable, so ties stay in face order.
+
+    std::vector<qLightmap_c *> order(qk_all_lightmaps);
+
+    std::stable_sort(order.begin(), order.end(),
+                     [](const qLightmap_c *A, const qLightmap_c *B) {
+                         if (A->height != B->height) {
+                             return A->height > B->height;
+                         }
+                         return A->width > B->width;
+                     });
+
+    for (qLightmap_c *L : order) {
+        L->PlaceInBlock();
     }
 }
 
@@ -1734,11 +2058,10 @@ void QLIT_LightAllFaces() {
 
     QVIS_MakeTraceNodes();
 
-    int lit_faces = 0;
-    int lit_luxels = 0;
-
     // visit all faces, including Q3 detail and map-model faces
 
+    std::vector<quake_face_c *> faces;
+
     for (unsigned int i = 0; i < qk_all_faces.size(); i++) {
         quake_face_c *F = qk_all_faces[i];
 
@@ -1746,25 +2069,49 @@ void QLIT_LightAllFaces() {
             continue;
         }
 
-        QLIT_LightFace(F);
+        faces.push_back(F);
+    }
 
-        lit_faces++;
-        lit_luxels += F->lmap->width * F->lmap->height;
+    int num_threads = QCOM_NumThreads(faces.size());
 
-        if (lit_faces % 400 == 0) {
-            Main::Ticker();
+    // one lighting context per thread
+    std::vector<std::unique_ptr<light_context_t>> contexts;
 
-            if (main_action >= MAIN_CANCEL) {
-                break;
-            }
+    for (int t = 0; t < num_threads; t++) {
+        contexts.emplace_back(new light_context_t);
+    }
+
+    QCOM_ParallelFor(faces.size(), 400, [&](int thread, int i) {
+        QLIT_LightFace(*contexts[thread], faces[i]);
+    });
+
+    // collect the lightmaps in face order, so the output does not
+    // depend on which thread lit which face.  Faces are missing a
+    // lightmap after a cancel.
+
+    int lit_faces = 0;
+    int lit_luxels = 0;
 
-            // fprintf(stderr, "lit %d faces (of %u)\n", lit_faces,
-            // qk_all_faces.size());
+    for (unsigned int i = 0; i < faces.size(); i++) {
+        quake_face_c *F = faces[i];
+
+        if (!F->lmap) {
+            continue;
         }
+
+        qk_all_lightmaps.push_back(F->lmap);
+
+        lit_faces++;
+        lit_luxels += F->lmap->width * F->lmap->height;
+    }
+
+    // for Q3, place them in the light blocks
+    if (qk_game >= 3) {
+        Q3_PlaceLightmaps();
     }
 
-    LogPrintf("lit {} faces (of {}) using {} luxels\n", lit_faces,
-              qk_all_faces.size(), lit_luxels);
+    LogPrintf("lit {} faces (of {}) using {} luxels with {} threads\n",
+              lit_faces, qk_all_faces.size(), lit_luxels, num_threads);
 
     // for Q3, determine grid lighting
     if (qk_game >= 3) {
@@ -30,6 +30,7 @@
 
 class quake_face_c;
 class uv_matrix_c;
+struct light_context_t;
 
 // the maximum size of a face's lightmap in Quake I/II
 constexpr int FLAT_LIGHTMAP_SIZE = 17 * 17;
@@ -74,8 +75,12 @@ class qLightmap_c {
     // true if all samples are zero
     bool isDark() const;
 
-    // transfer from blocklights[] array
-    void Store();
+    // transfer from the blocklights[] array of a lighting context
+    void Store(const light_context_t &ctx);
+
+    // Q3 only: allocate a place in a light block and copy the samples
+    // there.  Must be called from a single thread, in a fixed order.
+    void PlaceInBlock();
 
     void Write(qLump_c *lump);
 };
@@ -111,6 +116,9 @@ extern std::vector<quake_light_t> qk_all_lights;
 
 extern bool q_mono_lighting;
 
+// size of the Q3 lightmap pages (they are square)
+extern int q3_lightmap_size;
+
 /***** FUNCTIONS **********/
 
 rgb_color_t QLIT_ParseColorString(std::string name);
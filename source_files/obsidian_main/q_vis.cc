@@ -325,6 +325,216 @@ bool QVIS_TraceRay(float x1, float y1, float z1, float x2, float y2, float z2) {
     return true;
 }
 
+//
+// Packet tracing: up to TRACE_PACKET_SIZE rays are walked down the
+// tree together, which shares the node fetches and lets the compiler
+// vectorize the plane tests.  The per-ray math matches RecursiveTestRay
+// exactly, so results are identical to tracing the rays one by one.
+//
+// Rays are stored as (x1 y1 z1) -> (x2 y2 z2) segments in SoA layout.
+// The bits in 'mask' are the rays which are still active; a ray drops
+// out as soon as it hits something.
+//
+
+typedef struct {
+    float x1[TRACE_PACKET_SIZE], y1[TRACE_PACKET_SIZE], z1[TRACE_PACKET_SIZE];
+    float x2[TRACE_PACKET_SIZE], y2[TRACE_PACKET_SIZE], z2[TRACE_PACKET_SIZE];
+} trace_packet_t;
+
+// returns the rays in 'mask' which have not hit anything yet.
+// rays which do hit something get the TRACE_XXX value in results[].
+static unsigned int RecursiveTestPacket(int nodenum, unsigned int mask,
+                                        const trace_packet_t &seg,
+                                        int *results) {
+    for (;;) {
+        if (mask == 0) {
+            return 0;
+        }
+
+        if (nodenum < 0) {
+            if (nodenum == TRACE_EMPTY) {
+                return mask;
+            }
+
+            for (int i = 0; i < TRACE_PACKET_SIZE; i++) {
+                if (mask & (1u << i)) {
+                    results[i] = nodenum;
+                }
+            }
+
+            return 0;
+        }
+
+        const tnode_t *TN = &trace_nodes[nodenum];
+
+        float dist1[TRACE_PACKET_SIZE];
+        float dist2[TRACE_PACKET_SIZE];
+
+        switch (TN->type) {
+            case PLANE_X:
+                for (int i = 0; i < TRACE_PACKET_SIZE; i++) {
+                    dist1[i] = seg.x1[i] - TN->dist;
+                    dist2[i] = seg.x2[i] - TN->dist;
+                }
+                break;
+
+            case PLANE_Y:
+                for (int i = 0; i < TRACE_PACKET_SIZE; i++) {
+                    dist1[i] = seg.y1[i] - TN->dist;
+                    dist2[i] = seg.y2[i] - TN->dist;
+                }
+                break;
+
+            case PLANE_Z:
+                for (int i = 0; i < TRACE_PACKET_SIZE; i++) {
+                    dist1[i] = seg.z1[i] - TN->dist;
+                    dist2[i] = seg.z2[i] - TN->dist;
+                }
+                break;
+
+            default:
+                for (int i = 0; i < TRACE_PACKET_SIZE; i++) {
+                    dist1[i] = seg.x1[i] * TN->normal[0] +
+                               seg.y1[i] * TN->normal[1] +
+                               seg.z1[i] * TN->normal[2];
+                    dist2[i] = seg.x2[i] * TN->normal[0] +
+                               seg.y2[i] * TN->normal[1] +
+                               seg.z2[i] * TN->normal[2];
+
+                    dist1[i] -= TN->dist;
+                    dist2[i] -= TN->dist;
+                }
+                break;
+        }
+
+        unsigned int front = 0;
+        unsigned int back = 0;
+
+        for (int i = 0; i < TRACE_PACKET_SIZE; i++) {
+            if (dist1[i] >= -T_EPSILON && dist2[i] >= -T_EPSILON) {
+                front |= (1u << i);
+            } else if (dist1[i] < T_EPSILON && dist2[i] < T_EPSILON) {
+                back |= (1u << i);
+            }
+        }
+
+        front &= mask;
+        back &= mask;
+
+        unsigned int cross = mask & ~(front | back);
+
+        // the common case: every ray goes the same way
+        if (cross == 0 && back == 0) {
+            nodenum = TN->children[0];
+            continue;
+        }
+        if (cross == 0 && front == 0) {
+            nodenum = TN->children[1];
+            continue;
+        }
+
+        // split the crossing rays at the node plane.  'to_front' holds
+        // the part of each ray on the front side, 'to_back' the part on
+        // the back side (rays which don't cross are unchanged).
+
+        trace_packet_t to_front = seg;
+        trace_packet_t to_back = seg;
+
+        unsigned int cross_back = 0;  // rays starting on the back side
+
+        for (int i = 0; i < TRACE_PACKET_SIZE; i++) {
+            if (!(cross & (1u << i))) {
+                continue;
+            }
+
+            int side = (dist1[i] < 0) ? 1 : 0;
+
+            double frac = dist1[i] / (double)(dist1[i] - dist2[i]);
+
+            float mx = seg.x1[i] + (seg.x2[i] - seg.x1[i]) * frac;
+            float my = seg.y1[i] + (seg.y2[i] - seg.y1[i]) * frac;
+            float mz = seg.z1[i] + (seg.z2[i] - seg.z1[i]) * frac;
+
+            trace_packet_t &near_P = side ? to_back : to_front;
+            trace_packet_t &far_P = side ? to_front : to_back;
+
+            near_P.x2[i] = mx;
+            near_P.y2[i] = my;
+            near_P.z2[i] = mz;
+
+            far_P.x1[i] = mx;
+            far_P.y1[i] = my;
+            far_P.z1[i] = mz;
+
+            if (side) {
+                cross_back |= (1u << i);
+            }
+        }
+
+        unsigned int cross_front = cross & ~cross_back;
+
+        // each ray must visit its near half before its far half, since
+        // the first thing it hits decides the result (see TRACE_SKY
+        // comment in RecursiveTestRay).
+
+        unsigned int alive = mask;
+        unsigned int sub;
+
+        sub = front | cross_front;
+        alive = (alive & ~sub) | RecursiveTestPacket(TN->children[0], sub,
+                                                     to_front, results);
+
+        sub = back | cross_back | (cross_front & alive);
+        alive = (alive & ~sub) | RecursiveTestPacket(TN->children[1], sub,
+                                                     to_back, results);
+
+        sub = cross_back & alive;
+        alive = (alive & ~sub) | RecursiveTestPacket(TN->children[0], sub,
+                                                     to_front, results);
+
+        return alive;
+    }
+}
+
+unsigned int QVIS_TraceRayPacket(unsigned int mask, const float *x1,
+                                 const float *y1, const float *z1, float x2,
+                                 float y2, float z2) {
+    trace_packet_t seg;
+
+    int results[TRACE_PACKET_SIZE];
+
+    for (int i = 0; i < TRACE_PACKET_SIZE; i++) {
+        seg.x1[i] = x1[i];
+        seg.y1[i] = y1[i];
+        seg.z1[i] = z1[i];
+
+        seg.x2[i] = x2;
+        seg.y2[i] = y2;
+        seg.z2[i] = z2;
+
+        results[i] = TRACE_EMPTY;
+    }
+
+    RecursiveTestPacket(0, mask, seg, results);
+
+    // check for detail faces *after* the main trace, but only for the
+    // rays which survived it.
+
+    for (int i = 0; i < TRACE_PACKET_SIZE; i++) {
+        if (!(mask & (1u << i))) {
+            continue;
+        }
+
+        if (results[i] == TRACE_SOLID ||
+            RecursiveTestDetail(qk_bsp_root, NULL, x1[i], y1[i], z1[i], x2,
+                                y2, z2) == TRACE_SOLID) {
+            mask &= ~(1u << i);
+        }
+    }
+
+    return mask;
+}
+
 static int RecursiveTestPoint(int nodenum, float x, float y, float z) {
     for (;;) {
         if (nodenum < 0) {
@@ -562,9 +772,6 @@ static void FloodAmbientSounds() {
 
 static qLump_c *q_visibility;
 
-static byte *v_row_buffer;
-static byte *v_compress_buffer;
-
 static int v_row_bits;  // number of leafs or clusters
 static int v_bytes_per_row;
 
@@ -617,22 +824,29 @@ struct vis_statistics_t {
 static vis_statistics_t pvs_stats;
 static vis_statistics_t phs_stats;
 
-static int WriteCompressedRow(bool PHS) {
-    // returns offset for the written data block
-    int visofs = (int)q_visibility->GetSize();
+// the rows for a single cluster, as they will be written to the lump
+// (compressed except for Quake III).
+struct vis_rows_t {
+    std::vector<byte> pvs;
+    std::vector<byte> phs;
+
+    // percentage of visible (or hearable) leafs/clusters
+    float pvs_perc;
+    float phs_perc;
+};
 
-    const byte *src = v_row_buffer;
+static void CompressRow(const byte *src, std::vector<byte> &dest) {
     const byte *s_end = src + v_bytes_per_row;
 
-    byte *dest = v_compress_buffer;
+    dest.clear();
 
     while (src < s_end) {
         if (*src) {
-            *dest++ = *src++;
+            dest.push_back(*src++);
             continue;
         }
 
-        *dest++ = *src++;
+        dest.push_back(*src++);
 
         byte repeat = 1;
 
@@ -641,39 +855,35 @@ static int WriteCompressedRow(bool PHS) {
             repeat++;
         }
 
-        *dest++ = repeat;
+        dest.push_back(repeat);
     }
+}
 
-    int length = (dest - v_compress_buffer);
+static int WriteRow(const std::vector<byte> &row, vis_statistics_t &stats) {
+    // returns offset for the written data block
+    int visofs = (int)q_visibility->GetSize();
 
-    q_visibility->Append(v_compress_buffer, length);
+    q_visibility->Append(row.data(), row.size());
 
-    if (PHS) {
-        phs_stats.uncompressed += v_bytes_per_row;
-        phs_stats.compressed += length;
-    } else {
-        pvs_stats.uncompressed += v_bytes_per_row;
-        pvs_stats.compressed += length;
+    if (qk_game < 3) {
+        stats.uncompressed += v_bytes_per_row;
+        stats.compressed += (int)row.size();
     }
 
     return visofs;
 }
 
-static void WriteUncompressedRow() {
-    int length = v_bytes_per_row;
-
-    q_visibility->Append(v_row_buffer, length);
-}
-
-static void CollectRowData(int src_x, int src_y, bool PHS) {
+// returns the percentage of the row which is visible
+static float CollectRowData(const Vis_Buffer *vis, byte *row, int src_x,
+                            int src_y) {
     // initial state : everything visible
-    memset(v_row_buffer, 0xFF, v_bytes_per_row);
+    memset(row, 0xFF, v_bytes_per_row);
 
     unsigned int blocked = 0;  // statistics
 
     for (int cy = 0; cy < cluster_H; cy++) {
         for (int cx = 0; cx < cluster_W; cx++) {
-            if ((cx == src_x && cy == src_y) || qk_visbuf->CanSee(cx, cy)) {
+            if ((cx == src_x && cy == src_y) || vis->CanSee(cx, cy)) {
                 continue;
             }
 
@@ -686,7 +896,7 @@ static void CollectRowData(int src_x, int src_y, bool PHS) {
                 SYS_ASSERT(index >= 0);
                 SYS_ASSERT((index >> 3) < v_bytes_per_row);
 
-                v_row_buffer[index >> 3] &= ~(1 << (index & 7));
+                row[index >> 3] &= ~(1 << (index & 7));
 
                 blocked++;
             } else  // original Quake, data is indexed by leaf number
@@ -705,7 +915,7 @@ static void CollectRowData(int src_x, int src_y, bool PHS) {
                     SYS_ASSERT(index >= 0);
                     SYS_ASSERT((index >> 3) < v_bytes_per_row);
 
-                    v_row_buffer[index >> 3] &= ~(1 << (index & 7));
+                    row[index >> 3] &= ~(1 << (index & 7));
                 }
             }
         }
@@ -716,74 +926,107 @@ static void CollectRowData(int src_x, int src_y, bool PHS) {
 			src_x, src_y, blocked, blocked * 100.0 / v_row_bits);
 #endif
 
-    // update statistics
-    float perc = (v_row_bits - blocked) * 100.0 / (float)MAX(1, v_row_bits);
+#ifdef DEBUG_INVERT_MAP
+    for (int n = 0; n < v_bytes_per_row; n++) row[n] ^= 0xFF;
+#endif
 
-    if (PHS) {
-        phs_stats.AddValue(perc);
+    return (v_row_bits - blocked) * 100.0 / (float)MAX(1, v_row_bits);
+}
+
+static void Build_ClusterRows(Vis_Buffer *vis, byte *row, int cx, int cy,
+                              vis_rows_t &out) {
+    vis->ClearVis();
+    vis->ProcessVis(cx, cy);
+
+    out.pvs_perc = CollectRowData(vis, row, cx, cy);
+
+    if (qk_game == 3) {
+        out.pvs.assign(row, row + v_bytes_per_row);
     } else {
-        pvs_stats.AddValue(perc);
+        CompressRow(row, out.pvs);
     }
 
-#ifdef DEBUG_INVERT_MAP
-    for (int n = 0; n < v_bytes_per_row; n++) v_row_buffer[n] ^= 0xFF;
-#endif
+    if (qk_game == 2) {
+        // Quake II's Potentially Hearable Set
+        //
+        // 1. start off with the PVS set
+        // 2. flood fill for a few passes
+        // 3. truncate it based on distance
+
+        vis->FloodFill(4);
+        vis->Truncate(8);
+
+        out.phs_perc = CollectRowData(vis, row, cx, cy);
+
+        CompressRow(row, out.phs);
+    }
 }
 
 static void Build_PVS() {
     qk_visbuf->SimplifySolid();
 
-    int done = 0;
+    // each cluster's vis is independent of the others, so they are done
+    // in parallel.  Every thread needs its own buffer (the vis results
+    // are kept in it), thread 0 uses the original.
 
-    for (int cy = 0; cy < cluster_H; cy++) {
-        for (int cx = 0; cx < cluster_W; cx++) {
-            qCluster_c *cluster = qk_clusters[cy * cluster_W + cx];
+    int num_clusters = cluster_W * cluster_H;
+    int num_threads = QCOM_NumThreads(num_clusters);
 
-            if (cluster->leafs.empty()) {
-                if (qk_game == 3) {
-                    memset(v_row_buffer, 0, v_bytes_per_row);
-                    WriteUncompressedRow();
-                }
+    std::vector<Vis_Buffer *> buffers;
+    std::vector<std::vector<byte>> row_buffers(num_threads);
 
-                continue;
-            }
+    for (int t = 0; t < num_threads; t++) {
+        buffers.push_back(t == 0 ? qk_visbuf : new Vis_Buffer(*qk_visbuf));
 
-            qk_visbuf->ClearVis();
-            qk_visbuf->ProcessVis(cx, cy);
+        row_buffers[t].resize(v_bytes_per_row);
+    }
 
-            CollectRowData(cx, cy, false);
+    std::vector<vis_rows_t> rows(num_clusters);
 
-            if (qk_game == 3) {
-                WriteUncompressedRow();
-                cluster->visofs = 1;  // dummy value, unused
-            } else {
-                cluster->visofs = WriteCompressedRow(false);
+    bool finished =
+        QCOM_ParallelFor(num_clusters, 80, [&](int thread, int i) {
+            if (qk_clusters[i]->leafs.empty()) {
+                return;
             }
 
-            if (qk_game == 2) {
-                // Quake II's Potentially Hearable Set
-                //
-                // 1. start off with the PVS set
-                // 2. flood fill for a few passes
-                // 3. truncate it based on distance
+            Build_ClusterRows(buffers[thread], row_buffers[thread].data(),
+                              i % cluster_W, i / cluster_W, rows[i]);
+        });
+
+    for (int t = 1; t < num_threads; t++) {
+        delete buffers[t];
+    }
+
+    if (!finished) {
+        return;
+    }
 
-                qk_visbuf->FloodFill(4);
-                qk_visbuf->Truncate(8);
+    // write the rows in cluster order
 
-                CollectRowData(cx, cy, true);
+    for (int i = 0; i < num_clusters; i++) {
+        qCluster_c *cluster = qk_clusters[i];
 
-                cluster->hearofs = WriteCompressedRow(true);
+        if (cluster->leafs.empty()) {
+            if (qk_game == 3) {
+                std::vector<byte> blank(v_bytes_per_row, 0);
+                WriteRow(blank, pvs_stats);
             }
 
-            if (done % 80 == 0) {
-                Main::Ticker();
+            continue;
+        }
 
-                if (main_action >= MAIN_CANCEL) {
-                    return;
-                }
-            }
+        pvs_stats.AddValue(rows[i].pvs_perc);
+
+        cluster->visofs = WriteRow(rows[i].pvs, pvs_stats);
 
-            done++;
+        if (qk_game == 3) {
+            cluster->visofs = 1;  // dummy value, unused
+        }
+
+        if (qk_game == 2) {
+            phs_stats.AddValue(rows[i].phs_perc);
+
+            cluster->hearofs = WriteRow(rows[i].phs, phs_stats);
         }
     }
 }
@@ -866,11 +1109,6 @@ void QVIS_Visibility(int lump, int max_size, int numleafs) {
 
     LogPrintf("bits per row: {} --> bytes: {}\n", v_row_bits, v_bytes_per_row);
 
-    v_row_buffer = new byte[1 + v_bytes_per_row];
-
-    // the worst case scenario for compression is 50% larger
-    v_compress_buffer = new byte[1 + 2 * v_bytes_per_row];
-
     q_visibility = BSP_NewLump(lump);
 
     if (qk_game == 3) {
@@ -901,9 +1139,6 @@ void QVIS_Visibility(int lump, int max_size, int numleafs) {
                 "Quake build failure: exceeded VISIBILITY limit\n");
         }
     }
-
-    delete[] v_row_buffer;
-    delete[] v_compress_buffer;
 }
 
 //--- editor settings ---
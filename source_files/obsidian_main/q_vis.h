@@ -74,6 +74,17 @@ void QVIS_FreeTraceNodes();
 // returns true if OK, false if blocked
 bool QVIS_TraceRay(float x1, float y1, float z1, float x2, float y2, float z2);
 
+// the number of rays which QVIS_TraceRayPacket handles at once
+constexpr int TRACE_PACKET_SIZE = 8;
+
+// traces the rays whose bit is set in 'mask', each from (x1[i] y1[i]
+// z1[i]) to the common end point (x2 y2 z2).  The input arrays must
+// have TRACE_PACKET_SIZE elements.  Returns the mask of rays which
+// are OK, which is the same as calling QVIS_TraceRay for each one.
+unsigned int QVIS_TraceRayPacket(unsigned int mask, const float *x1,
+                                 const float *y1, const float *z1, float x2,
+                                 float y2, float z2);
+
 // returns true if point is in air, false for solid or sky
 bool QVIS_TracePoint(float x, float y, float z);
 
@@ -18,31 +18,325 @@
 //
 //------------------------------------------------------------------------
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <thread>
+
+#include <fcntl.h>
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 #include "headers.h"
+#include "lib_signal.h"
 #include "lib_util.h"
 #include "main.h"
 
 #define DEBUG_BUF_LEN 20000
 
-std::fstream log_file;
+// the log file is written with plain write() calls, so nothing is
+// ever sitting in a buffer when the program crashes.
+static int log_fd = -1;
 static std::filesystem::path log_filename;
 
 bool debugging = false;
 bool terminal = false;
 
+static int Log_OpenFile(bool append) {
+#ifdef WIN32
+    int flags = _O_WRONLY | _O_CREAT | _O_TEXT | (append ? _O_APPEND : _O_TRUNC);
+    return _wopen(log_filename.c_str(), flags, _S_IREAD | _S_IWRITE);
+#else
+    int flags = O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC);
+    return open(log_filename.c_str(), flags, 0644);
+#endif
+}
+
+static void Log_CloseFile() {
+    if (log_fd >= 0) {
+#ifdef WIN32
+        _close(log_fd);
+#else
+        close(log_fd);
+#endif
+        log_fd = -1;
+    }
+}
+
+// this is used by the crash handler, so it must stay signal-safe
+static void Log_WriteFile(const char *buf, size_t len) {
+    if (log_fd < 0) {
+        return;
+    }
+
+    while (len > 0) {
+#ifdef WIN32
+        int actual = _write(log_fd, buf, (unsigned int)len);
+#else
+        ssize_t actual = write(log_fd, buf, len);
+#endif
+        if (actual <= 0) {
+            return;
+        }
+
+        buf += actual;
+        len -= actual;
+    }
+}
+
+//------------------------------------------------------------------------
+//  LOG QUEUE
+//------------------------------------------------------------------------
+//
+//  Messages from any thread go into a ring buffer, and a background
+//  thread writes them to the log file.  Adding a message takes no lock:
+//  the adder claims a slot by bumping 'log_write_pos', and the slot's
+//  sequence number tells the reader when the text is there (this is
+//  the bounded queue by Dmitry Vyukov).  When the ring is full, adders
+//  wait for the writer to catch up, nothing is ever dropped.
+//
+//  Everything which reads the queue or touches the file holds
+//  'log_file_mutex', so LogFlush() can be used from any thread.
+//  The crash handler is the exception, see Log_CrashFlush().
+//
+
+#define LOG_RING_SIZE 4096  // must be a power of two
+
+typedef struct {
+    std::atomic<size_t> sequence;
+    std::string text;
+} log_slot_t;
+
+static log_slot_t log_ring[LOG_RING_SIZE];
+
+static std::atomic<size_t> log_write_pos(0);
+static std::atomic<size_t> log_read_pos(0);
+
+// messages are joined up here and written in one go
+static std::string log_batch;
+
+static std::mutex log_file_mutex;
+
+static std::thread log_thread;
+static std::atomic<bool> log_thread_running(false);
+static std::atomic<bool> log_thread_quit(false);
+
+static std::mutex log_wake_mutex;
+static std::condition_variable log_wake;
+static std::atomic<bool> log_thread_idle(false);
+
+static void Log_InitRing() {
+    for (size_t i = 0; i < LOG_RING_SIZE; i++) {
+        log_ring[i].sequence.store(i, std::memory_order_relaxed);
+        log_ring[i].text.clear();
+    }
+
+    log_write_pos.store(0);
+    log_read_pos.store(0);
+}
+
+static void Log_WakeThread() {
+    if (log_thread_idle.load(std::memory_order_relaxed) &&
+        log_thread_idle.exchange(false)) {
+        log_wake.notify_one();
+    }
+}
+
+static void Log_Push(std::string &&text) {
+    size_t pos = log_write_pos.load(std::memory_order_relaxed);
+
+    for (;;) {
+        log_slot_t &S = log_ring[pos & (LOG_RING_SIZE - 1)];
+
+        size_t seq = S.sequence.load(std::memory_order_acquire);
+
+        if (seq == pos) {
+            if (log_write_pos.compare_exchange_weak(
+                    pos, pos + 1, std::memory_order_relaxed)) {
+                S.text = std::move(text);
+                S.sequence.store(pos + 1, std::memory_order_release);
+                break;
+            }
+        } else if ((ptrdiff_t)(seq - pos) < 0) {
+            // the ring is full, let the writer catch up
+            if (log_thread_running.load()) {
+                log_wake.notify_one();
+                std::this_thread::yield();
+            } else {
+                LogFlush();
+            }
+
+            pos = log_write_pos.load(std::memory_order_relaxed);
+        } else {
+            // another thread got this slot first
+            pos = log_write_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    Log_WakeThread();
+}
+
+// caller must hold log_file_mutex.
+// returns false when the queue was empty.
+static bool Log_Drain() {
+    size_t start = log_read_pos.load(std::memory_order_relaxed);
+    size_t end = start;
+
+    log_batch.clear();
+
+    for (;;) {
+        log_slot_t &S = log_ring[end & (LOG_RING_SIZE - 1)];
+
+        if (S.sequence.load(std::memory_order_acquire) != end + 1) {
+            break;
+        }
+
+        log_batch += S.text;
+        end++;
+    }
+
+    if (end == start) {
+        return false;
+    }
+
+    Log_WriteFile(log_batch.data(), log_batch.size());
+
+    // the slots are only given back once they are in the file
+    for (size_t pos = start; pos < end; pos++) {
+        log_slot_t &S = log_ring[pos & (LOG_RING_SIZE - 1)];
+
+        S.text.clear();
+        S.sequence.store(pos + LOG_RING_SIZE, std::memory_order_release);
+    }
+
+    log_read_pos.store(end, std::memory_order_release);
+
+    return true;
+}
+
+static void Log_ThreadFunc() {
+    while (!log_thread_quit.load()) {
+        bool did_any;
+
+        {
+            std::lock_guard<std::mutex> lock(log_file_mutex);
+            did_any = Log_Drain();
+        }
+
+        if (did_any) {
+            continue;
+        }
+
+        // nothing to do, sleep until woken (or a short while, in case
+        // a wake-up was missed).
+        std::unique_lock<std::mutex> lock(log_wake_mutex);
+
+        log_thread_idle.store(true);
+        log_wake.wait_for(lock, std::chrono::milliseconds(20), [] {
+            return !log_thread_idle.load() || log_thread_quit.load();
+        });
+        log_thread_idle.store(false);
+    }
+}
+
+static void Log_StartThread() {
+    log_thread_quit.store(false);
+    log_thread = std::thread(Log_ThreadFunc);
+    log_thread_running.store(true);
+}
+
+static void Log_StopThread() {
+    if (!log_thread_running.load()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(log_wake_mutex);
+        log_thread_quit.store(true);
+    }
+
+    log_wake.notify_one();
+    log_thread.join();
+
+    log_thread_running.store(false);
+}
+
+// exit() can be called without LogClose(), and destroying a thread
+// which is still running would abort the program.
+static void Log_AtExit() {
+    Log_StopThread();
+    LogFlush();
+}
+
+void LogWrite(std::string &&text) {
+    if (log_thread_running.load(std::memory_order_relaxed)) {
+        Log_Push(std::move(text));
+        return;
+    }
+
+    // no writer thread (e.g. after LogClose), write it directly
+    std::lock_guard<std::mutex> lock(log_file_mutex);
+
+    Log_Drain();
+    Log_WriteFile(text.data(), text.size());
+}
+
+void LogFlush(void) {
+    std::lock_guard<std::mutex> lock(log_file_mutex);
+
+    Log_Drain();
+}
+
+// Called from the crash handler, so this only uses atomics and write().
+// It writes whatever is waiting in the ring without taking it out, so
+// if the writer thread was in the middle of a batch, those messages can
+// appear twice.
+static void Log_CrashFlush() {
+    size_t pos = log_read_pos.load(std::memory_order_acquire);
+
+    for (;;) {
+        log_slot_t &S = log_ring[pos & (LOG_RING_SIZE - 1)];
+
+        if (S.sequence.load(std::memory_order_acquire) != pos + 1) {
+            break;
+        }
+
+        Log_WriteFile(S.text.data(), S.text.size());
+        pos++;
+    }
+}
+
+//------------------------------------------------------------------------
+
 bool LogInit(const std::filesystem::path &filename) {
     if (!filename.empty()) {
         log_filename = filename;
 
-        log_file.open(log_filename, std::ios::out);
+        log_fd = Log_OpenFile(false);
 
-        if (!log_file.is_open()) {
+        if (log_fd < 0) {
             return false;
         }
     }
 
+    Log_InitRing();
+    Log_StartThread();
+
+    static bool registered = false;
+
+    if (!registered) {
+        std::atexit(Log_AtExit);
+        Signal_OnCrash(Log_CrashFlush);
+        registered = true;
+    }
+
     LogPrintf("====== START OF OBSIDIAN LOGS ======\n");
 
     return true;
@@ -67,48 +361,54 @@ void LogEnableTerminal(bool enable) { terminal = enable; }
 void LogClose(void) {
     LogPrintf("\n====== END OF OBSIDIAN LOGS ======\n\n");
 
-    log_file.close();
+    Log_StopThread();
+    LogFlush();
+
+    Log_CloseFile();
     log_filename.clear();
 }
 
 void LogReadLines(log_display_func_t display_func, void *priv_data) {
-    if (!log_file) {
+    if (log_fd < 0) {
         return;
     }
 
+    // keep the writer thread off the file while we have it closed
+    LogFlush();
+
+    std::lock_guard<std::mutex> lock(log_file_mutex);
+
     // we close the log file so we can read it, and then open it
     // again when finished.  That is because Windows OSes can be
     // fussy about opening already open files (in Linux it would
     // not be an issue).
 
-    log_file.close();
+    Log_CloseFile();
 
-    log_file.open(log_filename, std::ios::in);
+    std::ifstream in_file(log_filename);
 
     // this is very unlikely to happen, but check anyway
-    if (!log_file.is_open()) {
-        return;
-    }
+    if (in_file.is_open()) {
+        std::string buffer;
+        while (std::getline(in_file, buffer)) {
+            // remove any newline at the end (LF or CR/LF)
+            StringRemoveCRLF(&buffer);
 
-    std::string buffer;
-    while (std::getline(log_file, buffer)) {
-        // remove any newline at the end (LF or CR/LF)
-        StringRemoveCRLF(&buffer);
+            // remove any DEL characters (mainly to workaround an FLTK bug)
+            StringReplaceChar(&buffer, 0x7f, 0);
 
-        // remove any DEL characters (mainly to workaround an FLTK bug)
-        StringReplaceChar(&buffer, 0x7f, 0);
+            std::cout << buffer << std::endl;
 
-        std::cout << buffer << std::endl;
+            display_func(buffer, priv_data);
+        }
 
-        display_func(buffer, priv_data);
+        // close the log file after current contents are read
+        in_file.close();
     }
 
-    // close the log file after current contents are read
-    log_file.close();
-
     // open the log file for writing again
     // [ it is unlikely to fail, but if it does then no biggie ]
-    log_file.open(log_filename, std::ios::app);
+    log_fd = Log_OpenFile(true);
 }
 
 //--- editor settings ---
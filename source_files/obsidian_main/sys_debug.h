@@ -21,7 +21,6 @@
 #ifndef __SYS_DEBUG_H__
 #define __SYS_DEBUG_H__
 
-#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <string>
@@ -29,32 +28,35 @@
 #include <fmt/ostream.h>
 extern bool terminal;
 extern bool debugging;
-extern std::fstream log_file;
 bool LogInit(const std::filesystem::path &filename);  // NULL for none
 void LogClose(void);
 
 void LogEnableDebug(bool enable);
 void LogEnableTerminal(bool enable);
 
+// puts a finished message on the log queue, the background thread
+// will write it to the log file.
+void LogWrite(std::string &&text);
+
+// writes out everything in the log queue (waits for it)
+void LogFlush(void);
+
 template <typename... Args>
 void LogPrintf(std::string_view str, Args &&...args) {
-    fmt::print(log_file, str, args...);
+    std::string text = fmt::format(str, args...);
 
     // show on the Linux terminal too
     if (terminal) {
-        fmt::print(str, args...);
+        fmt::print("{}", text);
     }
+
+    LogWrite(std::move(text));
 }
 template <typename... Args>
 void DebugPrintf(std::string_view format, Args &&...args) {
+    // check before formatting, debug messages are usually off
     if (debugging) {
-        std::string buffer = fmt::format(format, args...);
-        auto next = std::find(buffer.begin(), buffer.end(), '\n');
-        for (auto pos = buffer.begin(); pos != buffer.end();) {
-            LogPrintf("{}", std::string{pos, next});
-            pos = next;
-            next = std::find(pos + 1, buffer.end(), '\n');
-        }
+        LogPrintf(format, args...);
     }
 }
 
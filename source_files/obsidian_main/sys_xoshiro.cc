@@ -9,24 +9,179 @@ Usage will be as similar to AJ_Random as possible in order to minimize
 changes in other sections of code.
 */
 
-#include "../fastPRNG/fastPRNG.h"
+#include "sys_xoshiro.h"
+
+#include <map>
+#include <tuple>
+
+#include "sys_assert.h"
 
 fastPRNG::fastXS64 xoshiro;
 
-void xoshiro_Reseed(unsigned long long newseed) { xoshiro.seed(newseed); }
+// seed of the legacy generator, which all streams are derived from
+static unsigned long long master_seed;
+
+// NULL means the legacy generator
+static xoshiro_stream_c *current_stream;
+
+static std::map<std::tuple<int, int, int>, xoshiro_stream_c> all_streams;
 
-unsigned long long xoshiro_UInt() {
-    long long rand_num = (long long)(xoshiro.xoshiro256p());
+// these convert a raw number in the same way as the fastPRNG code does
+
+// UNI_64BIT_INV from fastPRNG.h (which undefines it)
+static const double xoshiro_uni_64bit_inv = 5.42101086242752217003726400434970e-20;
+
+static unsigned long long Xoshiro_ToUInt(unsigned long long raw) {
+    long long rand_num = (long long)raw;
     if (rand_num >= 0) {
         return rand_num;
     }
     return -rand_num;
 }
 
-double xoshiro_Double() { return xoshiro.xoshiro256p_UNI<double>(); }
+static double Xoshiro_ToDouble(unsigned long long raw) {
+    return double(raw) * xoshiro_uni_64bit_inv;
+}
+
+static int Xoshiro_ToBetween(unsigned long long raw, int low, int high) {
+    float uni = float(raw) * xoshiro_uni_64bit_inv;
+
+    return (int)(float(low) + (float(high) - float(low)) * uni);
+}
+
+static unsigned long long Xoshiro_Next() {
+    if (current_stream) {
+        return current_stream->Next();
+    }
+
+    return xoshiro.xoshiro256p();
+}
+
+void xoshiro_Reseed(unsigned long long newseed) {
+    xoshiro.seed(newseed);
+
+    master_seed = newseed;
+
+    current_stream = NULL;
+    all_streams.clear();
+}
+
+unsigned long long xoshiro_UInt() { return Xoshiro_ToUInt(Xoshiro_Next()); }
+
+double xoshiro_Double() { return Xoshiro_ToDouble(Xoshiro_Next()); }
 
 // This probably isn't super efficient, but it is rarely used and shouldn't make
 // a huge overall hit to performance - Dasho
 int xoshiro_Between(int low, int high) {
-    return (int)(xoshiro.xoshiro256p_Range<float>(low, high));
+    return Xoshiro_ToBetween(Xoshiro_Next(), low, high);
+}
+
+//------------------------------------------------------------------------
+//  STREAMS
+//------------------------------------------------------------------------
+
+void xoshiro_stream_c::Seed(unsigned long long seed) {
+    // same as fastXS64::seed()
+    s[0] = fastPRNG::splitMix64(seed);
+    s[1] = fastPRNG::splitMix64(s[0]);
+    s[2] = fastPRNG::splitMix64(s[1]);
+    s[3] = fastPRNG::splitMix64(s[2]);
 }
+
+unsigned long long xoshiro_stream_c::Next() {
+    // xoshiro256+
+    const uint64_t result = s[0] + s[3];
+    const uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = fastPRNG::rotl<uint64_t>(s[3], 45);
+
+    return result;
+}
+
+void xoshiro_stream_c::ApplyJump(const uint64_t *table) {
+    uint64_t j[4] = {0, 0, 0, 0};
+
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 64; b++) {
+            if (table[i] & (uint64_t(1) << b)) {
+                j[0] ^= s[0];
+                j[1] ^= s[1];
+                j[2] ^= s[2];
+                j[3] ^= s[3];
+            }
+            Next();
+        }
+    }
+
+    s[0] = j[0];
+    s[1] = j[1];
+    s[2] = j[2];
+    s[3] = j[3];
+}
+
+void xoshiro_stream_c::Jump() {
+    static const uint64_t table[4] = {0x180ec6d33cfd0aba, 0xd5a61266f0c9392c,
+                                      0xa9582618e03fc9aa, 0x39abdc4529b1661c};
+
+    ApplyJump(table);
+}
+
+void xoshiro_stream_c::LongJump() {
+    static const uint64_t table[4] = {0x76e15d3efefdcbbf, 0xc5004e441c522fb3,
+                                      0x77710069854ee241, 0x39109bb02acbe635};
+
+    ApplyJump(table);
+}
+
+unsigned long long xoshiro_stream_c::UInt() { return Xoshiro_ToUInt(Next()); }
+
+double xoshiro_stream_c::Double() { return Xoshiro_ToDouble(Next()); }
+
+int xoshiro_stream_c::Between(int low, int high) {
+    return Xoshiro_ToBetween(Next(), low, high);
+}
+
+//
+// Each subsystem starts from its own seed (the script one being the
+// same as the legacy generator), then gets long_jump() once per level
+// and jump() once per index.  This function only reads the master
+// seed, so it is safe to call from worker threads.
+//
+xoshiro_stream_c xoshiro_Stream(int subsystem, int level, int index) {
+    SYS_ASSERT(0 <= subsystem && subsystem < NUM_XSTREAMS);
+    SYS_ASSERT(level >= 0 && index >= 0);
+
+    xoshiro_stream_c X(master_seed + subsystem * 0x9E3779B97F4A7C15ULL);
+
+    for (int i = 0; i < level; i++) {
+        X.LongJump();
+    }
+
+    for (int i = 0; i < index; i++) {
+        X.Jump();
+    }
+
+    return X;
+}
+
+void xoshiro_SelectStream(int subsystem, int level, int index) {
+    std::tuple<int, int, int> key(subsystem, level, index);
+
+    auto it = all_streams.find(key);
+
+    if (it == all_streams.end()) {
+        it = all_streams
+                 .insert(std::make_pair(key,
+                                        xoshiro_Stream(subsystem, level, index)))
+                 .first;
+    }
+
+    current_stream = &it->second;
+}
+
+void xoshiro_SelectLegacy() { current_stream = NULL; }
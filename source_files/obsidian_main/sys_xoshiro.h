@@ -1,5 +1,8 @@
 // Xoshiro256 Random Generator
 
+#ifndef __SYS_XOSHIRO_H__
+#define __SYS_XOSHIRO_H__
+
 #include "../fastPRNG/fastPRNG.h"
 
 extern fastPRNG::fastXS64 xoshiro;
@@ -11,3 +14,56 @@ unsigned long long xoshiro_UInt();
 double xoshiro_Double();
 
 int xoshiro_Between(int low, int high);
+
+// Streams
+//
+// A stream is a separate xoshiro256+ generator derived from the seed
+// given to xoshiro_Reseed().  Each subsystem gets its own sequence of
+// streams, split by level with long_jump() and by an index (e.g. a
+// room) with jump(), so code using its own stream gets the same
+// numbers no matter what order (or on what thread) things are done.
+
+// NOTE: the names in gui_rand_stream() must match this
+typedef enum {
+    XSTREAM_Script = 0,
+    XSTREAM_Level,
+    XSTREAM_Room,
+    XSTREAM_Fight,
+    XSTREAM_Slump,
+    XSTREAM_Texture,
+
+    NUM_XSTREAMS
+} xoshiro_subsystem_e;
+
+class xoshiro_stream_c {
+   public:
+    xoshiro_stream_c(unsigned long long seed = 0) { Seed(seed); }
+
+    void Seed(unsigned long long seed);
+
+    // advance by 2^128 and 2^192 numbers
+    void Jump();
+    void LongJump();
+
+    unsigned long long Next();
+
+    // the same as the xoshiro_XXX() functions
+    unsigned long long UInt();
+    double Double();
+    int Between(int low, int high);
+
+   private:
+    void ApplyJump(const uint64_t *table);
+
+    uint64_t s[4];
+};
+
+xoshiro_stream_c xoshiro_Stream(int subsystem, int level, int index);
+
+// make xoshiro_UInt() etc use a stream instead of the legacy global
+// generator.  each stream carries on from where it was last used,
+// until the next xoshiro_Reseed().
+void xoshiro_SelectStream(int subsystem, int level, int index);
+void xoshiro_SelectLegacy();
+
+#endif /* __SYS_XOSHIRO_H__ */
@@ -24,6 +24,31 @@
 
 #define MAX_RECURSION 4
 
+void Vis_Bits::SetSpan(int x1, int x2, int y) {
+    uint64_t *row = Row(y);
+
+    int w1 = x1 >> 6;
+    int w2 = x2 >> 6;
+
+    uint64_t first = ~(uint64_t)0 << (x1 & 63);
+    uint64_t last = ~(uint64_t)0 >> (63 - (x2 & 63));
+
+    if (w1 == w2) {
+        row[w1] |= first & last;
+        return;
+    }
+
+    row[w1] |= first;
+
+    for (int k = w1 + 1; k < w2; k++) {
+        row[k] = ~(uint64_t)0;
+    }
+
+    row[w2] |= last;
+}
+
+//------------------------------------------------------------------------
+
 Vis_Buffer::Vis_Buffer(int width, int height)
     : W(width),
       H(height),
@@ -31,14 +56,36 @@ Vis_Buffer::Vis_Buffer(int width, int height)
       flip_x(0),
       flip_y(0),
       saved_cells() {
-    data = new short[W * H];
+    wall_bottom.Resize(W, H);
+    wall_left.Resize(W, H);
+    diag_ne.Resize(W, H);
+    diag_se.Resize(W, H);
+    blocked.Resize(W, H);
+}
 
-    Clear();
+Vis_Buffer::Vis_Buffer(const Vis_Buffer &other)
+    : W(other.W),
+      H(other.H),
+      wall_bottom(other.wall_bottom),
+      wall_left(other.wall_left),
+      diag_ne(other.diag_ne),
+      diag_se(other.diag_se),
+      quick_mode(other.quick_mode),
+      flip_x(0),
+      flip_y(0),
+      saved_cells() {
+    blocked.Resize(W, H);
 }
 
-Vis_Buffer::~Vis_Buffer() { delete[] data; }
+Vis_Buffer::~Vis_Buffer() {}
 
-void Vis_Buffer::Clear() { memset(data, 0, sizeof(short) * W * H); }
+void Vis_Buffer::Clear() {
+    wall_bottom.Clear();
+    wall_left.Clear();
+    diag_ne.Clear();
+    diag_se.Clear();
+    blocked.Clear();
+}
 
 void Vis_Buffer::SetQuickMode(bool enable) { quick_mode = enable; }
 
@@ -58,9 +105,9 @@ void Vis_Buffer::AddWall(int x, int y, int side) {
     }
 
     if (side == 2) {
-        at(x, y) |= V_BOTTOM;
+        wall_bottom.Set(Trans_X(x), Trans_Y(y));
     } else {
-        at(x, y) |= V_LEFT;
+        wall_left.Set(Trans_X(x), Trans_Y(y));
     }
 }
 
@@ -90,9 +137,9 @@ bool Vis_Buffer::TestWall(int x, int y, int side) {
     }
 
     if (side == 2) {
-        return (at(x, y) & V_BOTTOM) ? true : false;
+        return wall_bottom.Get(Trans_X(x), Trans_Y(y));
     } else {
-        return (at(x, y) & V_LEFT) ? true : false;
+        return wall_left.Get(Trans_X(x), Trans_Y(y));
     }
 }
 
@@ -102,9 +149,9 @@ void Vis_Buffer::AddDiagonal(int x, int y, int dir) {
     }
 
     if (dir == 1 || dir == 9) {
-        at(x, y) |= V_DIAG_NE;
+        diag_ne.Set(Trans_X(x), Trans_Y(y));
     } else {
-        at(x, y) |= V_DIAG_SE;
+        diag_se.Set(Trans_X(x), Trans_Y(y));
     }
 }
 
@@ -135,10 +182,10 @@ void Vis_Buffer::WriteMap(const char *filename) {
 
     for (int y = 0; y < H; y++) {
         for (int x = 0; x < W; x++) {
-            if (at(x, y) & V_BOTTOM) {
+            if (wall_bottom.Get(x, y)) {
                 fmt::print(fp, "%d %d {}\n", x, y, 2);
             }
-            if (at(x, y) & V_LEFT) {
+            if (wall_left.Get(x, y)) {
                 fmt::print(fp, "%d %d {}\n", x, y, 4);
             }
         }
@@ -149,6 +196,18 @@ void Vis_Buffer::WriteMap(const char *filename) {
 
 //------------------------------------------------------------------------
 
+// blocks a horizontal run of cells (in transformed coordinates)
+void Vis_Buffer::BlockSpan(int x1, int x2, int y) {
+    if (x1 > x2) {
+        return;
+    }
+
+    x1 = Trans_X(x1);
+    x2 = Trans_X(x2);
+
+    blocked.SetSpan(MIN(x1, x2), MAX(x1, x2), Trans_Y(y));
+}
+
 void Vis_Buffer::DoBasic(int dx, int dy, int side) {
     int x = loc_x;
     int y = loc_y;
@@ -186,8 +245,14 @@ void Vis_Buffer::DoBasic(int dx, int dy, int side) {
             return;
         }
 
-        for (int j = -R; j <= L; j++) {
-            at(x + dy * j, y + dx * j) |= V_BASIC;
+        if (dx == 0) {
+            // the row is horizontal
+            BlockSpan(x + dy * (dy > 0 ? -R : L), x + dy * (dy > 0 ? L : -R),
+                      y);
+        } else {
+            for (int j = -R; j <= L; j++) {
+                Block(x + dy * j, y + dx * j);
+            }
         }
     }
 }
@@ -210,10 +275,10 @@ void Vis_Buffer::DoFill() {
                 break;
             }
 
-            if (!(at(sx + 1, sy + 1) & V_ANY) &&
-                ((at(sx + 1, sy) & V_ANY) || TestWall(sx + 1, sy, 8)) &&
-                ((at(sx, sy + 1) & V_ANY) || TestWall(sx, sy + 1, 6))) {
-                at(sx + 1, sy + 1) |= V_FILL;
+            if (!isBlocked(sx + 1, sy + 1) &&
+                (isBlocked(sx + 1, sy) || TestWall(sx + 1, sy, 8)) &&
+                (isBlocked(sx, sy + 1) || TestWall(sx, sy + 1, 6))) {
+                Block(sx + 1, sy + 1);
             }
         }
     }
@@ -263,9 +328,7 @@ void Vis_Buffer::MarkSteps(const Stair_Steps &steps) {
     // fill in the "gaps" inside the bbox (behind the stair-step)
     for (unsigned int i = 0; i < steps.size(); i++) {
         if (steps[i].side == 4) {
-            for (int sx = steps[i].x; sx < lx + ww; sx++) {
-                at(sx, steps[i].y) |= V_LSHAPE;
-            }
+            BlockSpan(steps[i].x, lx + ww - 1, steps[i].y);
         }
     }
 
@@ -316,7 +379,7 @@ void Vis_Buffer::MarkSteps(const Stair_Steps &steps) {
         }
 
         for (int ny = y1; ny <= y2 && isValid(nx, ny); ny++) {
-            at(nx, ny) |= V_SPAN;
+            Block(nx, ny);
         }
     }
 }
@@ -424,36 +487,67 @@ void Vis_Buffer::DoSteps(int quadrant) {
 
 //------------------------------------------------------------------------
 
-#define V_UNLOCK 0x2000
-
 void Vis_Buffer::FloodEmpties() {
     // a blocked cell which neighbors an unblocked cell (with no wall in
     // the way) will become unblocked.  The trick is to prevent flow-on
-    // effects, and that is what V_UNLOCK is for.
+    // effects, so all the unlocked cells are found first and only then
+    // cleared.  This works on whole 64-bit words of each row.
+
+    int words = blocked.words;
+
+    uint64_t last_mask = blocked.LastMask();
+
+    std::vector<uint64_t> open(words * H);
+    std::vector<uint64_t> unlock(words * H);
 
     for (int y = 0; y < H; y++) {
-        for (int x = 0; x < W; x++) {
-            if (at(x, y) & V_ANY) {
-                continue;
-            }
+        const uint64_t *B = blocked.Row(y);
 
-            for (int side = 2; side <= 8; side += 2) {
-                int nx = x + ((side == 4) ? -1 : (side == 6) ? +1 : 0);
-                int ny = y + ((side == 2) ? -1 : (side == 8) ? +1 : 0);
+        for (int k = 0; k < words; k++) {
+            open[y * words + k] =
+                ~B[k] & ((k == words - 1) ? last_mask : ~(uint64_t)0);
+        }
+    }
+
+    for (int y = 0; y < H; y++) {
+        const uint64_t *B = blocked.Row(y);
+        const uint64_t *left = wall_left.Row(y);
+        const uint64_t *bottom = wall_bottom.Row(y);
+
+        const uint64_t *O = &open[y * words];
+        uint64_t *U = &unlock[y * words];
+
+        for (int k = 0; k < words; k++) {
+            // from the cell on the left : wall is our left side
+            uint64_t from_left = (O[k] << 1) | (k > 0 ? O[k - 1] >> 63 : 0);
+
+            // from the cell on the right : wall is its left side
+            uint64_t R0 = O[k] & ~left[k];
+            uint64_t R1 = (k + 1 < words) ? (O[k + 1] & ~left[k + 1]) : 0;
+
+            uint64_t from_right = (R0 >> 1) | (R1 << 63);
+
+            uint64_t bits = (from_left & ~left[k]) | from_right;
 
-                if (isValid(nx, ny) && (at(nx, ny) & V_ANY) &&
-                    !TestWall(x, y, side)) {
-                    at(nx, ny) |= V_UNLOCK;
-                }
+            // from the cell below : wall is our bottom side
+            if (y > 0) {
+                bits |= O[k - words] & ~bottom[k];
             }
+
+            // from the cell above : wall is its bottom side
+            if (y + 1 < H) {
+                bits |= O[k + words] & ~wall_bottom.Row(y + 1)[k];
+            }
+
+            U[k] = bits & B[k];
         }
     }
 
     for (int y = 0; y < H; y++) {
-        for (int x = 0; x < W; x++) {
-            if (at(x, y) & V_UNLOCK) {
-                at(x, y) &= ~V_ANY;  // clears V_UNLOCK too
-            }
+        uint64_t *B = blocked.Row(y);
+
+        for (int k = 0; k < words; k++) {
+            B[k] &= ~unlock[y * words + k];
         }
     }
 }
@@ -465,14 +559,35 @@ void Vis_Buffer::FloodFill(int passes) {
 }
 
 void Vis_Buffer::Truncate(int dist) {
+    // everything at least 'dist' away becomes blocked.  On each row the
+    // cells still in range form a single span, so the rest of the row
+    // is blocked a word at a time.
+
     for (int y = 0; y < H; y++) {
-        for (int x = 0; x < W; x++) {
-            int dx = abs(x - loc_x);
-            int dy = abs(y - loc_y);
+        int dy = abs(y - loc_y);
 
-            if (dx * dx + dy * dy >= dist * dist) {
-                at(x, y) |= V_FILL;
-            }
+        int r2 = dist * dist - dy * dy;
+
+        if (r2 <= 0) {
+            blocked.SetSpan(0, W - 1, y);
+            continue;
+        }
+
+        // largest dx where dx * dx < r2
+        int m = (int)sqrt((double)r2);
+
+        while (m * m >= r2) {
+            m--;
+        }
+        while ((m + 1) * (m + 1) < r2) {
+            m++;
+        }
+
+        if (loc_x - m > 0) {
+            blocked.SetSpan(0, MIN(W - 1, loc_x - m - 1), y);
+        }
+        if (loc_x + m < W - 1) {
+            blocked.SetSpan(MAX(0, loc_x + m + 1), W - 1, y);
         }
     }
 }
@@ -494,19 +609,22 @@ void Vis_Buffer::AddWallSave(int x, int y, int side) {
         return;
     }
 
-    // save original contents (mask out vis results)
+    x = Trans_X(x);
+    y = Trans_Y(y);
+
+    // save original walls
     Stair_Pos pos;
 
     pos.x = x;
     pos.y = y;
-    pos.side = at(x, y) & ~V_ANY;
+    pos.side = (wall_bottom.Get(x, y) ? 1 : 0) | (wall_left.Get(x, y) ? 2 : 0);
 
     saved_cells.push_back(pos);
 
     if (side == 2) {
-        at(x, y) |= V_BOTTOM;
+        wall_bottom.Set(x, y);
     } else {
-        at(x, y) |= V_LEFT;
+        wall_left.Set(x, y);
     }
 }
 
@@ -521,8 +639,8 @@ void Vis_Buffer::ConvertDiagonals() {
                 continue;
             }
 
-            short se = (at(x, y) & V_DIAG_SE);
-            short ne = (at(x, y) & V_DIAG_NE);
+            bool se = diag_se.Get(Trans_X(x), Trans_Y(y));
+            bool ne = diag_ne.Get(Trans_X(x), Trans_Y(y));
 
             if (se && loc_x <= x && loc_y <= y) {
                 AddWallSave(x, y, 6);
@@ -553,8 +671,8 @@ void Vis_Buffer::RestoreDiagonals() {
     for (int i = total - 1; i >= 0; i--) {
         const Stair_Pos &pos = saved_cells[i];
 
-        at(pos.x, pos.y) &= V_ANY;
-        at(pos.x, pos.y) |= pos.side;
+        wall_bottom.Put(pos.x, pos.y, (pos.side & 1) != 0);
+        wall_left.Put(pos.x, pos.y, (pos.side & 2) != 0);
     }
 
     saved_cells.clear();
@@ -564,43 +682,37 @@ void Vis_Buffer::SimplifySolid() {
     // this removes walls which lie between two solid cells, in order
     // to prevent the need for excessive recursion in FollowStair().
 
+    Vis_Bits solid;
+
+    solid.Resize(W, H);
+
     for (int y = 0; y < H; y++) {
         for (int x = 0; x < W; x++) {
-            at(x, y) &= ~V_BASIC;
-
             if (TestWall(x, y, 2) && TestWall(x, y, 4) && TestWall(x, y, 6) &&
                 TestWall(x, y, 8)) {
-                at(x, y) |= V_BASIC;
+                solid.Set(x, y);
             }
         }
     }
 
     for (int y = 0; y < H; y++) {
         for (int x = 0; x < W; x++) {
-            if (!(at(x, y) & V_BASIC)) {
+            if (!solid.Get(x, y)) {
                 continue;
             }
 
-            if (x < (W - 1) && (at(x + 1, y) & V_LEFT) &&
-                (at(x + 1, y) & V_BASIC)) {
-                at(x + 1, y) &= ~V_LEFT;
+            if (x < (W - 1) && solid.Get(x + 1, y)) {
+                wall_left.Reset(x + 1, y);
             }
 
-            if (y < (H - 1) && (at(x, y + 1) & V_BOTTOM) &&
-                (at(x, y + 1) & V_BASIC)) {
-                at(x, y + 1) &= ~V_BOTTOM;
+            if (y < (H - 1) && solid.Get(x, y + 1)) {
+                wall_bottom.Reset(x, y + 1);
             }
         }
     }
 }
 
-void Vis_Buffer::ClearVis() {
-    int len = W * H;
-
-    for (int i = 0; i < len; i++) {
-        data[i] &= ~V_ANY;
-    }
-}
+void Vis_Buffer::ClearVis() { blocked.Clear(); }
 
 void Vis_Buffer::ProcessVis(int x, int y) {
     loc_x = x;
@@ -19,33 +19,81 @@
 #ifndef __OBLIGE_VIS_BUFFER_H__
 #define __OBLIGE_VIS_BUFFER_H__
 
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 
-// map data
-#define V_BOTTOM 0x01
-#define V_LEFT 0x02
-#define V_DIAG_NE 0x04  // diagonal like '/'
-#define V_DIAG_SE 0x08  // diagonal like '\'
-
-// vis results
-#define V_BASIC 0x0100   // ultra basic
-#define V_SPAN 0x0200    // long spans
-#define V_LSHAPE 0x0400  // L shape testing
-#define V_FILL 0x0800
-
-#define V_ANY 0x7F00
-
 struct Stair_Pos {
     short x, y, side;
 };
 
 typedef std::vector<Stair_Pos> Stair_Steps;
 
+// A W x H grid of bits.  Each row is padded out to whole 64-bit words,
+// so whole rows can be worked on a word at a time.
+class Vis_Bits {
+   public:
+    int W, H;
+    int words;  // per row
+
+    std::vector<uint64_t> bits;
+
+   public:
+    Vis_Bits() : W(0), H(0), words(0), bits() {}
+
+    void Resize(int width, int height) {
+        W = width;
+        H = height;
+        words = (W + 63) >> 6;
+
+        bits.assign(words * H, 0);
+    }
+
+    void Clear() { std::fill(bits.begin(), bits.end(), 0); }
+
+    inline uint64_t *Row(int y) { return &bits[y * words]; }
+    inline const uint64_t *Row(int y) const { return &bits[y * words]; }
+
+    inline bool Get(int x, int y) const {
+        return (Row(y)[x >> 6] >> (x & 63)) & 1;
+    }
+
+    inline void Set(int x, int y) { Row(y)[x >> 6] |= (uint64_t)1 << (x & 63); }
+
+    inline void Reset(int x, int y) {
+        Row(y)[x >> 6] &= ~((uint64_t)1 << (x & 63));
+    }
+
+    inline void Put(int x, int y, bool value) {
+        if (value) {
+            Set(x, y);
+        } else {
+            Reset(x, y);
+        }
+    }
+
+    // sets every bit from x1 to x2 (inclusive) on row y
+    void SetSpan(int x1, int x2, int y);
+
+    // the valid bits in the last word of each row
+    inline uint64_t LastMask() const {
+        return (W & 63) ? ((uint64_t)1 << (W & 63)) - 1 : ~(uint64_t)0;
+    }
+};
+
 class Vis_Buffer {
    private:
     int W, H;  // size
 
-    short *data;
+    // map data: walls on the bottom and left side of each cell, and
+    // diagonals like '/' (NE) and '\' (SE) through it.
+    Vis_Bits wall_bottom;
+    Vis_Bits wall_left;
+    Vis_Bits diag_ne;
+    Vis_Bits diag_se;
+
+    // vis results: the cells which cannot be seen
+    Vis_Bits blocked;
 
     bool quick_mode;
 
@@ -64,6 +112,9 @@ class Vis_Buffer {
     Vis_Buffer(int width, int height);
     ~Vis_Buffer();
 
+    // copies the map data (walls and diagonals), but not vis results
+    Vis_Buffer(const Vis_Buffer &other);
+
    public:
     inline int Trans_X(int x) { return flip_x ? (loc_x * 2 - x) : x; }
 
@@ -84,16 +135,13 @@ class Vis_Buffer {
         return (0 <= x && x < W) && (0 <= y && y < H);
     }
 
-    inline short &at(int x, int y) {
-        x = Trans_X(x);
-        y = Trans_Y(y);
-
-        return data[y * W + x];
+    inline bool isBlocked(int x, int y) {
+        return blocked.Get(Trans_X(x), Trans_Y(y));
     }
 
-    inline bool CanSee(int x, int y) const {
-        return ((data[y * W + x] & V_ANY) == 0);
-    }
+    inline void Block(int x, int y) { blocked.Set(Trans_X(x), Trans_Y(y)); }
+
+    inline bool CanSee(int x, int y) const { return !blocked.Get(x, y); }
 
    public:
     void Clear();
@@ -122,6 +170,8 @@ class Vis_Buffer {
     void FollowStair(Stair_Steps &steps, int sx, int sy, int side,
                      int recursion);
 
+    void BlockSpan(int x1, int x2, int y);
+
     void ConvertDiagonals();
     void RestoreDiagonals();
     void AddWallSave(int x, int y, int side);
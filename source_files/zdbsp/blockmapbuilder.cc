@@ -22,6 +22,9 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <thread>
+#include <vector>
+
 #include "tarray.h"
 #include "templates.h"
 #include "zdbsp.h"
@@ -151,12 +154,124 @@ notest:
     return &BlockMap[0];
 }
 
+//==========================================================================
+//
+// WalkLineBlocks
+//
+// Calls visit for every block the line passes through, in the same order
+// the original single-threaded builder pushed them.
+//
+//==========================================================================
+
+template <class Visitor>
+static void WalkLineBlocks(const FLevel &level, WORD line, int minx, int miny,
+                           int bmapwidth, Visitor &&visit) {
+    int x1 = level.Vertices[level.Lines[line].v1].x >> FRACBITS;
+    int y1 = level.Vertices[level.Lines[line].v1].y >> FRACBITS;
+    int x2 = level.Vertices[level.Lines[line].v2].x >> FRACBITS;
+    int y2 = level.Vertices[level.Lines[line].v2].y >> FRACBITS;
+    int dx = x2 - x1;
+    int dy = y2 - y1;
+    int bx = (x1 - minx) >> BLOCKBITS;
+    int by = (y1 - miny) >> BLOCKBITS;
+    int bx2 = (x2 - minx) >> BLOCKBITS;
+    int by2 = (y2 - miny) >> BLOCKBITS;
+
+    int block = bx + by * bmapwidth;
+    int endblock = bx2 + by2 * bmapwidth;
+
+    if (block == endblock)  // Single block
+    {
+        visit(block);
+    } else if (by == by2)  // Horizontal line
+    {
+        if (bx > bx2) {
+            swap(block, endblock);
+        }
+        do {
+            visit(block);
+            block += 1;
+        } while (block <= endblock);
+    } else if (bx == bx2)  // Vertical line
+    {
+        if (by > by2) {
+            swap(block, endblock);
+        }
+        do {
+            visit(block);
+            block += bmapwidth;
+        } while (block <= endblock);
+    } else  // Diagonal line
+    {
+        int xchange = (dx < 0) ? -1 : 1;
+        int ychange = (dy < 0) ? -1 : 1;
+        int ymove = ychange * bmapwidth;
+        int adx = abs(dx);
+        int ady = abs(dy);
+
+        if (adx == ady)  // 45 degrees
+        {
+            int xb = (x1 - minx) & (BLOCKSIZE - 1);
+            int yb = (y1 - miny) & (BLOCKSIZE - 1);
+            if (dx < 0) {
+                xb = BLOCKSIZE - xb;
+            }
+            if (dy < 0) {
+                yb = BLOCKSIZE - yb;
+            }
+            if (xb < yb) adx--;
+        }
+        if (adx >= ady)  // X-major
+        {
+            int yadd = dy < 0 ? -1 : BLOCKSIZE;
+            do {
+                int stop =
+                    (Scale((by << BLOCKBITS) + yadd - (y1 - miny), dx, dy) +
+                     (x1 - minx)) >>
+                    BLOCKBITS;
+                while (bx != stop) {
+                    visit(block);
+                    block += xchange;
+                    bx += xchange;
+                }
+                visit(block);
+                block += ymove;
+                by += ychange;
+            } while (by != by2);
+            while (block != endblock) {
+                visit(block);
+                block += xchange;
+            }
+            visit(block);
+        } else  // Y-major
+        {
+            int xadd = dx < 0 ? -1 : BLOCKSIZE;
+            do {
+                int stop =
+                    (Scale((bx << BLOCKBITS) + xadd - (x1 - minx), dy, dx) +
+                     (y1 - miny)) >>
+                    BLOCKBITS;
+                while (by != stop) {
+                    visit(block);
+                    block += ymove;
+                    by += ychange;
+                }
+                visit(block);
+                block += xchange;
+                bx += xchange;
+            } while (bx != bx2);
+            while (block != endblock) {
+                visit(block);
+                block += ymove;
+            }
+            visit(block);
+        }
+    }
+}
+
 void FBlockmapBuilder::BuildBlockmap() {
-    TArray<WORD> *BlockLists, *block, *endblock;
     WORD adder;
-    int bmapwidth, bmapheight;
     int minx, maxx, miny, maxy;
-    WORD line;
 
     if (Level.NumVertices <= 0) return;
 
@@ -179,218 +294,203 @@ void FBlockmapBuilder::BuildBlockmap() {
             minx &= ~7;
             miny &= ~7;
     */
-    bmapwidth = ((maxx - minx) >> BLOCKBITS) + 1;
-    bmapheight = ((maxy - miny) >> BLOCKBITS) + 1;
+    BlockMinX = minx;
+    BlockMinY = miny;
+    BlockWidth = ((maxx - minx) >> BLOCKBITS) + 1;
+    BlockHeight = ((maxy - miny) >> BLOCKBITS) + 1;
 
     adder = WORD(minx);
     BlockMap.Push(adder);
     adder = WORD(miny);
     BlockMap.Push(adder);
-    adder = WORD(bmapwidth);
+    adder = WORD(BlockWidth);
     BlockMap.Push(adder);
-    adder = WORD(bmapheight);
+    adder = WORD(BlockHeight);
     BlockMap.Push(adder);
 
-    BlockLists = new TArray<WORD>[bmapwidth * bmapheight];
+    int numblocks = BlockWidth * BlockHeight;
+
+    // Every thread owns a band of whole block rows, so each one writes a
+    // disjoint range of BlockStarts/BlockLines and no locking is needed.
+    // Lines are still visited in order within a band, which keeps every
+    // block's line list sorted exactly as the serial builder had it.
+    int numthreads = 1;
+    if (Level.NumLines() >= MIN_LINES_PER_THREAD * 2) {
+        numthreads = int(std::thread::hardware_concurrency());
+        numthreads = MIN(numthreads, Level.NumLines() / MIN_LINES_PER_THREAD);
+        numthreads = MIN(numthreads, BlockHeight);
+        numthreads = MAX(numthreads, 1);
+    }
 
-    for (line = 0; line < Level.NumLines(); ++line) {
-        int x1 = Level.Vertices[Level.Lines[line].v1].x >> FRACBITS;
-        int y1 = Level.Vertices[Level.Lines[line].v1].y >> FRACBITS;
-        int x2 = Level.Vertices[Level.Lines[line].v2].x >> FRACBITS;
-        int y2 = Level.Vertices[Level.Lines[line].v2].y >> FRACBITS;
-        int dx = x2 - x1;
-        int dy = y2 - y1;
-        int bx = (x1 - minx) >> BLOCKBITS;
-        int by = (y1 - miny) >> BLOCKBITS;
-        int bx2 = (x2 - minx) >> BLOCKBITS;
-        int by2 = (y2 - miny) >> BLOCKBITS;
+    TArray<int> bands;
+    for (int i = 0; i <= numthreads; ++i) {
+        bands.Push(int((int64_t)BlockHeight * i / numthreads));
+    }
 
-        block = &BlockLists[bx + by * bmapwidth];
-        endblock = &BlockLists[bx2 + by2 * bmapwidth];
+    // Pass one counts how many lines land in each block, storing the count
+    // one slot ahead so that a prefix sum turns it into start offsets.
+    BlockStarts.Resize(numblocks + 1);
+    memset(&BlockStarts[0], 0, sizeof(unsigned int) * (numblocks + 1));
+    RunBands(bands, true);
 
-        if (block == endblock)  // Single block
-        {
-            block->Push(line);
-        } else if (by == by2)  // Horizontal line
-        {
-            if (bx > bx2) {
-                swap(block, endblock);
-            }
-            do {
-                block->Push(line);
-                block += 1;
-            } while (block <= endblock);
-        } else if (bx == bx2)  // Vertical line
-        {
-            if (by > by2) {
-                swap(block, endblock);
-            }
-            do {
-                block->Push(line);
-                block += bmapwidth;
-            } while (block <= endblock);
-        } else  // Diagonal line
-        {
-            int xchange = (dx < 0) ? -1 : 1;
-            int ychange = (dy < 0) ? -1 : 1;
-            int ymove = ychange * bmapwidth;
-            int adx = abs(dx);
-            int ady = abs(dy);
-
-            if (adx == ady)  // 45 degrees
-            {
-                int xb = (x1 - minx) & (BLOCKSIZE - 1);
-                int yb = (y1 - miny) & (BLOCKSIZE - 1);
-                if (dx < 0) {
-                    xb = BLOCKSIZE - xb;
-                }
-                if (dy < 0) {
-                    yb = BLOCKSIZE - yb;
-                }
-                if (xb < yb) adx--;
-            }
-            if (adx >= ady)  // X-major
-            {
-                int yadd = dy < 0 ? -1 : BLOCKSIZE;
-                do {
-                    int stop =
-                        (Scale((by << BLOCKBITS) + yadd - (y1 - miny), dx, dy) +
-                         (x1 - minx)) >>
-                        BLOCKBITS;
-                    while (bx != stop) {
-                        block->Push(line);
-                        block += xchange;
-                        bx += xchange;
-                    }
-                    block->Push(line);
-                    block += ymove;
-                    by += ychange;
-                } while (by != by2);
-                while (block != endblock) {
-                    block->Push(line);
-                    block += xchange;
-                }
-                block->Push(line);
-            } else  // Y-major
-            {
-                int xadd = dx < 0 ? -1 : BLOCKSIZE;
-                do {
-                    int stop =
-                        (Scale((bx << BLOCKBITS) + xadd - (x1 - minx), dy, dx) +
-                         (y1 - miny)) >>
-                        BLOCKBITS;
-                    while (by != stop) {
-                        block->Push(line);
-                        block += ymove;
-                        by += ychange;
-                    }
-                    block->Push(line);
-                    block += xchange;
-                    bx += xchange;
-                } while (bx != bx2);
-                while (block != endblock) {
-                    block->Push(line);
-                    block += ymove;
-                }
-                block->Push(line);
-            }
+    for (int i = 0; i < numblocks; ++i) {
+        BlockStarts[i + 1] += BlockStarts[i];
+    }
+
+    // Pass two drops the line numbers into their slots.
+    BlockLines.Resize(BlockStarts[numblocks]);
+    RunBands(bands, false);
+
+    BlockMap.Reserve(numblocks);
+    CreatePackedBlockmap(BlockWidth, BlockHeight);
+
+    BlockStarts.Clear();
+    BlockStarts.ShrinkToFit();
+    BlockLines.Clear();
+    BlockLines.ShrinkToFit();
+}
+
+void FBlockmapBuilder::RunBands(const TArray<int> &bands, bool counting) {
+    unsigned int numbands = bands.Size() - 1;
+
+    if (numbands == 1) {
+        RasterizeBand(bands[0], bands[1], counting);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < numbands; ++i) {
+        workers.emplace_back(&FBlockmapBuilder::RasterizeBand, this, bands[i],
+                             bands[i + 1], counting);
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+void FBlockmapBuilder::RasterizeBand(int firstrow, int lastrow, bool counting) {
+    const int lo = firstrow * BlockWidth;
+    const int hi = lastrow * BlockWidth;
+    TArray<unsigned int> fill;
+
+    if (!counting) {
+        fill.Resize(hi - lo);
+        for (int i = lo; i < hi; ++i) {
+            fill[i - lo] = BlockStarts[i];
         }
     }
 
-    BlockMap.Reserve(bmapwidth * bmapheight);
-    CreatePackedBlockmap(BlockLists, bmapwidth, bmapheight);
-    delete[] BlockLists;
+    for (WORD line = 0; line < Level.NumLines(); ++line) {
+        int by = ((Level.Vertices[Level.Lines[line].v1].y >> FRACBITS) -
+                  BlockMinY) >>
+                 BLOCKBITS;
+        int by2 = ((Level.Vertices[Level.Lines[line].v2].y >> FRACBITS) -
+                   BlockMinY) >>
+                  BLOCKBITS;
+
+        if (MAX(by, by2) < firstrow || MIN(by, by2) >= lastrow) {
+            continue;
+        }
+
+        if (counting) {
+            WalkLineBlocks(Level, line, BlockMinX, BlockMinY, BlockWidth,
+                           [&](int block) {
+                               if (block >= lo && block < hi) {
+                                   BlockStarts[block + 1]++;
+                               }
+                           });
+        } else {
+            WalkLineBlocks(Level, line, BlockMinX, BlockMinY, BlockWidth,
+                           [&](int block) {
+                               if (block >= lo && block < hi) {
+                                   BlockLines[fill[block - lo]++] = line;
+                               }
+                           });
+        }
+    }
 }
 
-void FBlockmapBuilder::CreateUnpackedBlockmap(TArray<WORD> *blocks,
-                                              int bmapwidth, int bmapheight) {
-    TArray<WORD> *block;
+void FBlockmapBuilder::CreateUnpackedBlockmap(int bmapwidth, int bmapheight) {
     WORD zero = 0;
     WORD terminator = 0xffff;
 
     for (int i = 0; i < bmapwidth * bmapheight; ++i) {
         BlockMap[4 + i] = WORD(BlockMap.Size());
         BlockMap.Push(zero);
-        block = &blocks[i];
-        for (unsigned int j = 0; j < block->Size(); ++j) {
-            BlockMap.Push((*block)[j]);
+        for (unsigned int j = BlockStarts[i]; j < BlockStarts[i + 1]; ++j) {
+            BlockMap.Push(BlockLines[j]);
         }
         BlockMap.Push(terminator);
     }
 }
 
-static unsigned int BlockHash(TArray<WORD> *block) {
-    int hash = 0;
-    WORD *ar = &(*block)[0];
-    for (size_t i = 0; i < block->Size(); ++i) {
-        hash = hash * 12235 + ar[i];
+unsigned int FBlockmapBuilder::BlockHash(int block) const {
+    unsigned int hash = 0;
+    for (unsigned int i = BlockStarts[block]; i < BlockStarts[block + 1];
+         ++i) {
+        hash = hash * 12235 + BlockLines[i];
     }
-    return hash & 0x7fffffff;
+    // Fibonacci scramble so the low bits used by the table are well mixed
+    return hash * 0x9E3779B1u;
 }
 
-static bool BlockCompare(TArray<WORD> *block1, TArray<WORD> *block2) {
-    size_t size = block1->Size();
+bool FBlockmapBuilder::BlockCompare(int block1, int block2) const {
+    unsigned int size = BlockStarts[block1 + 1] - BlockStarts[block1];
 
-    if (size != block2->Size()) {
+    if (size != BlockStarts[block2 + 1] - BlockStarts[block2]) {
         return false;
     }
     if (size == 0) {
         return true;
     }
-    WORD *ar1 = &(*block1)[0];
-    WORD *ar2 = &(*block2)[0];
-    for (size_t i = 0; i < size; ++i) {
-        if (ar1[i] != ar2[i]) {
-            return false;
-        }
-    }
-    return true;
+    return memcmp(&BlockLines[BlockStarts[block1]],
+                  &BlockLines[BlockStarts[block2]], size * sizeof(WORD)) == 0;
 }
 
-void FBlockmapBuilder::CreatePackedBlockmap(TArray<WORD> *blocks, int bmapwidth,
-                                            int bmapheight) {
-    WORD buckets[4096];
-    WORD *hashes, hashblock;
-    TArray<WORD> *block;
+void FBlockmapBuilder::CreatePackedBlockmap(int bmapwidth, int bmapheight) {
     WORD zero = 0;
     WORD terminator = 0xffff;
-    WORD *array;
-    int i, hash;
+    int numblocks = bmapwidth * bmapheight;
     int hashed = 0, nothashed = 0;
 
-    hashes = new WORD[bmapwidth * bmapheight];
+    // Open-addressed table of the first block seen with each distinct line
+    // list, kept at most half full so that probe runs stay short.
+    unsigned int tablesize = 16;
+    int tablebits = 4;
+    while (tablesize < unsigned(numblocks) * 2) {
+        tablesize <<= 1;
+        tablebits++;
+    }
+    const unsigned int mask = tablesize - 1;
+    TArray<int> table;
+    table.Resize(tablesize);
+    memset(&table[0], 0xff, sizeof(int) * tablesize);
 
-    memset(hashes, 0xff, sizeof(WORD) * bmapwidth * bmapheight);
-    memset(buckets, 0xff, sizeof(buckets));
+    for (int i = 0; i < numblocks; ++i) {
+        unsigned int slot = BlockHash(i) >> (32 - tablebits);
+        int other;
 
-    for (i = 0; i < bmapwidth * bmapheight; ++i) {
-        block = &blocks[i];
-        hash = BlockHash(block) % 4096;
-        hashblock = buckets[hash];
-        while (hashblock != 0xffff) {
-            if (BlockCompare(block, &blocks[hashblock])) {
+        while ((other = table[slot]) >= 0) {
+            if (BlockCompare(i, other)) {
                 break;
             }
-            hashblock = hashes[hashblock];
+            slot = (slot + 1) & mask;
         }
-        if (hashblock != 0xffff) {
-            BlockMap[4 + i] = BlockMap[4 + hashblock];
+        if (other >= 0) {
+            BlockMap[4 + i] = BlockMap[4 + other];
             hashed++;
         } else {
-            hashes[i] = buckets[hash];
-            buckets[hash] = WORD(i);
+            table[slot] = i;
             BlockMap[4 + i] = WORD(BlockMap.Size());
             BlockMap.Push(zero);
-            array = &(*block)[0];
-            for (size_t j = 0; j < block->Size(); ++j) {
-                BlockMap.Push(array[j]);
+            for (unsigned int j = BlockStarts[i]; j < BlockStarts[i + 1];
+                 ++j) {
+                BlockMap.Push(BlockLines[j]);
             }
             BlockMap.Push(terminator);
             nothashed++;
         }
     }
 
-    delete[] hashes;
-
     //	printf ("%d blocks written, %d blocks saved\n", nothashed, hashed);
 }
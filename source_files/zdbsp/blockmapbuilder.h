@@ -8,12 +8,25 @@ class FBlockmapBuilder {
     WORD *GetBlockmap(int &size);
 
    private:
+    // Below this many lines per thread, rasterising is cheaper than
+    // starting the threads.
+    enum { MIN_LINES_PER_THREAD = 2048 };
+
     FLevel &Level;
     TArray<WORD> BlockMap;
 
+    int BlockMinX, BlockMinY, BlockWidth, BlockHeight;
+
+    // Line lists for every block, stored back to back. The lines in block
+    // i are BlockLines[BlockStarts[i]] up to BlockLines[BlockStarts[i+1]].
+    TArray<unsigned int> BlockStarts;
+    TArray<WORD> BlockLines;
+
     void BuildBlockmap();
-    void CreateUnpackedBlockmap(TArray<WORD> *blocks, int bmapwidth,
-                                int bmapheight);
-    void CreatePackedBlockmap(TArray<WORD> *blocks, int bmapwidth,
-                              int bmapheight);
+    void RunBands(const TArray<int> &bands, bool counting);
+    void RasterizeBand(int firstrow, int lastrow, bool counting);
+    unsigned int BlockHash(int block) const;
+    bool BlockCompare(int block1, int block2) const;
+    void CreateUnpackedBlockmap(int bmapwidth, int bmapheight);
+    void CreatePackedBlockmap(int bmapwidth, int bmapheight);
 };
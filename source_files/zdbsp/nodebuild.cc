@@ -42,9 +42,10 @@
 #endif
 
 FNodeBuilder::FNodeBuilder(FLevel &level, TArray<FPolyStart> &polyspots,
-                           TArray<FPolyStart> &anchors, const char *name,
-                           bool makeGLnodes)
-    : Level(level), SegsStuffed(0), MapName(name) {
+                           TArray<FPolyStart> &anchors,
+                           const TArray<FPartitionHint> &hints,
+                           const char *name, bool makeGLnodes)
+    : Hints(hints), Level(level), SegsStuffed(0), MapName(name) {
     VertexMap =
         new FVertexMap(*this, Level.MinX, Level.MinY, Level.MaxX, Level.MaxY);
     GLNodes = makeGLnodes;
@@ -82,7 +83,11 @@ DWORD FNodeBuilder::CreateNode(DWORD set, unsigned int count, fixed_t bbox[4]) {
     // count, so an estimate is fine.
     skip = int(count / MaxSegs);
 
-    if ((selstat = SelectSplitter(set, node, splitseg, skip, true)) > 0 ||
+    // Partition hints only pay off near the top of the tree. Small sets go
+    // straight to the full search, which finds tighter splits there.
+    if ((count >= unsigned(MaxSegs) * 8 &&
+         SelectHintSplitter(set, node, splitseg)) ||
+        (selstat = SelectSplitter(set, node, splitseg, skip, true)) > 0 ||
         (skip > 0 &&
          (selstat = SelectSplitter(set, node, splitseg, 1, true)) > 0) ||
         (selstat < 0 &&
@@ -452,6 +457,111 @@ int FNodeBuilder::SelectSplitter(DWORD set, node_t &node, DWORD &splitseg,
     return 1;
 }
 
+// When partition hints are available, try them before searching the segs.
+// The hints that cut through the set's bounding box are ranked by how
+// evenly they divide it (the size of the smaller piece), so the longer
+// dimension gets split first, just like the level generator does it. The
+// best few are scored with the normal heuristic and the winner is used if
+// it is acceptable. Once a set fits inside a single hint cell no hint can
+// cut it any more, and the regular splitter search takes over.
+
+bool FNodeBuilder::SelectHintSplitter(DWORD set, node_t &node,
+                                      DWORD &splitseg) {
+    enum { MAX_HINT_TRIES = 3 };
+    const fixed_t FRACUNIT = 1 << FRACBITS;
+
+    if (Hints.Size() == 0) {
+        return false;
+    }
+
+    fixed_t bbox[4];
+    bbox[BOXTOP] = bbox[BOXRIGHT] = INT_MIN;
+    bbox[BOXBOTTOM] = bbox[BOXLEFT] = INT_MAX;
+
+    for (DWORD seg = set; seg != DWORD_MAX; seg = Segs[seg].next) {
+        AddSegToBBox(bbox, &Segs[seg]);
+    }
+
+    // Keep the splitter on whole map units so it survives being written
+    // out to the short-sized vanilla NODES lump.
+    fixed_t left = bbox[BOXLEFT] & ~(FRACUNIT - 1);
+    fixed_t bottom = bbox[BOXBOTTOM] & ~(FRACUNIT - 1);
+    fixed_t width =
+        MAX(((bbox[BOXRIGHT] + FRACUNIT - 1) & ~(FRACUNIT - 1)) - left,
+            FRACUNIT);
+    fixed_t height =
+        MAX(((bbox[BOXTOP] + FRACUNIT - 1) & ~(FRACUNIT - 1)) - bottom,
+            FRACUNIT);
+
+    int best[MAX_HINT_TRIES];
+    fixed_t bestpiece[MAX_HINT_TRIES];
+    int numbest = 0;
+
+    for (unsigned int i = 0; i < Hints.Size(); ++i) {
+        const FPartitionHint &hint = Hints[i];
+        fixed_t lo = hint.vertical ? bbox[BOXLEFT] : bbox[BOXBOTTOM];
+        fixed_t hi = hint.vertical ? bbox[BOXRIGHT] : bbox[BOXTOP];
+
+        // A hint must have part of the set on both sides of it
+        if (hint.pos - lo < FRACUNIT || hi - hint.pos < FRACUNIT) {
+            continue;
+        }
+
+        fixed_t piece = MIN(hint.pos - lo, hi - hint.pos);
+        int j = numbest;
+
+        while (j > 0 && bestpiece[j - 1] < piece) {
+            if (j < MAX_HINT_TRIES) {
+                best[j] = best[j - 1];
+                bestpiece[j] = bestpiece[j - 1];
+            }
+            j--;
+        }
+        if (j < MAX_HINT_TRIES) {
+            best[j] = i;
+            bestpiece[j] = piece;
+            numbest = MIN(numbest + 1, int(MAX_HINT_TRIES));
+        }
+    }
+
+    int bestvalue = 0;
+    node_t bestnode;
+
+    for (int j = 0; j < numbest; ++j) {
+        const FPartitionHint &hint = Hints[best[j]];
+
+        if (hint.vertical) {
+            node.x = hint.pos;
+            node.y = bottom;
+            node.dx = 0;
+            node.dy = height;
+        } else {
+            node.x = left;
+            node.y = hint.pos;
+            node.dx = width;
+            node.dy = 0;
+        }
+
+        int value = Heuristic(node, set, true);
+
+        D(Printf("Hint %c=%d scores %d\n", hint.vertical ? 'x' : 'y',
+                 hint.pos >> 16, value));
+
+        if (value > bestvalue) {
+            bestvalue = value;
+            bestnode = node;
+        }
+    }
+
+    if (bestvalue <= 0) {
+        return false;
+    }
+
+    node = bestnode;
+    splitseg = DWORD_MAX;
+    return true;
+}
+
 // Given a splitter (node), returns a score based on how "good" the resulting
 // split in a set of segs is. Higher scores are better. -1 means this splitter
 // splits something it shouldn't and will only be returned if honorNoSplit is
@@ -152,8 +152,16 @@ class FNodeBuilder {
         fixed_t x, y;
     };
 
+    // An axis-aligned line that is known to be a good place to split the
+    // map, such as a boundary of the generator's seed grid.
+    struct FPartitionHint {
+        fixed_t pos;
+        bool vertical;  // true: x = pos, false: y = pos
+    };
+
     FNodeBuilder(FLevel &level, TArray<FPolyStart> &polyspots,
-                 TArray<FPolyStart> &anchors, const char *name,
+                 TArray<FPolyStart> &anchors,
+                 const TArray<FPartitionHint> &hints, const char *name,
                  bool makeGLnodes);
     ~FNodeBuilder();
 
@@ -181,6 +189,7 @@ class FNodeBuilder {
     TArray<USegPtr> SegList;
     TArray<BYTE> PlaneChecked;
     TArray<FSimpleLine> Planes;
+    TArray<FPartitionHint> Hints;
     size_t InitialVertices;  // Number of vertices in a map that are connected
                              // to linedefs
 
@@ -218,6 +227,7 @@ class FNodeBuilder {
     bool ShoveSegBehind(DWORD set, node_t &node, DWORD seg, DWORD mate);
     int SelectSplitter(DWORD set, node_t &node, DWORD &splitseg, int step,
                        bool nosplit);
+    bool SelectHintSplitter(DWORD set, node_t &node, DWORD &splitseg);
     void SplitSegs(DWORD set, node_t &node, DWORD splitseg, DWORD &outset0,
                    DWORD &outset1, unsigned int &count0, unsigned int &count1);
     DWORD SplitSeg(DWORD segnum, int splitvert, int v1InFront);
@@ -0,0 +1,274 @@
+/*
+    Content-addressed cache of built maps.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#include "nodecache.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "processor.h"
+#include "zdbsp.h"
+
+static const uint64_t FNV_OFFSET = 0xcbf29ce484222325ULL;
+static const uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+static uint64_t HashBytes(uint64_t hash, const void *data, size_t len) {
+    const BYTE *p = (const BYTE *)data;
+
+    for (size_t i = 0; i < len; ++i) {
+        hash = (hash ^ p[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+FNodeCache::FNodeCache(std::filesystem::path dir, uintmax_t maxsize)
+    : Dir(dir), MaxSize(maxsize) {
+    if (Dir.empty()) {
+        return;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(Dir, ec);
+    if (ec) {
+        // Carry on without a cache rather than failing the build
+        Dir.clear();
+    }
+}
+
+//==========================================================================
+//
+// MakeKey
+//
+// Hashes the name and contents of every lump belonging to the map,
+// label included, plus every setting that changes what FProcessor
+// writes. Hashing the whole map rather than just the geometry lumps
+// keeps BEHAVIOR, SCRIPTS and an existing REJECT (which ERM_DontTouch
+// passes through) from going stale.
+//
+//==========================================================================
+
+uint64_t FNodeCache::MakeKey(FWadReader &wad, int lump) {
+    char settings[256];
+    uint64_t hash = FNV_OFFSET;
+
+    snprintf(settings, sizeof(settings),
+             "ZDBSP " ZDBSP_VERSION " %d%d%d%d%d %d %d %d %d %d %d %d%d%d%d%d%d",
+             BuildNodes, BuildGLNodes, GLOnly, ConformNodes, NoPrune,
+             BlockmapMode, RejectMode, MaxSegs, SplitCost, AAPreference,
+             PartitionHintGrid, CheckPolyobjs, CompressNodes, CompressGLNodes,
+             ForceCompression, V5GLNodes, WriteComments);
+    hash = HashBytes(hash, settings, strlen(settings));
+
+    int end = wad.LumpAfterMap(lump);
+
+    for (int i = lump; i < end; ++i) {
+        BYTE *data;
+        int size;
+
+        hash = HashBytes(hash, wad.LumpName(i), 8);
+        ReadLump<BYTE>(wad, i, data, size);
+        hash = HashBytes(hash, &size, sizeof(size));
+        hash = HashBytes(hash, data, size);
+        delete[] data;
+    }
+    return hash;
+}
+
+std::filesystem::path FNodeCache::EntryPath(uint64_t key) const {
+    char name[24];
+
+    snprintf(name, sizeof(name), "%016llx.wad", (unsigned long long)key);
+    return Dir / name;
+}
+
+//==========================================================================
+//
+// Fetch
+//
+//==========================================================================
+
+bool FNodeCache::Fetch(uint64_t key, FWadWriter &out) {
+    if (!IsEnabled()) {
+        return false;
+    }
+
+    std::filesystem::path entry = EntryPath(key);
+    std::error_code ec;
+
+    if (!std::filesystem::exists(entry, ec) || !CopyEntry(entry, out)) {
+        return false;
+    }
+
+    // Bump the entry to the front of the LRU order
+    std::filesystem::last_write_time(
+        entry, std::filesystem::file_time_type::clock::now(), ec);
+    return true;
+}
+
+//==========================================================================
+//
+// Store
+//
+//==========================================================================
+
+bool FNodeCache::Store(uint64_t key, FProcessor &builder, FWadWriter &out) {
+    if (!IsEnabled()) {
+        return false;
+    }
+
+    std::filesystem::path entry = EntryPath(key);
+    std::filesystem::path temp = entry;
+    std::error_code ec;
+
+    temp += ".tmp";
+
+    std::unique_ptr<FWadWriter> cachewad;
+    try {
+        cachewad.reset(new FWadWriter(temp, false));
+    } catch (std::runtime_error &) {
+        // Couldn't create the entry; the caller writes directly instead
+        return false;
+    }
+    try {
+        builder.Write(*cachewad);
+        cachewad->Close();
+    } catch (...) {
+        cachewad.reset();
+        std::filesystem::remove(temp, ec);
+        throw;
+    }
+    cachewad.reset();
+
+    // If the rename fails the entry just isn't kept; the map itself
+    // still comes out of the temporary file.
+    std::filesystem::rename(temp, entry, ec);
+    if (ec) {
+        bool copied = CopyEntry(temp, out);
+        std::filesystem::remove(temp, ec);
+        if (!copied) {
+            throw std::runtime_error("Failed to read back cached map");
+        }
+        return true;
+    }
+
+    if (!CopyEntry(entry, out)) {
+        throw std::runtime_error("Failed to read back cached map");
+    }
+    Trim();
+    return true;
+}
+
+//==========================================================================
+//
+// CopyEntry
+//
+// Everything is read before anything is written, so a damaged entry
+// leaves out untouched and the map can still be built normally.
+//
+//==========================================================================
+
+bool FNodeCache::CopyEntry(const std::filesystem::path &entry,
+                           FWadWriter &out) {
+    struct Lump {
+        char name[9];
+        BYTE *data;
+        int size;
+    };
+    std::vector<Lump> lumps;
+    bool ok = true;
+
+    try {
+        FWadReader wad(entry);
+        int max = wad.NumLumps();
+
+        for (int i = 0; i < max; ++i) {
+            Lump lump;
+            memcpy(lump.name, wad.LumpName(i), sizeof(lump.name));
+            ReadLump<BYTE>(wad, i, lump.data, lump.size);
+            lumps.push_back(lump);
+        }
+        wad.Close();
+    } catch (std::runtime_error &) {
+        ok = false;
+    }
+
+    for (const Lump &lump : lumps) {
+        if (ok) {
+            out.WriteLump(lump.name, lump.data, lump.size);
+        }
+        delete[] lump.data;
+    }
+    return ok;
+}
+
+//==========================================================================
+//
+// Trim
+//
+// Drops the least recently used entries until the cache fits in
+// MaxSize again.
+//
+//==========================================================================
+
+void FNodeCache::Trim() {
+    struct Entry {
+        std::filesystem::path path;
+        std::filesystem::file_time_type time;
+        uintmax_t size;
+    };
+    std::vector<Entry> entries;
+    uintmax_t total = 0;
+    std::error_code ec;
+
+    for (std::filesystem::directory_iterator it(Dir, ec), end;
+         !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() != ".wad") {
+            continue;
+        }
+        Entry e;
+        e.path = it->path();
+        e.time = it->last_write_time(ec);
+        e.size = it->file_size(ec);
+        if (ec) {
+            ec.clear();
+            continue;
+        }
+        total += e.size;
+        entries.push_back(e);
+    }
+
+    if (total <= MaxSize) {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry &a, const Entry &b) { return a.time < b.time; });
+
+    for (const Entry &e : entries) {
+        if (total <= MaxSize) {
+            break;
+        }
+        if (std::filesystem::remove(e.path, ec)) {
+            total -= e.size;
+        }
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef __NODECACHE_H__
+#define __NODECACHE_H__
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#include <filesystem>
+
+#include "zdwad.h"
+
+class FProcessor;
+
+// Content-addressed store of finished maps. Each entry is a small wad
+// holding every lump FProcessor wrote for one map, named after a hash
+// of the map's input lumps and the builder settings that affect the
+// output. Entries are evicted least-recently-used first once the cache
+// grows past its size limit.
+class FNodeCache {
+   public:
+    // An empty directory disables the cache.
+    FNodeCache(std::filesystem::path dir, uintmax_t maxsize);
+
+    bool IsEnabled() const { return !Dir.empty(); }
+
+    uint64_t MakeKey(FWadReader &wad, int lump);
+
+    // Copies a cached map into out; returns false on a miss.
+    bool Fetch(uint64_t key, FWadWriter &out);
+
+    // Writes the builder's output into the cache and from there into
+    // out. Returns false, with nothing written to out, if the cache
+    // entry could not be created.
+    bool Store(uint64_t key, FProcessor &builder, FWadWriter &out);
+
+   private:
+    std::filesystem::path EntryPath(uint64_t key) const;
+    bool CopyEntry(const std::filesystem::path &entry, FWadWriter &out);
+    void Trim();
+
+    std::filesystem::path Dir;
+    uintmax_t MaxSize;
+};
+
+#endif  //__NODECACHE_H__
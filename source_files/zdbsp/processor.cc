@@ -84,6 +84,10 @@ FProcessor::FProcessor(FWadReader &inwad, int lump) : Wad(inwad), Lump(lump) {
         }
 
         Level.FindMapBounds();
+
+        if (BuildNodes) {
+            GetPartitionHints();
+        }
     }
 }
 
@@ -442,6 +446,41 @@ void FProcessor::GetPolySpots() {
     }
 }
 
+// Turns the hint grid into one partition hint per grid line that crosses
+// the map. Grid lines sit on multiples of PartitionHintGrid, which is how
+// the level generator lays out its chunks.
+
+void FProcessor::GetPartitionHints() {
+    if (PartitionHintGrid <= 0) {
+        return;
+    }
+
+    int minx = Level.MinX >> FRACBITS;
+    int miny = Level.MinY >> FRACBITS;
+    int maxx = Level.MaxX >> FRACBITS;
+    int maxy = Level.MaxY >> FRACBITS;
+
+    FNodeBuilder::FPartitionHint hint;
+
+    hint.vertical = true;
+    for (int x = (minx / PartitionHintGrid) * PartitionHintGrid; x <= maxx;
+         x += PartitionHintGrid) {
+        if (x > minx) {
+            hint.pos = x << FRACBITS;
+            PartitionHints.Push(hint);
+        }
+    }
+
+    hint.vertical = false;
+    for (int y = (miny / PartitionHintGrid) * PartitionHintGrid; y <= maxy;
+         y += PartitionHintGrid) {
+        if (y > miny) {
+            hint.pos = y << FRACBITS;
+            PartitionHints.Push(hint);
+        }
+    }
+}
+
 void FProcessor::Write(FWadWriter &out) {
     if (Level.NumLines() == 0 || Level.NumSides() == 0 ||
         Level.NumSectors() == 0 || Level.NumVertices == 0) {
@@ -503,7 +542,8 @@ void FProcessor::Write(FWadWriter &out) {
 
         try {
             builder = new FNodeBuilder(Level, PolyStarts, PolyAnchors,
-                                       Wad.LumpName(Lump), BuildGLNodes);
+                                       PartitionHints, Wad.LumpName(Lump),
+                                       BuildGLNodes);
             if (builder == NULL) {
                 throw std::runtime_error(
                     "   Not enough memory to build nodes!");
@@ -538,6 +578,7 @@ void FProcessor::Write(FWadWriter &out) {
                         delete builder;
                         builder =
                             new FNodeBuilder(Level, PolyStarts, PolyAnchors,
+                                             PartitionHints,
                                              Wad.LumpName(Lump), false);
                         if (builder == NULL) {
                             throw std::runtime_error(
@@ -15,6 +15,11 @@
 #include "zdwad.h"
 #include "miniz.h"
 
+#include <memory>
+
+class FUDMFScanner;
+class udmf_writer_c;
+
 class ZLibOut {
    public:
     ZLibOut(FWadWriter &out);
@@ -50,6 +55,7 @@ class FProcessor {
     void LoadSides();
     void LoadSectors();
     void GetPolySpots();
+    void GetPartitionHints();
 
     MapNodeEx *NodesToEx(const MapNode *nodes, int count);
     MapSubsectorEx *SubsectorsToEx(const MapSubsector *ssec, int count);
@@ -109,23 +115,23 @@ class FProcessor {
     void WriteSSectors5(FWadWriter &out, const char *name,
                         const MapSubsectorEx *zaSubs, int count) const;
 
-    const char *ParseKey(const char *&value);
-    bool CheckKey(const char *&key, const char *&value);
-    void ParseThing(IntThing *th);
-    void ParseLinedef(IntLineDef *ld);
-    void ParseSidedef(IntSideDef *sd);
-    void ParseSector(IntSector *sec);
-    void ParseVertex(WideVertex *vt, IntVertex *vtp);
-    void ParseMapProperties();
+    int ParseKey(FUDMFScanner &sc, UDMFKey &prop);
+    bool CheckKey(FUDMFScanner &sc);
+    void ParseThing(FUDMFScanner &sc, IntThing *th);
+    void ParseLinedef(FUDMFScanner &sc, IntLineDef *ld);
+    void ParseSidedef(FUDMFScanner &sc, IntSideDef *sd);
+    void ParseSector(FUDMFScanner &sc, IntSector *sec);
+    void ParseVertex(FUDMFScanner &sc, WideVertex *vt, IntVertex *vtp);
+    void ParseMapProperties(FUDMFScanner &sc);
     void ParseTextMap(int lump);
 
-    void WriteProps(FWadWriter &out, TArray<UDMFKey> &props);
-    void WriteIntProp(FWadWriter &out, const char *key, int value);
-    void WriteThingUDMF(FWadWriter &out, IntThing *th, int num);
-    void WriteLinedefUDMF(FWadWriter &out, IntLineDef *ld, int num);
-    void WriteSidedefUDMF(FWadWriter &out, IntSideDef *sd, int num);
-    void WriteSectorUDMF(FWadWriter &out, IntSector *sec, int num);
-    void WriteVertexUDMF(FWadWriter &out, IntVertex *vt, int num);
+    void WriteProps(udmf_writer_c &out, TArray<UDMFKey> &props);
+    void BeginUDMFBlock(udmf_writer_c &out, const char *kind, int num);
+    void WriteThingUDMF(udmf_writer_c &out, IntThing *th, int num);
+    void WriteLinedefUDMF(udmf_writer_c &out, IntLineDef *ld, int num);
+    void WriteSidedefUDMF(udmf_writer_c &out, IntSideDef *sd, int num);
+    void WriteSectorUDMF(udmf_writer_c &out, IntSector *sec, int num);
+    void WriteVertexUDMF(udmf_writer_c &out, IntVertex *vt, int num);
     void WriteTextMap(FWadWriter &out);
     void WriteUDMF(FWadWriter &out);
 
@@ -133,10 +139,15 @@ class FProcessor {
 
     TArray<FNodeBuilder::FPolyStart> PolyStarts;
     TArray<FNodeBuilder::FPolyStart> PolyAnchors;
+    TArray<FNodeBuilder::FPartitionHint> PartitionHints;
 
     bool Extended;
     bool isUDMF;
 
+    // UDMF property strings point into this
+    std::unique_ptr<char[]> TextMap;
+    int TextMapSize;
+
     FWadReader &Wad;
     int Lump;
 };
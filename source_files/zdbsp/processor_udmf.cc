@@ -18,97 +18,129 @@
 
 */
 
-#include <float.h>
-
 #include "processor.h"
-#include "sc_man.h"
+#include "udmf_scanner.h"
+
+#include "lib_udmf.h"
 
 typedef double real64;
 typedef unsigned int uint32;
 typedef signed int int32;
 #include "xs_Float.h"
 
-class StringBuffer {
-    const static size_t BLOCK_SIZE = 100000;
-    const static size_t BLOCK_ALIGN = sizeof(size_t);
-
-    TDeletingArray<char *> blocks;
-    size_t currentindex;
-
-    char *Alloc(size_t size) {
-        if (currentindex + size >= BLOCK_SIZE) {
-            // Block is full - get a new one!
-            char *newblock = new char[BLOCK_SIZE];
-            blocks.Push(newblock);
-            currentindex = 0;
-        }
-        size = (size + BLOCK_ALIGN - 1) & ~(BLOCK_ALIGN - 1);
-        char *p = blocks[blocks.Size() - 1] + currentindex;
-        currentindex += size;
-        return p;
-    }
-
-   public:
-    StringBuffer() { currentindex = BLOCK_SIZE; }
-
-    char *Copy(const char *p) {
-        return p != NULL ? strcpy(Alloc(strlen(p) + 1), p) : NULL;
-    }
+// The keys and block names the node builder looks at. Everything else
+// is passed through untouched.
+enum EUDMFKey {
+    UDMF_Unknown,
+    UDMF_X,
+    UDMF_Y,
+    UDMF_V1,
+    UDMF_V2,
+    UDMF_Type,
+    UDMF_Arg0,
+    UDMF_Angle,
+    UDMF_Thing,
+    UDMF_Sector,
+    UDMF_Vertex,
+    UDMF_Special,
+    UDMF_Linedef,
+    UDMF_Sidedef,
+    UDMF_SideBack,
+    UDMF_SideFront,
+    UDMF_Namespace
 };
 
-StringBuffer stbuf;
+//===========================================================================
+//
+// Identifies a key or block name. The length alone narrows every name
+// down to at most two candidates, so at most two compares are needed.
+//
+//===========================================================================
+
+static EUDMFKey MatchKey(std::string_view name) {
+    switch (name.size()) {
+        case 1:
+            switch (name[0]) {
+                case 'x':
+                case 'X':
+                    return UDMF_X;
+                case 'y':
+                case 'Y':
+                    return UDMF_Y;
+            }
+            break;
+        case 2:
+            if (name[0] == 'v' || name[0] == 'V') {
+                if (name[1] == '1') return UDMF_V1;
+                if (name[1] == '2') return UDMF_V2;
+            }
+            break;
+        case 4:
+            if (FUDMFScanner::Compare(name, "type")) return UDMF_Type;
+            if (FUDMFScanner::Compare(name, "arg0")) return UDMF_Arg0;
+            break;
+        case 5:
+            if (FUDMFScanner::Compare(name, "angle")) return UDMF_Angle;
+            if (FUDMFScanner::Compare(name, "thing")) return UDMF_Thing;
+            break;
+        case 6:
+            if (FUDMFScanner::Compare(name, "sector")) return UDMF_Sector;
+            if (FUDMFScanner::Compare(name, "vertex")) return UDMF_Vertex;
+            break;
+        case 7:
+            if (FUDMFScanner::Compare(name, "special")) return UDMF_Special;
+            if (FUDMFScanner::Compare(name, "linedef")) return UDMF_Linedef;
+            if (FUDMFScanner::Compare(name, "sidedef")) return UDMF_Sidedef;
+            break;
+        case 8:
+            if (FUDMFScanner::Compare(name, "sideback")) return UDMF_SideBack;
+            break;
+        case 9:
+            if (FUDMFScanner::Compare(name, "sidefront")) return UDMF_SideFront;
+            if (FUDMFScanner::Compare(name, "namespace")) return UDMF_Namespace;
+            break;
+    }
+    return UDMF_Unknown;
+}
 
 //===========================================================================
 //
 // Parses a 'key = value;' line of the map
 //
+// Both strings are left in the TEXTMAP buffer. For the keys MatchKey
+// knows, the value's number is left in the scanner.
+//
 //===========================================================================
 
-const char *FProcessor::ParseKey(const char *&value) {
-    SC_MustGetString();
-    const char *key = stbuf.Copy(sc_String);
-    SC_MustGetStringName("=");
+int FProcessor::ParseKey(FUDMFScanner &sc, UDMFKey &prop) {
+    std::string_view key = sc.MustGetToken();
+    sc.MustGetToken('=');
+    std::string_view value = sc.MustGetToken();
+    sc.MustGetToken(';');
 
-    sc_Number = INT_MIN;
-    sc_Float = DBL_MIN;
-    if (!SC_CheckFloat()) {
-        SC_MustGetString();
+    // Only the keys we look at need their values converted
+    // (the namespace is a string)
+    EUDMFKey id = MatchKey(key);
+    if (id != UDMF_Unknown && id != UDMF_Namespace) {
+        sc.ParseNumber(value);
     }
-    value = stbuf.Copy(sc_String);
-    SC_MustGetStringName(";");
-    return key;
+    prop.key = sc.Terminate(key);
+    prop.value = sc.Terminate(value);
+    return id;
 }
 
-bool FProcessor::CheckKey(const char *&key, const char *&value) {
-    SC_SavePos();
-    SC_MustGetString();
-    if (SC_CheckString("=")) {
-        SC_RestorePos();
-        key = ParseKey(value);
-        return true;
-    }
-    SC_RestorePos();
-    return false;
-}
-
-int CheckInt(const char *key) {
-    if (sc_Number == INT_MIN) {
-        SC_ScriptError("Integer value expected for key '%s'", key);
-    }
-    return sc_Number;
-}
-
-double CheckFloat(const char *key) {
-    if (sc_Float == DBL_MIN) {
-        SC_ScriptError("Floating point value expected for key '%s'", key);
-    }
-    return sc_Float;
+bool FProcessor::CheckKey(FUDMFScanner &sc) {
+    FUDMFScanner::FPos pos = sc.SavePos();
+    sc.MustGetToken();
+    bool iskey = sc.CheckToken('=');
+    sc.RestorePos(pos);
+    return iskey;
 }
 
-fixed_t CheckFixed(const char *key) {
-    double val = CheckFloat(key);
+static fixed_t CheckFixed(FUDMFScanner &sc, const char *key) {
+    double val = sc.Float;
     if (val < -32768 || val > 32767) {
-        SC_ScriptError(
+        sc.ScriptError(
             "Fixed point value is out of range for key '%s'\n\t%.2f should be "
             "within [-32768,32767]",
             key, val / 65536);
@@ -122,29 +154,33 @@ fixed_t CheckFixed(const char *key) {
 //
 //===========================================================================
 
-void FProcessor::ParseThing(IntThing *th) {
-    SC_MustGetStringName("{");
-    while (!SC_CheckString("}")) {
-        const char *value;
-        const char *key = ParseKey(value);
+void FProcessor::ParseThing(FUDMFScanner &sc, IntThing *th) {
+    sc.MustGetToken('{');
+    // keys which are left out take the UDMF defaults
+    th->x = th->y = 0;
+    th->angle = th->type = 0;
+    while (!sc.CheckToken('}')) {
+        UDMFKey k;
 
         // The only properties we need from a thing are
         // x, y, angle and type.
 
-        if (!strcasecmp(key, "x")) {
-            th->x = CheckFixed(key);
-        } else if (!strcasecmp(key, "y")) {
-            th->y = CheckFixed(key);
-        }
-        if (!strcasecmp(key, "angle")) {
-            th->angle = (short)CheckInt(key);
-        }
-        if (!strcasecmp(key, "type")) {
-            th->type = (short)CheckInt(key);
+        switch (ParseKey(sc, k)) {
+            case UDMF_X:
+                th->x = CheckFixed(sc, k.key);
+                break;
+            case UDMF_Y:
+                th->y = CheckFixed(sc, k.key);
+                break;
+            case UDMF_Angle:
+                th->angle = (short)sc.Number;
+                break;
+            case UDMF_Type:
+                th->type = (short)sc.Number;
+                break;
         }
 
         // now store the key in its unprocessed form
-        UDMFKey k = {key, value};
         th->props.Push(k);
     }
 }
@@ -155,35 +191,35 @@ void FProcessor::ParseThing(IntThing *th) {
 //
 //===========================================================================
 
-void FProcessor::ParseLinedef(IntLineDef *ld) {
-    SC_MustGetStringName("{");
+void FProcessor::ParseLinedef(FUDMFScanner &sc, IntLineDef *ld) {
+    sc.MustGetToken('{');
     ld->v1 = ld->v2 = ld->sidenum[0] = ld->sidenum[1] = NO_INDEX;
     ld->special = 0;
-    while (!SC_CheckString("}")) {
-        const char *value;
-        const char *key = ParseKey(value);
-
-        if (!strcasecmp(key, "v1")) {
-            ld->v1 = CheckInt(key);
-            continue;  // do not store in props
-        } else if (!strcasecmp(key, "v2")) {
-            ld->v2 = CheckInt(key);
-            continue;  // do not store in props
-        } else if (Extended && !strcasecmp(key, "special")) {
-            ld->special = CheckInt(key);
-        } else if (Extended && !strcasecmp(key, "arg0")) {
-            ld->args[0] = CheckInt(key);
-        }
-        if (!strcasecmp(key, "sidefront")) {
-            ld->sidenum[0] = CheckInt(key);
-            continue;  // do not store in props
-        } else if (!strcasecmp(key, "sideback")) {
-            ld->sidenum[1] = CheckInt(key);
-            continue;  // do not store in props
+    while (!sc.CheckToken('}')) {
+        UDMFKey k;
+
+        switch (ParseKey(sc, k)) {
+            case UDMF_V1:
+                ld->v1 = sc.Number;
+                continue;  // do not store in props
+            case UDMF_V2:
+                ld->v2 = sc.Number;
+                continue;  // do not store in props
+            case UDMF_SideFront:
+                ld->sidenum[0] = sc.Number;
+                continue;  // do not store in props
+            case UDMF_SideBack:
+                ld->sidenum[1] = sc.Number;
+                continue;  // do not store in props
+            case UDMF_Special:
+                if (Extended) ld->special = sc.Number;
+                break;
+            case UDMF_Arg0:
+                if (Extended) ld->args[0] = sc.Number;
+                break;
         }
 
         // now store the key in its unprocessed form
-        UDMFKey k = {key, value};
         ld->props.Push(k);
     }
 }
@@ -194,20 +230,18 @@ void FProcessor::ParseLinedef(IntLineDef *ld) {
 //
 //===========================================================================
 
-void FProcessor::ParseSidedef(IntSideDef *sd) {
-    SC_MustGetStringName("{");
+void FProcessor::ParseSidedef(FUDMFScanner &sc, IntSideDef *sd) {
+    sc.MustGetToken('{');
     sd->sector = NO_INDEX;
-    while (!SC_CheckString("}")) {
-        const char *value;
-        const char *key = ParseKey(value);
+    while (!sc.CheckToken('}')) {
+        UDMFKey k;
 
-        if (!strcasecmp(key, "sector")) {
-            sd->sector = CheckInt(key);
+        if (ParseKey(sc, k) == UDMF_Sector) {
+            sd->sector = sc.Number;
             continue;  // do not store in props
         }
 
         // now store the key in its unprocessed form
-        UDMFKey k = {key, value};
         sd->props.Push(k);
     }
 }
@@ -218,17 +252,16 @@ void FProcessor::ParseSidedef(IntSideDef *sd) {
 //
 //===========================================================================
 
-void FProcessor::ParseSector(IntSector *sec) {
-    SC_MustGetStringName("{");
-    while (!SC_CheckString("}")) {
-        const char *value;
-        const char *key = ParseKey(value);
+void FProcessor::ParseSector(FUDMFScanner &sc, IntSector *sec) {
+    sc.MustGetToken('{');
+    while (!sc.CheckToken('}')) {
+        UDMFKey k;
+        ParseKey(sc, k);
 
         // No specific sector properties are ever used by the node builder
         // so everything can go directly to the props array.
 
         // now store the key in its unprocessed form
-        UDMFKey k = {key, value};
         sec->props.Push(k);
     }
 }
@@ -239,21 +272,23 @@ void FProcessor::ParseSector(IntSector *sec) {
 //
 //===========================================================================
 
-void FProcessor::ParseVertex(WideVertex *vt, IntVertex *vtp) {
+void FProcessor::ParseVertex(FUDMFScanner &sc, WideVertex *vt,
+                             IntVertex *vtp) {
     vt->x = vt->y = 0;
-    SC_MustGetStringName("{");
-    while (!SC_CheckString("}")) {
-        const char *value;
-        const char *key = ParseKey(value);
-
-        if (!strcasecmp(key, "x")) {
-            vt->x = CheckFixed(key);
-        } else if (!strcasecmp(key, "y")) {
-            vt->y = CheckFixed(key);
+    sc.MustGetToken('{');
+    while (!sc.CheckToken('}')) {
+        UDMFKey k;
+
+        switch (ParseKey(sc, k)) {
+            case UDMF_X:
+                vt->x = CheckFixed(sc, k.key);
+                break;
+            case UDMF_Y:
+                vt->y = CheckFixed(sc, k.key);
+                break;
         }
 
         // now store the key in its unprocessed form
-        UDMFKey k = {key, value};
         vtp->props.Push(k);
     }
 }
@@ -264,21 +299,20 @@ void FProcessor::ParseVertex(WideVertex *vt, IntVertex *vtp) {
 //
 //===========================================================================
 
-void FProcessor::ParseMapProperties() {
-    const char *key, *value;
-
+void FProcessor::ParseMapProperties(FUDMFScanner &sc) {
     // all global keys must come before the first map element.
 
-    while (CheckKey(key, value)) {
-        if (!strcasecmp(key, "namespace")) {
+    while (CheckKey(sc)) {
+        UDMFKey k;
+
+        if (ParseKey(sc, k) == UDMF_Namespace) {
             // all unknown namespaces are assumed to be standard.
-            Extended = !strcasecmp(value, "\"ZDoom\"") ||
-                       !strcasecmp(value, "\"Hexen\"") ||
-                       !strcasecmp(value, "\"Vavoom\"");
+            Extended = !strcasecmp(k.value, "\"ZDoom\"") ||
+                       !strcasecmp(k.value, "\"Hexen\"") ||
+                       !strcasecmp(k.value, "\"Vavoom\"");
         }
 
         // now store the key in its unprocessed form
-        UDMFKey k = {key, value};
         Level.props.Push(k);
     }
 }
@@ -287,6 +321,9 @@ void FProcessor::ParseMapProperties() {
 //
 // Main parsing function
 //
+// The lump stays loaded for the life of the processor, since every
+// property string points into it.
+//
 //===========================================================================
 
 void FProcessor::ParseTextMap(int lump) {
@@ -295,36 +332,51 @@ void FProcessor::ParseTextMap(int lump) {
     TArray<WideVertex> Vertices;
 
     ReadLump<char>(Wad, lump, buffer, buffersize);
-    SC_OpenMem("TEXTMAP", buffer, buffersize);
-
-    SC_SetCMode(true);
-    ParseMapProperties();
-
-    while (SC_GetString()) {
-        if (SC_Compare("thing")) {
-            IntThing *th = &Level.Things[Level.Things.Reserve(1)];
-            ParseThing(th);
-        } else if (SC_Compare("linedef")) {
-            IntLineDef *ld = &Level.Lines[Level.Lines.Reserve(1)];
-            ParseLinedef(ld);
-        } else if (SC_Compare("sidedef")) {
-            IntSideDef *sd = &Level.Sides[Level.Sides.Reserve(1)];
-            ParseSidedef(sd);
-        } else if (SC_Compare("sector")) {
-            IntSector *sec = &Level.Sectors[Level.Sectors.Reserve(1)];
-            ParseSector(sec);
-        } else if (SC_Compare("vertex")) {
-            WideVertex *vt = &Vertices[Vertices.Reserve(1)];
-            IntVertex *vtp = &Level.VertexProps[Level.VertexProps.Reserve(1)];
-            vt->index = Vertices.Size();
-            ParseVertex(vt, vtp);
+    TextMap.reset(buffer);
+    TextMapSize = buffersize;
+
+    FUDMFScanner sc(buffer, buffersize);
+    std::string_view token;
+
+    ParseMapProperties(sc);
+
+    while (sc.GetToken(token)) {
+        switch (MatchKey(token)) {
+            case UDMF_Thing: {
+                IntThing *th = &Level.Things[Level.Things.Reserve(1)];
+                ParseThing(sc, th);
+                break;
+            }
+            case UDMF_Linedef: {
+                IntLineDef *ld = &Level.Lines[Level.Lines.Reserve(1)];
+                ParseLinedef(sc, ld);
+                break;
+            }
+            case UDMF_Sidedef: {
+                IntSideDef *sd = &Level.Sides[Level.Sides.Reserve(1)];
+                ParseSidedef(sc, sd);
+                break;
+            }
+            case UDMF_Sector: {
+                IntSector *sec = &Level.Sectors[Level.Sectors.Reserve(1)];
+                ParseSector(sc, sec);
+                break;
+            }
+            case UDMF_Vertex: {
+                WideVertex *vt = &Vertices[Vertices.Reserve(1)];
+                IntVertex *vtp =
+                    &Level.VertexProps[Level.VertexProps.Reserve(1)];
+                vt->index = Vertices.Size();
+                ParseVertex(sc, vt, vtp);
+                break;
+            }
+            default:
+                break;
         }
     }
     Level.Vertices = new WideVertex[Vertices.Size()];
     Level.NumVertices = Vertices.Size();
     memcpy(Level.Vertices, &Vertices[0], Vertices.Size() * sizeof(WideVertex));
-    SC_Close();
-    delete[] buffer;
 }
 
 //===========================================================================
@@ -341,28 +393,19 @@ void FProcessor::LoadUDMF() { ParseTextMap(Lump + 1); }
 //
 //===========================================================================
 
-void FProcessor::WriteProps(FWadWriter &out, TArray<UDMFKey> &props) {
+void FProcessor::WriteProps(udmf_writer_c &out, TArray<UDMFKey> &props) {
     for (unsigned i = 0; i < props.Size(); i++) {
-        out.AddToLump(props[i].key, (int)strlen(props[i].key));
-        out.AddToLump(" = ", 3);
-        out.AddToLump(props[i].value, (int)strlen(props[i].value));
-        out.AddToLump(";\n", 2);
+        out.Raw(props[i].key, props[i].value);
     }
 }
 
-//===========================================================================
-//
-// writes an integer property
-//
-//===========================================================================
-
-void FProcessor::WriteIntProp(FWadWriter &out, const char *key, int value) {
-    char buffer[20];
-
-    out.AddToLump(key, (int)strlen(key));
-    out.AddToLump(" = ", 3);
-    sprintf(buffer, "%d;\n", value);
-    out.AddToLump(buffer, (int)strlen(buffer));
+void FProcessor::BeginUDMFBlock(udmf_writer_c &out, const char *kind,
+                                int num) {
+    if (WriteComments) {
+        out.Begin(kind, num);
+    } else {
+        out.Begin(kind);
+    }
 }
 
 //===========================================================================
@@ -371,16 +414,10 @@ void FProcessor::WriteIntProp(FWadWriter &out, const char *key, int value) {
 //
 //===========================================================================
 
-void FProcessor::WriteThingUDMF(FWadWriter &out, IntThing *th, int num) {
-    out.AddToLump("thing", 5);
-    if (WriteComments) {
-        char buffer[32];
-        int len = sprintf(buffer, " // %d", num);
-        out.AddToLump(buffer, len);
-    }
-    out.AddToLump("\n{\n", 3);
+void FProcessor::WriteThingUDMF(udmf_writer_c &out, IntThing *th, int num) {
+    BeginUDMFBlock(out, "thing", num);
     WriteProps(out, th->props);
-    out.AddToLump("}\n\n", 3);
+    out.End();
 }
 
 //===========================================================================
@@ -389,22 +426,15 @@ void FProcessor::WriteThingUDMF(FWadWriter &out, IntThing *th, int num) {
 //
 //===========================================================================
 
-void FProcessor::WriteLinedefUDMF(FWadWriter &out, IntLineDef *ld, int num) {
-    out.AddToLump("linedef", 7);
-    if (WriteComments) {
-        char buffer[32];
-        int len = sprintf(buffer, " // %d", num);
-        out.AddToLump(buffer, len);
-    }
-    out.AddToLump("\n{\n", 3);
-    WriteIntProp(out, "v1", ld->v1);
-    WriteIntProp(out, "v2", ld->v2);
-    if (ld->sidenum[0] != NO_INDEX)
-        WriteIntProp(out, "sidefront", ld->sidenum[0]);
-    if (ld->sidenum[1] != NO_INDEX)
-        WriteIntProp(out, "sideback", ld->sidenum[1]);
+void FProcessor::WriteLinedefUDMF(udmf_writer_c &out, IntLineDef *ld,
+                                  int num) {
+    BeginUDMFBlock(out, "linedef", num);
+    out.AddInt("v1", ld->v1);
+    out.AddInt("v2", ld->v2);
+    if (ld->sidenum[0] != NO_INDEX) out.AddInt("sidefront", ld->sidenum[0]);
+    if (ld->sidenum[1] != NO_INDEX) out.AddInt("sideback", ld->sidenum[1]);
     WriteProps(out, ld->props);
-    out.AddToLump("}\n\n", 3);
+    out.End();
 }
 
 //===========================================================================
@@ -413,17 +443,12 @@ void FProcessor::WriteLinedefUDMF(FWadWriter &out, IntLineDef *ld, int num) {
 //
 //===========================================================================
 
-void FProcessor::WriteSidedefUDMF(FWadWriter &out, IntSideDef *sd, int num) {
-    out.AddToLump("sidedef", 7);
-    if (WriteComments) {
-        char buffer[32];
-        int len = sprintf(buffer, " // %d", num);
-        out.AddToLump(buffer, len);
-    }
-    out.AddToLump("\n{\n", 3);
-    WriteIntProp(out, "sector", sd->sector);
+void FProcessor::WriteSidedefUDMF(udmf_writer_c &out, IntSideDef *sd,
+                                  int num) {
+    BeginUDMFBlock(out, "sidedef", num);
+    out.AddInt("sector", sd->sector);
     WriteProps(out, sd->props);
-    out.AddToLump("}\n\n", 3);
+    out.End();
 }
 
 //===========================================================================
@@ -432,16 +457,11 @@ void FProcessor::WriteSidedefUDMF(FWadWriter &out, IntSideDef *sd, int num) {
 //
 //===========================================================================
 
-void FProcessor::WriteSectorUDMF(FWadWriter &out, IntSector *sec, int num) {
-    out.AddToLump("sector", 6);
-    if (WriteComments) {
-        char buffer[32];
-        int len = sprintf(buffer, " // %d", num);
-        out.AddToLump(buffer, len);
-    }
-    out.AddToLump("\n{\n", 3);
+void FProcessor::WriteSectorUDMF(udmf_writer_c &out, IntSector *sec,
+                                 int num) {
+    BeginUDMFBlock(out, "sector", num);
     WriteProps(out, sec->props);
-    out.AddToLump("}\n\n", 3);
+    out.End();
 }
 
 //===========================================================================
@@ -450,29 +470,29 @@ void FProcessor::WriteSectorUDMF(FWadWriter &out, IntSector *sec, int num) {
 //
 //===========================================================================
 
-void FProcessor::WriteVertexUDMF(FWadWriter &out, IntVertex *vt, int num) {
-    out.AddToLump("vertex", 6);
-    if (WriteComments) {
-        char buffer[32];
-        int len = sprintf(buffer, " // %d", num);
-        out.AddToLump(buffer, len);
-    }
-    out.AddToLump("\n{\n", 3);
+void FProcessor::WriteVertexUDMF(udmf_writer_c &out, IntVertex *vt, int num) {
+    BeginUDMFBlock(out, "vertex", num);
     WriteProps(out, vt->props);
-    out.AddToLump("}\n\n", 3);
+    out.End();
 }
 
 //===========================================================================
 //
 // writes a UDMF text map
 //
+// The whole lump is formatted in memory and written in one go. The
+// input TEXTMAP's size is a close guess for the output's, since only
+// vertices get added.
+//
 //===========================================================================
 
 void FProcessor::WriteTextMap(FWadWriter &out) {
-    out.StartWritingLump("TEXTMAP");
-    WriteProps(out, Level.props);
+    udmf_writer_c text;
+
+    text.Reserve(TextMapSize + TextMapSize / 8);
+    WriteProps(text, Level.props);
     for (int i = 0; i < Level.NumThings(); i++) {
-        WriteThingUDMF(out, &Level.Things[i], i);
+        WriteThingUDMF(text, &Level.Things[i], i);
     }
 
     for (int i = 0; i < Level.NumOrgVerts; i++) {
@@ -481,20 +501,22 @@ void FProcessor::WriteTextMap(FWadWriter &out) {
             // not valid!
             throw std::runtime_error("Invalid vertex data.");
         }
-        WriteVertexUDMF(out, &Level.VertexProps[vt->index - 1], i);
+        WriteVertexUDMF(text, &Level.VertexProps[vt->index - 1], i);
     }
 
     for (int i = 0; i < Level.NumLines(); i++) {
-        WriteLinedefUDMF(out, &Level.Lines[i], i);
+        WriteLinedefUDMF(text, &Level.Lines[i], i);
     }
 
     for (int i = 0; i < Level.NumSides(); i++) {
-        WriteSidedefUDMF(out, &Level.Sides[i], i);
+        WriteSidedefUDMF(text, &Level.Sides[i], i);
     }
 
     for (int i = 0; i < Level.NumSectors(); i++) {
-        WriteSectorUDMF(out, &Level.Sectors[i], i);
+        WriteSectorUDMF(text, &Level.Sectors[i], i);
     }
+
+    out.WriteLump("TEXTMAP", text.GetBuffer(), (int)text.GetSize());
 }
 
 //===========================================================================
@@ -0,0 +1,274 @@
+/*
+    Tokenizer for UDMF text maps.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+*/
+
+#include "udmf_scanner.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <charconv>
+#include <stdexcept>
+#include <string>
+
+static inline bool IsStopChar(char c) {
+    switch (c) {
+        case '`': case '~': case '!': case '@': case '#': case '$':
+        case '%': case '^': case '&': case '*': case '(': case ')':
+        case '{': case '}': case '[': case ']': case '/': case '=':
+        case '?': case '+': case '|': case ';': case ':': case '<':
+        case '>': case ',':
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Anything at or below space counts as whitespace, including bytes
+// with the high bit set, as they did in sc_man.
+static inline bool IsSpace(char c) { return (signed char)c <= ' '; }
+
+static inline char LowerCase(char c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+FUDMFScanner::FUDMFScanner(char *buffer, int size)
+    : Number(0), Float(0), Buffer(buffer), Ptr(buffer), End(buffer + size),
+      Line(1) {}
+
+//==========================================================================
+//
+// SkipWhitespace
+//
+// Returns false at the end of the lump.
+//
+//==========================================================================
+
+bool FUDMFScanner::SkipWhitespace() {
+    for (;;) {
+        while (Ptr < End && IsSpace(*Ptr)) {
+            if (*Ptr++ == '\n') {
+                Line++;
+            }
+        }
+        if (Ptr >= End) {
+            return false;
+        }
+        if (Ptr[0] != '/' || Ptr + 1 >= End ||
+            (Ptr[1] != '/' && Ptr[1] != '*')) {
+            return true;
+        }
+        if (Ptr[1] == '*') {
+            while (Ptr[0] != '*' || Ptr[1] != '/') {
+                if (Ptr[0] == '\n') {
+                    Line++;
+                }
+                Ptr++;
+                if (Ptr >= End - 1) {
+                    Ptr = End;
+                    return false;
+                }
+            }
+            Ptr += 2;
+        } else {
+            while (*Ptr++ != '\n') {
+                if (Ptr >= End) {
+                    return false;
+                }
+            }
+            Line++;
+        }
+    }
+}
+
+//==========================================================================
+//
+// GetToken
+//
+//==========================================================================
+
+bool FUDMFScanner::GetToken(std::string_view &token) {
+    if (!SkipWhitespace()) {
+        return false;
+    }
+
+    const char *start = Ptr;
+
+    if (*Ptr == '"') {
+        for (Ptr++; Ptr < End && *Ptr != '"'; Ptr++) {
+            if (*Ptr == '\\' && Ptr + 1 < End) {
+                Ptr++;
+            }
+        }
+        if (Ptr >= End) {
+            ScriptError("Unterminated string.");
+        }
+        Ptr++;
+    } else if (IsStopChar(*Ptr)) {
+        Ptr++;
+    } else {
+        // '-' is not a stop character, so negative numbers come out whole
+        do {
+            Ptr++;
+        } while (Ptr < End && !IsSpace(*Ptr) && !IsStopChar(*Ptr));
+    }
+    token = std::string_view(start, Ptr - start);
+    return true;
+}
+
+std::string_view FUDMFScanner::MustGetToken() {
+    std::string_view token;
+
+    if (!GetToken(token)) {
+        ScriptError("Missing string (unexpected end of file).");
+    }
+    return token;
+}
+
+void FUDMFScanner::MustGetToken(char punct) {
+    std::string_view token = MustGetToken();
+
+    if (token.size() != 1 || token[0] != punct) {
+        ScriptError("Expected '%c', got '%.*s'.", punct, (int)token.size(),
+                    token.data());
+    }
+}
+
+//==========================================================================
+//
+// CheckToken
+//
+// Punctuation is always a token by itself, so there is no need to scan
+// a whole token to see whether it's the one we want.
+//
+//==========================================================================
+
+bool FUDMFScanner::CheckToken(char punct) {
+    if (SkipWhitespace() && *Ptr == punct) {
+        Ptr++;
+        return true;
+    }
+    return false;
+}
+
+//==========================================================================
+//
+// ParseNumber
+//
+// Converts a decimal or hex (0x) number.  Like sc_man's SC_GetFloat,
+// anything which isn't entirely a number is an error.
+//
+//==========================================================================
+
+void FUDMFScanner::ParseNumber(std::string_view token) {
+    const char *p = token.data();
+    const char *end = p + token.size();
+    const char *digits = (p < end && *p == '-') ? p + 1 : p;
+    std::from_chars_result result;
+    double val = 0;
+
+    if (end - digits > 2 && digits[0] == '0' && LowerCase(digits[1]) == 'x') {
+        // from_chars doesn't take the 0x prefix itself
+        result = std::from_chars(digits + 2, end, val, std::chars_format::hex);
+        if (p != digits) {
+            val = -val;
+        }
+    } else {
+        result = std::from_chars(p, end, val);
+    }
+
+    if (result.ec == std::errc::invalid_argument || result.ptr != end) {
+        ScriptError("Bad numeric constant \"%.*s\".", (int)token.size(),
+                    token.data());
+    }
+    if (result.ec == std::errc::result_out_of_range) {
+        val = strtod(std::string(token).c_str(), NULL);
+    }
+    Float = val;
+    Number = (int)val;
+}
+
+//==========================================================================
+//
+// Terminate
+//
+// Writes a terminator over the character following the token, which
+// must already have been scanned past, and strips control characters
+// out of quoted strings.
+//
+//==========================================================================
+
+const char *FUDMFScanner::Terminate(std::string_view token) {
+    char *start = Buffer + (token.data() - Buffer);
+    char *end = start + token.size();
+
+    if (*start == '"') {
+        char *out = start + 1;
+        for (char *in = start + 1; in < end - 1; in++) {
+            if (*in >= 0 && *in < ' ') {
+                continue;
+            }
+            if (*in == '\\') {
+                *out++ = *in++;
+            }
+            *out++ = *in;
+        }
+        *out++ = '"';
+        end = out;
+    }
+    *end = 0;
+    return start;
+}
+
+//==========================================================================
+//
+// Compare
+//
+//==========================================================================
+
+bool FUDMFScanner::Compare(std::string_view token, const char *text) {
+    size_t i;
+
+    for (i = 0; i < token.size(); i++) {
+        if (text[i] == 0 || LowerCase(token[i]) != LowerCase(text[i])) {
+            return false;
+        }
+    }
+    return text[i] == 0;
+}
+
+//==========================================================================
+//
+// ScriptError
+//
+//==========================================================================
+
+void FUDMFScanner::ScriptError(const char *message, ...) const {
+    char composed[2048];
+    char full[2100];
+
+    va_list arglist;
+    va_start(arglist, message);
+    vsnprintf(composed, sizeof(composed), message, arglist);
+    va_end(arglist);
+
+    snprintf(full, sizeof(full), "Script error, line %d:\n%s", Line,
+             composed);
+    throw std::runtime_error(full);
+}
@@ -0,0 +1,61 @@
+#ifndef __UDMF_SCANNER_H__
+#define __UDMF_SCANNER_H__
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#include <string_view>
+
+// Tokenizer for TEXTMAP lumps. Tokens are views into the lump buffer
+// rather than copies; Terminate() turns one into a C string in place
+// once everything after it has been scanned, so the buffer has to stay
+// alive for as long as those strings are used.
+//
+// Tokenizing follows sc_man's C mode, which ZDBSP used for UDMF
+// before: quoted strings keep their quotes and backslash escapes but
+// lose control characters, and each of the stop characters below is a
+// token on its own.
+class FUDMFScanner {
+   public:
+    struct FPos {
+        const char *Ptr;
+        int Line;
+    };
+
+    FUDMFScanner(char *buffer, int size);
+
+    bool GetToken(std::string_view &token);
+    std::string_view MustGetToken();
+    void MustGetToken(char punct);
+    bool CheckToken(char punct);
+
+    // Parses a value token the way strtod would, leaving the result in
+    // Float and Number.
+    void ParseNumber(std::string_view token);
+
+    const char *Terminate(std::string_view token);
+
+    FPos SavePos() const { return {Ptr, Line}; }
+    void RestorePos(const FPos &pos) {
+        Ptr = pos.Ptr;
+        Line = pos.Line;
+    }
+
+    [[noreturn]] void ScriptError(const char *message, ...) const;
+
+    static bool Compare(std::string_view token, const char *text);
+
+    int Number;
+    double Float;
+
+   private:
+    bool SkipWhitespace();
+
+    char *Buffer;
+    const char *Ptr;
+    const char *End;
+    int Line;
+};
+
+#endif  //__UDMF_SCANNER_H__
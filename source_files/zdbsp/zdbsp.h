@@ -38,6 +38,7 @@ extern ERejectMode RejectMode;
 extern int MaxSegs;
 extern int SplitCost;
 extern int AAPreference;
+extern int PartitionHintGrid;
 extern bool CheckPolyobjs;
 extern bool ShowMap;
 extern bool CompressNodes, CompressGLNodes, ForceCompression, V5GLNodes;
@@ -59,6 +59,7 @@
 #include <string.h>
 #include <filesystem>
 
+#include "nodecache.h"
 #include "processor.h"
 #include "zdwad.h"
 #include "zdbsp.h"
@@ -75,6 +76,9 @@
 #define M_PI 3.14159265358979323846
 #endif
 
+// Maps built with the cache on are kept until it grows past this
+#define NODE_CACHE_SIZE (256u << 20)
+
 // TYPES -------------------------------------------------------------------
 
 // EXTERNAL FUNCTION PROTOTYPES --------------------------------------------
@@ -99,6 +103,7 @@ bool WriteComments = false;
 int MaxSegs = 64;
 int SplitCost = 8;
 int AAPreference = 16;
+int PartitionHintGrid = 0;
 bool CheckPolyobjs = true;
 bool ShowMap = false;
 bool ShowWarnings = true;
@@ -113,7 +118,7 @@ extern UI_MainWin *main_win;
 
 // CODE --------------------------------------------------------------------
 
-int zdmain(std::filesystem::path filename, std::string current_engine, bool UDMF_mode, bool build_reject, int num_maps) {
+int zdmain(std::filesystem::path filename, std::string current_engine, bool UDMF_mode, bool build_reject, int num_maps, int hint_grid, std::filesystem::path cache_dir) {
 
     int node_progress = 0;
     if (main_win) { 
@@ -176,6 +181,10 @@ int zdmain(std::filesystem::path filename, std::string current_engine, bool UDMF
             ForceCompression = true;
         }
 
+    // Split along these grid lines first; 0 means search every level of
+    // the tree as normal
+    PartitionHintGrid = hint_grid;
+
     ShowVersion();
 
     try {
@@ -184,6 +193,7 @@ int zdmain(std::filesystem::path filename, std::string current_engine, bool UDMF
         if (std::filesystem::exists(OutName)) { std::filesystem::remove(OutName); }
         FWadReader inwad(filename);
         FWadWriter outwad(OutName, inwad.IsIWAD());
+        FNodeCache cache(cache_dir, NODE_CACHE_SIZE);
 
         int lump = 0;
         int max = inwad.NumLumps();
@@ -193,8 +203,15 @@ int zdmain(std::filesystem::path filename, std::string current_engine, bool UDMF
                 (!Map || strcasecmp(inwad.LumpName(lump), Map) == 0)) {
                 if (main_win) main_win->build_box->AddStatusStep(inwad.LumpName(lump));
                 START_COUNTER(t2a, t2b, t2c)
-                FProcessor builder(inwad, lump);
-                builder.Write(outwad);
+                uint64_t key = cache.IsEnabled() ? cache.MakeKey(inwad, lump) : 0;
+                if (cache.Fetch(key, outwad)) {
+                    printf("   Using cached nodes.\n");
+                } else {
+                    FProcessor builder(inwad, lump);
+                    if (!cache.Store(key, builder, outwad)) {
+                        builder.Write(outwad);
+                    }
+                }
                 END_COUNTER(t2a, t2b, t2c, "   %.3f seconds.\n")
                 node_progress += 1;
                 if (main_win) main_win->build_box->Prog_Nodes(node_progress, num_maps);
@@ -1,2 +1,2 @@
 
-int zdmain(std::filesystem::path filename, std::string current_engine, bool UDMF_mode, bool build_reject, int num_maps);
+int zdmain(std::filesystem::path filename, std::string current_engine, bool UDMF_mode, bool build_reject, int num_maps, int hint_grid, std::filesystem::path cache_dir);